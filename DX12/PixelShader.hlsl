@@ -3,10 +3,16 @@ struct VSOutput
 	float2 pTexture    : P_TEXTURECOORD;
 };
 
-Texture2D t1 : register(t0);
+// Bindless index of the material's texture.
+cbuffer MaterialCB : register(b1)
+{
+	uint TextureIndex;
+};
+
+Texture2D textures[] : register(t0);
 SamplerState s1 : register(s0);
 
 float4 main(VSOutput IN) : SV_Target
 {
-	return t1.Sample(s1, IN.pTexture);
+	return textures[TextureIndex].Sample(s1, IN.pTexture);
 }
\ No newline at end of file
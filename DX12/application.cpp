@@ -2,6 +2,15 @@
 #include <window.h>
 #include <game.h>
 #include <command_queue.h>
+#include <gpu_memory_tracker.h>
+#include <heap_allocator.h>
+#include <d3d12_pipeline_cache_device.h>
+#include <pipeline_cache.h>
+#include <pipeline_compiler.h>
+#include <residency_manager.h>
+#include <shader_archive.h>
+#include <texture_allocator.h>
+#include <upload_manager.h>
 #include <helpers.h>
 #include <events.h>
 #include <defines.h>
@@ -109,6 +118,35 @@ Application::Application(HINSTANCE arg_h_inst)
 		compute_command_queue_ = std::make_shared<CommandQueue>(d3d12_device_, D3D12_COMMAND_LIST_TYPE_COMPUTE);
 		copy_command_queue_ = std::make_shared<CommandQueue>(d3d12_device_, D3D12_COMMAND_LIST_TYPE_COPY);
 
+		gpu_memory_tracker_ = std::make_unique<GpuMemoryTracker>();
+		for (int i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i)
+		{
+			descriptor_allocators_[i] = std::make_unique<DescriptorAllocator>(d3d12_device_, static_cast<D3D12_DESCRIPTOR_HEAP_TYPE>(i),
+																			   256, gpu_memory_tracker_.get());
+		}
+		residency_manager_ = std::make_unique<ResidencyManager>(std::make_shared<D3D12ResidencyDevice>(d3d12_device_, dxgi_adapter_));
+
+		auto heap_allocator_device = std::make_shared<D3D12HeapAllocatorDevice>(d3d12_device_);
+		heap_allocator_ = std::make_unique<HeapAllocator>(heap_allocator_device, D3D12_HEAP_TYPE_DEFAULT, 64 * 1024 * 1024,
+														  residency_manager_.get(), gpu_memory_tracker_.get());
+		texture_allocator_ = std::make_unique<TextureAllocator>(heap_allocator_device, 10, residency_manager_.get(),
+																gpu_memory_tracker_.get());
+		upload_manager_ = std::make_unique<UploadManager>(d3d12_device_, copy_command_queue_, 64 * 1024 * 1024,
+														  gpu_memory_tracker_.get());
+
+		// Repack the compiled shaders when the build produced newer ones.
+		if (ShaderArchiveWriter::IsOutOfDate(L"shaders.pak", L"*.cso"))
+		{
+			ShaderArchiveWriter shader_archive_writer;
+			shader_archive_writer.AddFiles(L"*.cso");
+			shader_archive_writer.Write(L"shaders.pak");
+		}
+		shader_archive_ = std::make_unique<ShaderArchive>(L"shaders.pak");
+
+		pipeline_cache_ = std::make_unique<PipelineCache>(std::make_shared<D3D12PipelineCacheDevice>(d3d12_device_, dxgi_adapter_),
+														  "pipeline_cache.bin");
+		pipeline_compiler_ = std::make_unique<PipelineCompiler>(*pipeline_cache_);
+
 		tearing_supported_ = CheckTearingSupport();
 	}
 }
@@ -116,6 +154,26 @@ Application::Application(HINSTANCE arg_h_inst)
 Application::~Application()
 {
 	Flush();
+
+	// Release the application's own tracked objects first, in the reverse order of creation, so
+	// the allocators still find the residency manager and the tracker when they are destroyed.
+	pipeline_compiler_.reset();
+	pipeline_cache_.reset();
+	shader_archive_.reset();
+	upload_manager_.reset();
+	texture_allocator_.reset();
+	heap_allocator_.reset();
+	residency_manager_.reset();
+	for (std::unique_ptr<DescriptorAllocator>& descriptor_allocator : descriptor_allocators_)
+	{
+		descriptor_allocator.reset();
+	}
+
+	// Everything still registered was not released by the game or the windows.
+	if (gpu_memory_tracker_)
+	{
+		OutputDebugStringA(gpu_memory_tracker_->GetLeakReport().c_str());
+	}
 }
 
 Microsoft::WRL::ComPtr<IDXGIAdapter4> Application::GetAdapter(bool bUseWarp)
@@ -354,6 +412,46 @@ void Application::Flush()
 	copy_command_queue_->Flush();
 }
 
+HeapAllocator& Application::GetHeapAllocator() const
+{
+	return *heap_allocator_;
+}
+
+TextureAllocator& Application::GetTextureAllocator() const
+{
+	return *texture_allocator_;
+}
+
+GpuMemoryTracker& Application::GetGpuMemoryTracker() const
+{
+	return *gpu_memory_tracker_;
+}
+
+ResidencyManager& Application::GetResidencyManager() const
+{
+	return *residency_manager_;
+}
+
+UploadManager& Application::GetUploadManager() const
+{
+	return *upload_manager_;
+}
+
+PipelineCache& Application::GetPipelineCache() const
+{
+	return *pipeline_cache_;
+}
+
+PipelineCompiler& Application::GetPipelineCompiler() const
+{
+	return *pipeline_compiler_;
+}
+
+ShaderArchive& Application::GetShaderArchive() const
+{
+	return *shader_archive_;
+}
+
 Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> Application::CreateDescriptorHeap(UINT arg_num_descriptors, D3D12_DESCRIPTOR_HEAP_TYPE arg_type)
 {
 	D3D12_DESCRIPTOR_HEAP_DESC desc = { };
@@ -368,6 +466,24 @@ Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> Application::CreateDescriptorHeap(U
 	return descriptorHeap;
 }
 
+DescriptorAllocation Application::AllocateDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE arg_type, uint32_t arg_num_descriptors)
+{
+	return descriptor_allocators_[arg_type]->Allocate(arg_num_descriptors);
+}
+
+DescriptorAllocator& Application::GetDescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE arg_type) const
+{
+	return *descriptor_allocators_[arg_type];
+}
+
+void Application::ReleaseStaleDescriptors(uint64_t arg_completed_fence_value)
+{
+	for (int i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i)
+	{
+		descriptor_allocators_[i]->ReleaseStaleDescriptors(arg_completed_fence_value);
+	}
+}
+
 UINT Application::GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE arg_type) const
 {
 	return d3d12_device_->GetDescriptorHandleIncrementSize(arg_type);
@@ -3,6 +3,8 @@
 */
 #pragma once
 
+#include <descriptor_allocator.h>
+
 #include <d3d12.h>
 #include <dxgi1_6.h>
 #include <wrl.h>
@@ -13,6 +15,14 @@
 class Window;
 class Game;
 class CommandQueue;
+class GpuMemoryTracker;
+class HeapAllocator;
+class PipelineCache;
+class PipelineCompiler;
+class ResidencyManager;
+class ShaderArchive;
+class TextureAllocator;
+class UploadManager;
 
 class Application
 {
@@ -82,7 +92,61 @@ public:
 	// Flush all command queues.
 	void Flush();
 
+	/**
+	* Get the allocator that places default heap resources in shared heaps.
+	*/
+	HeapAllocator& GetHeapAllocator() const;
+
+	/**
+	* Get the buddy allocator that places (non render target) textures.
+	*/
+	TextureAllocator& GetTextureAllocator() const;
+
+	/**
+	* Get the tracker that every resource and descriptor heap is registered with.
+	*/
+	GpuMemoryTracker& GetGpuMemoryTracker() const;
+
+	/**
+	* Get the residency manager that keeps the allocators' heaps within the video memory budget.
+	* Objects are marked used with the fence value of the queue that used them.
+	*/
+	ResidencyManager& GetResidencyManager() const;
+
+	/**
+	* Get the upload manager that batches uploads onto the copy queue.
+	*/
+	UploadManager& GetUploadManager() const;
+
+	/**
+	* Get the cache of root signatures and pipeline states. Compiled pipelines are stored on disk for the next launch.
+	*/
+	PipelineCache& GetPipelineCache() const;
+
+	/**
+	* Get the compiler that creates pipeline states of the pipeline cache on worker threads.
+	*/
+	PipelineCompiler& GetPipelineCompiler() const;
+
+	/**
+	* Get the archive of compiled shaders. Its bytecode stays valid for the lifetime of the application.
+	*/
+	ShaderArchive& GetShaderArchive() const;
+
 	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> CreateDescriptorHeap(UINT arg_num_descriptors, D3D12_DESCRIPTOR_HEAP_TYPE arg_type);
+
+	/**
+	* Allocate a contiguous range of CPU visible descriptors from the paged descriptor allocators.
+	* Free them with GetDescriptorAllocator(type).Free.
+	*/
+	DescriptorAllocation AllocateDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE arg_type, uint32_t arg_num_descriptors = 1);
+	DescriptorAllocator& GetDescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE arg_type) const;
+
+	/**
+	* Return freed descriptors to their allocators once the direct queue has passed the fence value
+	* they were freed with.
+	*/
+	void ReleaseStaleDescriptors(uint64_t arg_completed_fence_value);
 	UINT GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE arg_type) const;
 
 protected:
@@ -105,6 +169,16 @@ private:
 	std::shared_ptr<CommandQueue> compute_command_queue_;
 	std::shared_ptr<CommandQueue> copy_command_queue_;
 
+	std::unique_ptr<GpuMemoryTracker> gpu_memory_tracker_;
+	std::unique_ptr<DescriptorAllocator> descriptor_allocators_[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
+	std::unique_ptr<ResidencyManager> residency_manager_;
+	std::unique_ptr<HeapAllocator> heap_allocator_;
+	std::unique_ptr<TextureAllocator> texture_allocator_;
+	std::unique_ptr<UploadManager> upload_manager_;
+	std::unique_ptr<ShaderArchive> shader_archive_;
+	std::unique_ptr<PipelineCache> pipeline_cache_;
+	std::unique_ptr<PipelineCompiler> pipeline_compiler_;
+
 	bool tearing_supported_;
 
 };
\ No newline at end of file
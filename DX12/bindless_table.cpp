@@ -0,0 +1,123 @@
+#include <bindless_table.h>
+#include <helpers.h>
+
+#include <cassert>
+
+BindlessTable::BindlessTable(Microsoft::WRL::ComPtr<ID3D12Device2> arg_device, uint32_t arg_capacity)
+	: d3d12_device_(arg_device)
+	, descriptor_size_(arg_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV))
+	, capacity_(arg_capacity)
+	, generations_(arg_capacity, 0)
+{
+	assert(arg_capacity > 0 && "The bindless table must not be empty.");
+
+	D3D12_DESCRIPTOR_HEAP_DESC desc = { };
+	desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+	desc.NumDescriptors = arg_capacity;
+	desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+	ThrowIfFailed(d3d12_device_->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&heap_)));
+
+	cpu_base_ = heap_->GetCPUDescriptorHandleForHeapStart();
+	gpu_base_ = heap_->GetGPUDescriptorHandleForHeapStart();
+
+	// Hand out the lowest indices first.
+	free_slots_.reserve(arg_capacity);
+	for (uint32_t i = arg_capacity; i > 0; --i)
+	{
+		free_slots_.push_back(i - 1);
+	}
+}
+
+BindlessTable::~BindlessTable()
+{ }
+
+ID3D12DescriptorHeap* BindlessTable::GetHeap() const
+{
+	return heap_.Get();
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE BindlessTable::GetTableStart() const
+{
+	return gpu_base_;
+}
+
+uint32_t BindlessTable::GetCapacity() const
+{
+	return capacity_;
+}
+
+BindlessHandle BindlessTable::Allocate(D3D12_CPU_DESCRIPTOR_HANDLE arg_view)
+{
+	if (free_slots_.empty())
+	{
+		ThrowIfFailed(E_OUTOFMEMORY);
+	}
+
+	BindlessHandle handle;
+	handle.index = free_slots_.back();
+	handle.generation = generations_[handle.index];
+	free_slots_.pop_back();
+
+	d3d12_device_->CopyDescriptorsSimple(1, GetSlotHandle(handle.index), arg_view, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+	return handle;
+}
+
+void BindlessTable::Update(const BindlessHandle& arg_handle, D3D12_CPU_DESCRIPTOR_HANDLE arg_view)
+{
+	assert(IsValid(arg_handle) && "Stale bindless handle.");
+
+	// The GPU may still read the slot, so the caller must not update it while a submission that uses the old view is in flight.
+	d3d12_device_->CopyDescriptorsSimple(1, GetSlotHandle(arg_handle.index), arg_view, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+}
+
+void BindlessTable::Free(BindlessHandle& arg_handle, uint64_t arg_fence_value)
+{
+	if (arg_handle.IsNull())
+	{
+		return;
+	}
+
+	assert(IsValid(arg_handle) && "Stale bindless handle.");
+
+	++generations_[arg_handle.index];
+	stale_slots_.push_back(StaleSlot{arg_fence_value, arg_handle.index});
+	arg_handle = BindlessHandle();
+}
+
+void BindlessTable::ReleaseStaleSlots(uint64_t arg_completed_fence_value)
+{
+	// Slots are freed in submission order, so the oldest fence values are at the front.
+	while (!stale_slots_.empty() && stale_slots_.front().fence_value <= arg_completed_fence_value)
+	{
+		free_slots_.push_back(stale_slots_.front().index);
+		stale_slots_.pop_front();
+	}
+}
+
+bool BindlessTable::IsValid(const BindlessHandle& arg_handle) const
+{
+	return arg_handle.index < capacity_ && generations_[arg_handle.index] == arg_handle.generation;
+}
+
+uint32_t BindlessTable::GetIndex(const BindlessHandle& arg_handle) const
+{
+	assert(IsValid(arg_handle) && "Stale bindless handle.");
+
+	return arg_handle.index;
+}
+
+BindlessTable::Stats BindlessTable::GetStats() const
+{
+	Stats stats = { };
+	stats.capacity = capacity_;
+	stats.stale_count = static_cast<uint32_t>(stale_slots_.size());
+	stats.used_count = capacity_ - static_cast<uint32_t>(free_slots_.size()) - stats.stale_count;
+
+	return stats;
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE BindlessTable::GetSlotHandle(uint32_t arg_index) const
+{
+	return D3D12_CPU_DESCRIPTOR_HANDLE{ cpu_base_.ptr + SIZE_T(arg_index) * descriptor_size_ };
+}
@@ -0,0 +1,97 @@
+/**
+* The bindless table is one large shader-visible CBV/SRV/UAV table. Every texture and buffer view
+* placed in it keeps a stable index for its lifetime, which shaders use to index the table, so
+* the table is bound once per frame and switching materials does not rebind descriptor tables.
+* Handles carry the generation of their slot, so handles to freed views can be detected. Freed
+* slots are reused once the fence value of the last submission that used them has completed.
+*/
+#pragma once
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// A view in the bindless table. The index is what shaders use to index the table.
+struct BindlessHandle
+{
+	uint32_t index = ~0u;
+	uint32_t generation = 0;
+
+	bool IsNull() const { return index == ~0u; }
+};
+
+class BindlessTable
+{
+public:
+	struct Stats
+	{
+		uint32_t capacity;
+		uint32_t used_count;
+		uint32_t stale_count; // Freed, waiting for their fence value.
+	};
+
+	/**
+	* @param arg_capacity The number of views in the table.
+	*/
+	BindlessTable(Microsoft::WRL::ComPtr<ID3D12Device2> arg_device, uint32_t arg_capacity);
+	virtual ~BindlessTable();
+
+	// The shader-visible heap to bind with SetDescriptorHeaps.
+	ID3D12DescriptorHeap* GetHeap() const;
+	// The GPU handle of the table, for SetGraphicsRootDescriptorTable.
+	D3D12_GPU_DESCRIPTOR_HANDLE GetTableStart() const;
+	uint32_t GetCapacity() const;
+
+	/**
+	* Copy a view from a CPU descriptor heap into a free slot of the table.
+	* Throws if the table is full.
+	*/
+	BindlessHandle Allocate(D3D12_CPU_DESCRIPTOR_HANDLE arg_view);
+
+	// Replace the view of a slot, e.g. after its resource was recreated. The index stays the same.
+	void Update(const BindlessHandle& arg_handle, D3D12_CPU_DESCRIPTOR_HANDLE arg_view);
+
+	/**
+	* Free a slot once the submission with the fence value has finished. The handle is reset, and
+	* all copies of it are stale immediately.
+	* @param arg_fence_value Fence value of the direct queue.
+	*/
+	void Free(BindlessHandle& arg_handle, uint64_t arg_fence_value);
+
+	// Make the freed slots whose fence value has completed available again.
+	void ReleaseStaleSlots(uint64_t arg_completed_fence_value);
+
+	// Whether the handle refers to the current view of its slot.
+	bool IsValid(const BindlessHandle& arg_handle) const;
+
+	// Get the index of a valid handle for shaders.
+	uint32_t GetIndex(const BindlessHandle& arg_handle) const;
+
+	Stats GetStats() const;
+
+private:
+	struct StaleSlot
+	{
+		uint64_t fence_value;
+		uint32_t index;
+	};
+
+	D3D12_CPU_DESCRIPTOR_HANDLE GetSlotHandle(uint32_t arg_index) const;
+
+	Microsoft::WRL::ComPtr<ID3D12Device2> d3d12_device_;
+	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> heap_;
+	D3D12_CPU_DESCRIPTOR_HANDLE cpu_base_;
+	D3D12_GPU_DESCRIPTOR_HANDLE gpu_base_;
+	uint32_t descriptor_size_;
+	uint32_t capacity_;
+
+	// Generation of every slot, incremented when the slot is freed.
+	std::vector<uint32_t> generations_;
+	// Slots that can be allocated, the most recently released at the back.
+	std::vector<uint32_t> free_slots_;
+	// Slots waiting for their fence value, oldest first.
+	std::deque<StaleSlot> stale_slots_;
+};
@@ -0,0 +1,1079 @@
+#include <block_compressor.h>
+#include <helpers.h>
+#include <parallel_for.h>
+
+#include <emmintrin.h>
+
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	// Blocks per chunk of work, so threads are not started for a handful of blocks.
+	constexpr uint32_t BLOCKS_PER_CHUNK = 64;
+
+	constexpr uint16_t ALL_PIXELS = 0xFFFF;
+
+	// The number of two-subset partitions BC7 mode 1 encodes fully, out of the best estimates.
+	constexpr uint32_t BC7_PARTITION_CANDIDATES = 4;
+
+	const float RGB_WEIGHTS[4] = { 1.0f, 1.0f, 1.0f, 0.0f };
+	const float RGBA_WEIGHTS[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+	// Interpolation weights of the BC7 palettes, out of 64.
+	const uint32_t BC7_WEIGHTS_3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+	const uint32_t BC7_WEIGHTS_4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	// The pixels of the second subset of the BC7 two-subset partitions, bit i for pixel i.
+	const uint16_t BC7_PARTITIONS_2[64] = {
+		0xcccc, 0x8888, 0xeeee, 0xecc8, 0xc880, 0xfeec, 0xfec8, 0xec80,
+		0xc800, 0xffec, 0xfe80, 0xe800, 0xffe8, 0xff00, 0xfff0, 0xf000,
+		0xf710, 0x008e, 0x7100, 0x08ce, 0x008c, 0x7310, 0x3100, 0x8cce,
+		0x088c, 0x3110, 0x6666, 0x366c, 0x17e8, 0x0ff0, 0x718e, 0x399c,
+		0xaaaa, 0xf0f0, 0x5a5a, 0x33cc, 0x3c3c, 0x55aa, 0x9696, 0xa55a,
+		0x73ce, 0x13c8, 0x324c, 0x3bdc, 0x6996, 0xc33c, 0x9966, 0x0660,
+		0x0272, 0x04e4, 0x4e40, 0x2720, 0xc936, 0x936c, 0x39c6, 0x639c,
+		0x9336, 0x9cc6, 0x817e, 0xe718, 0xccf0, 0x0fcc, 0x7744, 0xee22
+	};
+
+	// The anchor pixel of the second subset of each partition. Its index has an implicit 0 high bit.
+	const uint8_t BC7_ANCHORS_2[64] = {
+		15, 15, 15, 15, 15, 15, 15, 15,
+		15, 15, 15, 15, 15, 15, 15, 15,
+		15, 2, 8, 2, 2, 8, 8, 15,
+		2, 8, 2, 2, 8, 8, 2, 2,
+		15, 15, 6, 8, 2, 8, 15, 15,
+		2, 8, 2, 2, 2, 15, 15, 6,
+		6, 2, 6, 8, 15, 15, 2, 2,
+		15, 15, 15, 15, 15, 2, 2, 15
+	};
+
+	// The pixels of a 4x4 block stored per channel, so four pixels fit an SSE register.
+	struct BlockPixels
+	{
+		alignas(16) float channels[4][16];
+	};
+
+	float Clamp(float arg_value, float arg_min, float arg_max)
+	{
+		return arg_value < arg_min ? arg_min : (arg_value > arg_max ? arg_max : arg_value);
+	}
+
+	uint32_t Quantize(float arg_value, uint32_t arg_max)
+	{
+		return static_cast<uint32_t>(Clamp(arg_value, 0.0f, float(arg_max)) + 0.5f);
+	}
+
+	void LoadBlock(const uint8_t* arg_pixels, uint32_t arg_width, uint32_t arg_height, uint32_t arg_row_pitch,
+				   uint32_t arg_block_x, uint32_t arg_block_y, BlockPixels& arg_block)
+	{
+		for (uint32_t y = 0; y < 4; ++y)
+		{
+			uint32_t source_y = arg_block_y * 4 + y < arg_height ? arg_block_y * 4 + y : arg_height - 1;
+			for (uint32_t x = 0; x < 4; ++x)
+			{
+				uint32_t source_x = arg_block_x * 4 + x < arg_width ? arg_block_x * 4 + x : arg_width - 1;
+				const uint8_t* pixel = arg_pixels + size_t(source_y) * arg_row_pitch + size_t(source_x) * 4;
+				for (uint32_t channel = 0; channel < 4; ++channel)
+				{
+					arg_block.channels[channel][y * 4 + x] = pixel[channel];
+				}
+			}
+		}
+	}
+
+	/**
+	* Find the nearest palette entry of each pixel in the mask, and return the summed squared error.
+	* Four pixels are compared with an entry at a time. Indices of pixels outside the mask are not written.
+	*/
+	float SelectIndices(const BlockPixels& arg_block, uint16_t arg_mask, const float arg_channel_weights[4],
+						const float (*arg_palette)[4], uint32_t arg_palette_size, uint8_t arg_indices[16])
+	{
+		float total_error = 0.0f;
+
+		for (uint32_t group = 0; group < 4; ++group)
+		{
+			if (((arg_mask >> (group * 4)) & 0xF) == 0)
+			{
+				continue;
+			}
+
+			__m128 pixels[4];
+			for (uint32_t channel = 0; channel < 4; ++channel)
+			{
+				pixels[channel] = _mm_load_ps(&arg_block.channels[channel][group * 4]);
+			}
+
+			__m128 best_error = _mm_set1_ps(FLT_MAX);
+			__m128i best_index = _mm_setzero_si128();
+			for (uint32_t entry = 0; entry < arg_palette_size; ++entry)
+			{
+				__m128 error = _mm_setzero_ps();
+				for (uint32_t channel = 0; channel < 4; ++channel)
+				{
+					if (arg_channel_weights[channel] != 0.0f)
+					{
+						__m128 difference = _mm_sub_ps(pixels[channel], _mm_set1_ps(arg_palette[entry][channel]));
+						error = _mm_add_ps(error, _mm_mul_ps(_mm_mul_ps(difference, difference), _mm_set1_ps(arg_channel_weights[channel])));
+					}
+				}
+
+				// Keep the first of equally close entries.
+				__m128i closer = _mm_castps_si128(_mm_cmplt_ps(error, best_error));
+				best_error = _mm_min_ps(error, best_error);
+				best_index = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(int(entry))), _mm_andnot_si128(closer, best_index));
+			}
+
+			alignas(16) float errors[4];
+			alignas(16) int32_t indices[4];
+			_mm_store_ps(errors, best_error);
+			_mm_store_si128(reinterpret_cast<__m128i*>(indices), best_index);
+			for (uint32_t i = 0; i < 4; ++i)
+			{
+				uint32_t pixel = group * 4 + i;
+				if (arg_mask & (1 << pixel))
+				{
+					arg_indices[pixel] = static_cast<uint8_t>(indices[i]);
+					total_error += errors[i];
+				}
+			}
+		}
+
+		return total_error;
+	}
+
+	// The mean and the principal axis of the pixels in the mask, over the first arg_channel_count channels.
+	void ComputePrincipalAxis(const BlockPixels& arg_block, uint16_t arg_mask, uint32_t arg_channel_count, float arg_mean[4], float arg_axis[4])
+	{
+		float count = 0.0f;
+		for (uint32_t channel = 0; channel < 4; ++channel)
+		{
+			arg_mean[channel] = 0.0f;
+		}
+		for (uint32_t pixel = 0; pixel < 16; ++pixel)
+		{
+			if (arg_mask & (1 << pixel))
+			{
+				count += 1.0f;
+				for (uint32_t channel = 0; channel < arg_channel_count; ++channel)
+				{
+					arg_mean[channel] += arg_block.channels[channel][pixel];
+				}
+			}
+		}
+		for (uint32_t channel = 0; channel < arg_channel_count; ++channel)
+		{
+			arg_mean[channel] /= count;
+		}
+
+		float covariance[4][4] = { };
+		for (uint32_t pixel = 0; pixel < 16; ++pixel)
+		{
+			if (arg_mask & (1 << pixel))
+			{
+				for (uint32_t i = 0; i < arg_channel_count; ++i)
+				{
+					for (uint32_t j = 0; j < arg_channel_count; ++j)
+					{
+						covariance[i][j] += (arg_block.channels[i][pixel] - arg_mean[i]) * (arg_block.channels[j][pixel] - arg_mean[j]);
+					}
+				}
+			}
+		}
+
+		// Power iteration, starting from the covariance row of the channel that varies most. The diagonal
+		// of the bounding box would be orthogonal to the axis when two channels fall as much as they rise.
+		uint32_t widest_channel = 0;
+		for (uint32_t channel = 1; channel < arg_channel_count; ++channel)
+		{
+			widest_channel = covariance[channel][channel] > covariance[widest_channel][widest_channel] ? channel : widest_channel;
+		}
+		for (uint32_t channel = 0; channel < 4; ++channel)
+		{
+			arg_axis[channel] = channel < arg_channel_count ? covariance[widest_channel][channel] : 0.0f;
+		}
+		if (covariance[widest_channel][widest_channel] == 0.0f)
+		{
+			for (uint32_t channel = 0; channel < arg_channel_count; ++channel)
+			{
+				arg_axis[channel] = 1.0f;
+			}
+		}
+
+		for (uint32_t iteration = 0; iteration < 8; ++iteration)
+		{
+			float next[4] = { };
+			float largest = 0.0f;
+			for (uint32_t i = 0; i < arg_channel_count; ++i)
+			{
+				for (uint32_t j = 0; j < arg_channel_count; ++j)
+				{
+					next[i] += covariance[i][j] * arg_axis[j];
+				}
+				largest = fabsf(next[i]) > largest ? fabsf(next[i]) : largest;
+			}
+			if (largest == 0.0f)
+			{
+				break;
+			}
+			for (uint32_t i = 0; i < arg_channel_count; ++i)
+			{
+				arg_axis[i] = next[i] / largest;
+			}
+		}
+
+		float length = 0.0f;
+		for (uint32_t channel = 0; channel < arg_channel_count; ++channel)
+		{
+			length += arg_axis[channel] * arg_axis[channel];
+		}
+		length = sqrtf(length);
+		for (uint32_t channel = 0; channel < arg_channel_count; ++channel)
+		{
+			arg_axis[channel] /= length;
+		}
+	}
+
+	// The squared distance of the pixels in the mask from their principal axis. Estimates how well two endpoints fit them.
+	float ComputeAxisResidual(const BlockPixels& arg_block, uint16_t arg_mask, uint32_t arg_channel_count)
+	{
+		float mean[4];
+		float axis[4];
+		ComputePrincipalAxis(arg_block, arg_mask, arg_channel_count, mean, axis);
+
+		float residual = 0.0f;
+		for (uint32_t pixel = 0; pixel < 16; ++pixel)
+		{
+			if (arg_mask & (1 << pixel))
+			{
+				float distance_squared = 0.0f;
+				float projection = 0.0f;
+				for (uint32_t channel = 0; channel < arg_channel_count; ++channel)
+				{
+					float difference = arg_block.channels[channel][pixel] - mean[channel];
+					distance_squared += difference * difference;
+					projection += difference * axis[channel];
+				}
+				residual += distance_squared - projection * projection;
+			}
+		}
+		return residual;
+	}
+
+	// Initial endpoints of the pixels in the mask over the first arg_channel_count channels. Other channels are set to 255.
+	void FitEndpoints(const BlockPixels& arg_block, uint16_t arg_mask, uint32_t arg_channel_count, CompressionQuality arg_quality,
+					  float arg_endpoint0[4], float arg_endpoint1[4])
+	{
+		for (uint32_t channel = arg_channel_count; channel < 4; ++channel)
+		{
+			arg_endpoint0[channel] = 255.0f;
+			arg_endpoint1[channel] = 255.0f;
+		}
+
+		if (arg_quality == CompressionQuality::Fast)
+		{
+			// The bounding box, inset a little, since the extremes are rarely hit exactly.
+			uint32_t widest_channel = 0;
+			for (uint32_t channel = 0; channel < arg_channel_count; ++channel)
+			{
+				float min = 255.0f;
+				float max = 0.0f;
+				for (uint32_t pixel = 0; pixel < 16; ++pixel)
+				{
+					if (arg_mask & (1 << pixel))
+					{
+						float value = arg_block.channels[channel][pixel];
+						min = value < min ? value : min;
+						max = value > max ? value : max;
+					}
+				}
+				float inset = (max - min) / 16.0f;
+				arg_endpoint0[channel] = min + inset;
+				arg_endpoint1[channel] = max - inset;
+
+				float widest_range = arg_endpoint1[widest_channel] - arg_endpoint0[widest_channel];
+				widest_channel = arg_endpoint1[channel] - arg_endpoint0[channel] > widest_range ? channel : widest_channel;
+			}
+
+			// Take the diagonal of the box along which the other channels rise and fall with the widest one.
+			float widest_center = (arg_endpoint0[widest_channel] + arg_endpoint1[widest_channel]) * 0.5f;
+			for (uint32_t channel = 0; channel < arg_channel_count; ++channel)
+			{
+				float center = (arg_endpoint0[channel] + arg_endpoint1[channel]) * 0.5f;
+				float correlation = 0.0f;
+				for (uint32_t pixel = 0; pixel < 16; ++pixel)
+				{
+					if (arg_mask & (1 << pixel))
+					{
+						correlation += (arg_block.channels[channel][pixel] - center) * (arg_block.channels[widest_channel][pixel] - widest_center);
+					}
+				}
+				if (correlation < 0.0f)
+				{
+					float endpoint = arg_endpoint0[channel];
+					arg_endpoint0[channel] = arg_endpoint1[channel];
+					arg_endpoint1[channel] = endpoint;
+				}
+			}
+			return;
+		}
+
+		float mean[4];
+		float axis[4];
+		ComputePrincipalAxis(arg_block, arg_mask, arg_channel_count, mean, axis);
+
+		float min_projection = FLT_MAX;
+		float max_projection = -FLT_MAX;
+		for (uint32_t pixel = 0; pixel < 16; ++pixel)
+		{
+			if (arg_mask & (1 << pixel))
+			{
+				float projection = 0.0f;
+				for (uint32_t channel = 0; channel < arg_channel_count; ++channel)
+				{
+					projection += (arg_block.channels[channel][pixel] - mean[channel]) * axis[channel];
+				}
+				min_projection = projection < min_projection ? projection : min_projection;
+				max_projection = projection > max_projection ? projection : max_projection;
+			}
+		}
+
+		for (uint32_t channel = 0; channel < arg_channel_count; ++channel)
+		{
+			arg_endpoint0[channel] = Clamp(mean[channel] + axis[channel] * min_projection, 0.0f, 255.0f);
+			arg_endpoint1[channel] = Clamp(mean[channel] + axis[channel] * max_projection, 0.0f, 255.0f);
+		}
+	}
+
+	/**
+	* Least squares fit of the endpoints to the pixels in the mask, given the weight of the second endpoint
+	* for each palette index. Returns false if the indices do not determine the endpoints.
+	*/
+	bool RefineEndpoints(const BlockPixels& arg_block, uint16_t arg_mask, uint32_t arg_channel_count, const uint8_t arg_indices[16],
+						 const float* arg_index_weights, float arg_endpoint0[4], float arg_endpoint1[4])
+	{
+		float aa = 0.0f;
+		float ab = 0.0f;
+		float bb = 0.0f;
+		float sum0[4] = { };
+		float sum1[4] = { };
+		for (uint32_t pixel = 0; pixel < 16; ++pixel)
+		{
+			if (arg_mask & (1 << pixel))
+			{
+				float b = arg_index_weights[arg_indices[pixel]];
+				float a = 1.0f - b;
+				aa += a * a;
+				ab += a * b;
+				bb += b * b;
+				for (uint32_t channel = 0; channel < arg_channel_count; ++channel)
+				{
+					sum0[channel] += a * arg_block.channels[channel][pixel];
+					sum1[channel] += b * arg_block.channels[channel][pixel];
+				}
+			}
+		}
+
+		float determinant = aa * bb - ab * ab;
+		if (fabsf(determinant) < 1e-6f)
+		{
+			return false;
+		}
+
+		for (uint32_t channel = 0; channel < arg_channel_count; ++channel)
+		{
+			arg_endpoint0[channel] = Clamp((bb * sum0[channel] - ab * sum1[channel]) / determinant, 0.0f, 255.0f);
+			arg_endpoint1[channel] = Clamp((aa * sum1[channel] - ab * sum0[channel]) / determinant, 0.0f, 255.0f);
+		}
+		return true;
+	}
+
+	uint32_t GetRefineIterations(CompressionQuality arg_quality)
+	{
+		return arg_quality == CompressionQuality::Fast ? 0 : (arg_quality == CompressionQuality::Normal ? 1 : 4);
+	}
+
+	// Write the bits of a 128-bit BC7 block, from the lowest bit up.
+	class BitWriter
+	{
+	public:
+		void Write(uint32_t arg_value, uint32_t arg_bit_count)
+		{
+			for (uint32_t bit = 0; bit < arg_bit_count; ++bit, ++position_)
+			{
+				assert(position_ < 128 && "Block overflow");
+				bits_[position_ / 64] |= uint64_t((arg_value >> bit) & 1) << (position_ % 64);
+			}
+		}
+
+		void Store(uint8_t* arg_destination) const
+		{
+			assert(position_ == 128 && "Incomplete block");
+			for (uint32_t byte = 0; byte < 16; ++byte)
+			{
+				arg_destination[byte] = static_cast<uint8_t>(bits_[byte / 8] >> ((byte % 8) * 8));
+			}
+		}
+
+	private:
+		uint64_t bits_[2] = { };
+		uint32_t position_ = 0;
+	};
+
+	// BC4 stores one channel as two 8-bit endpoints and 3-bit indices.
+	void EncodeBC4(const BlockPixels& arg_block, uint32_t arg_channel, CompressionQuality arg_quality, uint8_t* arg_destination)
+	{
+		float channel_weights[4] = { };
+		channel_weights[arg_channel] = 1.0f;
+
+		uint32_t min = 255;
+		uint32_t max = 0;
+		uint32_t inner_min = 255;
+		uint32_t inner_max = 0;
+		for (uint32_t pixel = 0; pixel < 16; ++pixel)
+		{
+			uint32_t value = static_cast<uint32_t>(arg_block.channels[arg_channel][pixel]);
+			min = value < min ? value : min;
+			max = value > max ? value : max;
+			if (value != 0 && value != 255)
+			{
+				inner_min = value < inner_min ? value : inner_min;
+				inner_max = value > inner_max ? value : inner_max;
+			}
+		}
+
+		float best_error = FLT_MAX;
+		uint32_t best_endpoints[2] = { };
+		uint8_t best_indices[16] = { };
+
+		auto try_endpoints = [&](uint32_t arg_endpoint0, uint32_t arg_endpoint1)
+		{
+			float palette[8][4] = { };
+			palette[0][arg_channel] = float(arg_endpoint0);
+			palette[1][arg_channel] = float(arg_endpoint1);
+			if (arg_endpoint0 > arg_endpoint1)
+			{
+				// Six interpolated values.
+				for (uint32_t i = 2; i < 8; ++i)
+				{
+					palette[i][arg_channel] = float((8 - i) * arg_endpoint0 + (i - 1) * arg_endpoint1) / 7.0f;
+				}
+			}
+			else
+			{
+				// Four interpolated values, and exact 0 and 255.
+				for (uint32_t i = 2; i < 6; ++i)
+				{
+					palette[i][arg_channel] = float((6 - i) * arg_endpoint0 + (i - 1) * arg_endpoint1) / 5.0f;
+				}
+				palette[6][arg_channel] = 0.0f;
+				palette[7][arg_channel] = 255.0f;
+			}
+
+			uint8_t indices[16];
+			float error = SelectIndices(arg_block, ALL_PIXELS, channel_weights, palette, 8, indices);
+			if (error < best_error)
+			{
+				best_error = error;
+				best_endpoints[0] = arg_endpoint0;
+				best_endpoints[1] = arg_endpoint1;
+				memcpy(best_indices, indices, sizeof(indices));
+			}
+		};
+
+		try_endpoints(max, min);
+		if (arg_quality != CompressionQuality::Fast && best_error > 0.0f)
+		{
+			if (inner_min <= inner_max)
+			{
+				try_endpoints(inner_min, inner_max);
+			}
+			else
+			{
+				try_endpoints(0, 255);
+			}
+		}
+		if (arg_quality == CompressionQuality::High && best_error > 0.0f)
+		{
+			// Pull the endpoints in, the extremes may be outliers.
+			for (uint32_t shrink0 = 0; shrink0 < 4 && shrink0 <= max; ++shrink0)
+			{
+				for (uint32_t shrink1 = 0; shrink1 < 4 && min + shrink1 <= 255; ++shrink1)
+				{
+					if ((shrink0 | shrink1) != 0 && max - shrink0 > min + shrink1)
+					{
+						try_endpoints(max - shrink0, min + shrink1);
+					}
+				}
+			}
+		}
+
+		arg_destination[0] = static_cast<uint8_t>(best_endpoints[0]);
+		arg_destination[1] = static_cast<uint8_t>(best_endpoints[1]);
+		uint64_t index_bits = 0;
+		for (uint32_t pixel = 0; pixel < 16; ++pixel)
+		{
+			index_bits |= uint64_t(best_indices[pixel]) << (pixel * 3);
+		}
+		for (uint32_t byte = 0; byte < 6; ++byte)
+		{
+			arg_destination[2 + byte] = static_cast<uint8_t>(index_bits >> (byte * 8));
+		}
+	}
+
+	uint16_t PackRGB565(const float arg_color[4])
+	{
+		uint32_t red = Quantize(arg_color[0] * 31.0f / 255.0f, 31);
+		uint32_t green = Quantize(arg_color[1] * 63.0f / 255.0f, 63);
+		uint32_t blue = Quantize(arg_color[2] * 31.0f / 255.0f, 31);
+		return static_cast<uint16_t>((red << 11) | (green << 5) | blue);
+	}
+
+	void UnpackRGB565(uint16_t arg_packed, float arg_color[4])
+	{
+		uint32_t red = arg_packed >> 11;
+		uint32_t green = (arg_packed >> 5) & 0x3F;
+		uint32_t blue = arg_packed & 0x1F;
+		arg_color[0] = float((red << 3) | (red >> 2));
+		arg_color[1] = float((green << 2) | (green >> 4));
+		arg_color[2] = float((blue << 3) | (blue >> 2));
+		arg_color[3] = 255.0f;
+	}
+
+	/**
+	* The color block of BC1 and BC3: two RGB565 endpoints and 2-bit indices. BC1 switches to three
+	* colors and transparent black for blocks with transparent pixels; BC3 always uses four colors.
+	*/
+	void EncodeColorBlock(const BlockPixels& arg_block, CompressionQuality arg_quality, bool arg_bc1, uint8_t* arg_destination)
+	{
+		uint16_t transparent_mask = 0;
+		if (arg_bc1)
+		{
+			for (uint32_t pixel = 0; pixel < 16; ++pixel)
+			{
+				if (arg_block.channels[3][pixel] < 128.0f)
+				{
+					transparent_mask |= 1 << pixel;
+				}
+			}
+		}
+		uint16_t opaque_mask = static_cast<uint16_t>(~transparent_mask);
+		bool three_colors = transparent_mask != 0;
+
+		if (opaque_mask == 0)
+		{
+			// Equal endpoints select three colors, and index 3 is transparent.
+			memset(arg_destination, 0, 4);
+			memset(arg_destination + 4, 0xFF, 4);
+			return;
+		}
+
+		auto evaluate = [&](const float arg_endpoint0[4], const float arg_endpoint1[4], uint16_t (&arg_packed)[2], uint8_t (&arg_indices)[16]) -> float
+		{
+			arg_packed[0] = PackRGB565(arg_endpoint0);
+			arg_packed[1] = PackRGB565(arg_endpoint1);
+			// The order of the endpoints selects the mode.
+			if (three_colors ? arg_packed[0] > arg_packed[1] : arg_packed[0] < arg_packed[1])
+			{
+				uint16_t packed = arg_packed[0];
+				arg_packed[0] = arg_packed[1];
+				arg_packed[1] = packed;
+			}
+
+			float palette[4][4];
+			UnpackRGB565(arg_packed[0], palette[0]);
+			UnpackRGB565(arg_packed[1], palette[1]);
+			uint32_t palette_size = 3;
+			if (!three_colors && (arg_packed[0] > arg_packed[1] || !arg_bc1))
+			{
+				for (uint32_t channel = 0; channel < 4; ++channel)
+				{
+					palette[2][channel] = (2.0f * palette[0][channel] + palette[1][channel]) / 3.0f;
+					palette[3][channel] = (palette[0][channel] + 2.0f * palette[1][channel]) / 3.0f;
+				}
+				palette_size = 4;
+			}
+			else
+			{
+				for (uint32_t channel = 0; channel < 4; ++channel)
+				{
+					palette[2][channel] = (palette[0][channel] + palette[1][channel]) * 0.5f;
+				}
+			}
+
+			float error = SelectIndices(arg_block, opaque_mask, RGB_WEIGHTS, palette, palette_size, arg_indices);
+			for (uint32_t pixel = 0; pixel < 16; ++pixel)
+			{
+				if (transparent_mask & (1 << pixel))
+				{
+					arg_indices[pixel] = 3;
+				}
+			}
+			return error;
+		};
+
+		float endpoint0[4];
+		float endpoint1[4];
+		FitEndpoints(arg_block, opaque_mask, 3, arg_quality, endpoint0, endpoint1);
+
+		uint16_t packed[2];
+		uint8_t indices[16];
+		float error = evaluate(endpoint0, endpoint1, packed, indices);
+
+		for (uint32_t iteration = 0; iteration < GetRefineIterations(arg_quality) && error > 0.0f; ++iteration)
+		{
+			static const float four_color_weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+			static const float three_color_weights[4] = { 0.0f, 1.0f, 0.5f, 0.0f };
+			bool four_colors = !three_colors && (packed[0] > packed[1] || !arg_bc1);
+
+			if (!RefineEndpoints(arg_block, opaque_mask, 3, indices, four_colors ? four_color_weights : three_color_weights, endpoint0, endpoint1))
+			{
+				break;
+			}
+
+			uint16_t refined_packed[2];
+			uint8_t refined_indices[16];
+			float refined_error = evaluate(endpoint0, endpoint1, refined_packed, refined_indices);
+			if (refined_error >= error)
+			{
+				break;
+			}
+			error = refined_error;
+			memcpy(packed, refined_packed, sizeof(packed));
+			memcpy(indices, refined_indices, sizeof(indices));
+		}
+
+		uint32_t index_bits = 0;
+		for (uint32_t pixel = 0; pixel < 16; ++pixel)
+		{
+			index_bits |= uint32_t(indices[pixel]) << (pixel * 2);
+		}
+		arg_destination[0] = static_cast<uint8_t>(packed[0]);
+		arg_destination[1] = static_cast<uint8_t>(packed[0] >> 8);
+		arg_destination[2] = static_cast<uint8_t>(packed[1]);
+		arg_destination[3] = static_cast<uint8_t>(packed[1] >> 8);
+		for (uint32_t byte = 0; byte < 4; ++byte)
+		{
+			arg_destination[4 + byte] = static_cast<uint8_t>(index_bits >> (byte * 8));
+		}
+	}
+
+	// BC7 mode 6: one subset, RGBA endpoints of 7 bits plus a p-bit each, and 4-bit indices.
+	struct Bc7Mode6
+	{
+		uint32_t endpoints[2][4];
+		uint32_t p_bits[2];
+		uint8_t indices[16];
+		float error;
+	};
+
+	// BC7 mode 1: two subsets, RGB endpoints of 6 bits plus a p-bit shared per subset, and 3-bit indices.
+	struct Bc7Mode1
+	{
+		uint32_t partition;
+		uint32_t endpoints[2][2][3];
+		uint32_t p_bits[2];
+		uint8_t indices[16];
+		float error;
+	};
+
+	void EvaluateMode6(const BlockPixels& arg_block, const float arg_endpoint0[4], const float arg_endpoint1[4], Bc7Mode6& arg_mode)
+	{
+		const float* endpoints[2] = { arg_endpoint0, arg_endpoint1 };
+		uint32_t values[2][4];
+		for (uint32_t endpoint = 0; endpoint < 2; ++endpoint)
+		{
+			// Pick the p-bit that gets the endpoint closest.
+			float best_error = FLT_MAX;
+			for (uint32_t p_bit = 0; p_bit < 2; ++p_bit)
+			{
+				uint32_t quantized[4];
+				float error = 0.0f;
+				for (uint32_t channel = 0; channel < 4; ++channel)
+				{
+					quantized[channel] = Quantize((endpoints[endpoint][channel] - float(p_bit)) * 0.5f, 127);
+					float difference = float(quantized[channel] * 2 + p_bit) - endpoints[endpoint][channel];
+					error += difference * difference;
+				}
+				if (error < best_error)
+				{
+					best_error = error;
+					arg_mode.p_bits[endpoint] = p_bit;
+					memcpy(arg_mode.endpoints[endpoint], quantized, sizeof(quantized));
+				}
+			}
+			for (uint32_t channel = 0; channel < 4; ++channel)
+			{
+				values[endpoint][channel] = arg_mode.endpoints[endpoint][channel] * 2 + arg_mode.p_bits[endpoint];
+			}
+		}
+
+		float palette[16][4];
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			for (uint32_t channel = 0; channel < 4; ++channel)
+			{
+				palette[i][channel] = float(((64 - BC7_WEIGHTS_4[i]) * values[0][channel] + BC7_WEIGHTS_4[i] * values[1][channel] + 32) >> 6);
+			}
+		}
+
+		arg_mode.error = SelectIndices(arg_block, ALL_PIXELS, RGBA_WEIGHTS, palette, 16, arg_mode.indices);
+	}
+
+	void EncodeMode6(const BlockPixels& arg_block, CompressionQuality arg_quality, Bc7Mode6& arg_mode)
+	{
+		float endpoint0[4];
+		float endpoint1[4];
+		FitEndpoints(arg_block, ALL_PIXELS, 4, arg_quality, endpoint0, endpoint1);
+		EvaluateMode6(arg_block, endpoint0, endpoint1, arg_mode);
+
+		float index_weights[16];
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			index_weights[i] = float(BC7_WEIGHTS_4[i]) / 64.0f;
+		}
+
+		for (uint32_t iteration = 0; iteration < GetRefineIterations(arg_quality) && arg_mode.error > 0.0f; ++iteration)
+		{
+			if (!RefineEndpoints(arg_block, ALL_PIXELS, 4, arg_mode.indices, index_weights, endpoint0, endpoint1))
+			{
+				break;
+			}
+
+			Bc7Mode6 refined;
+			EvaluateMode6(arg_block, endpoint0, endpoint1, refined);
+			if (refined.error >= arg_mode.error)
+			{
+				break;
+			}
+			arg_mode = refined;
+		}
+	}
+
+	void WriteMode6(Bc7Mode6 arg_mode, uint8_t* arg_destination)
+	{
+		// The high bit of the index of the first pixel is implicitly 0.
+		if (arg_mode.indices[0] >= 8)
+		{
+			for (uint32_t channel = 0; channel < 4; ++channel)
+			{
+				uint32_t endpoint = arg_mode.endpoints[0][channel];
+				arg_mode.endpoints[0][channel] = arg_mode.endpoints[1][channel];
+				arg_mode.endpoints[1][channel] = endpoint;
+			}
+			uint32_t p_bit = arg_mode.p_bits[0];
+			arg_mode.p_bits[0] = arg_mode.p_bits[1];
+			arg_mode.p_bits[1] = p_bit;
+			for (uint8_t& index : arg_mode.indices)
+			{
+				index = 15 - index;
+			}
+		}
+
+		BitWriter writer;
+		writer.Write(1 << 6, 7);
+		for (uint32_t channel = 0; channel < 4; ++channel)
+		{
+			writer.Write(arg_mode.endpoints[0][channel], 7);
+			writer.Write(arg_mode.endpoints[1][channel], 7);
+		}
+		writer.Write(arg_mode.p_bits[0], 1);
+		writer.Write(arg_mode.p_bits[1], 1);
+		for (uint32_t pixel = 0; pixel < 16; ++pixel)
+		{
+			writer.Write(arg_mode.indices[pixel], pixel == 0 ? 3 : 4);
+		}
+		writer.Store(arg_destination);
+	}
+
+	void EvaluateMode1(const BlockPixels& arg_block, uint32_t arg_partition, const float (&arg_endpoints)[2][2][4], Bc7Mode1& arg_mode)
+	{
+		arg_mode.partition = arg_partition;
+		arg_mode.error = 0.0f;
+
+		for (uint32_t subset = 0; subset < 2; ++subset)
+		{
+			// Pick the shared p-bit that gets both endpoints closest.
+			float best_error = FLT_MAX;
+			for (uint32_t p_bit = 0; p_bit < 2; ++p_bit)
+			{
+				uint32_t quantized[2][3];
+				float error = 0.0f;
+				for (uint32_t endpoint = 0; endpoint < 2; ++endpoint)
+				{
+					for (uint32_t channel = 0; channel < 3; ++channel)
+					{
+						float value = arg_endpoints[subset][endpoint][channel];
+						quantized[endpoint][channel] = Quantize((value * 127.0f / 255.0f - float(p_bit)) * 0.5f, 63);
+						uint32_t value7 = quantized[endpoint][channel] * 2 + p_bit;
+						float difference = float((value7 << 1) | (value7 >> 6)) - value;
+						error += difference * difference;
+					}
+				}
+				if (error < best_error)
+				{
+					best_error = error;
+					arg_mode.p_bits[subset] = p_bit;
+					memcpy(arg_mode.endpoints[subset], quantized, sizeof(quantized));
+				}
+			}
+
+			float palette[8][4];
+			for (uint32_t i = 0; i < 8; ++i)
+			{
+				for (uint32_t channel = 0; channel < 3; ++channel)
+				{
+					uint32_t value0 = arg_mode.endpoints[subset][0][channel] * 2 + arg_mode.p_bits[subset];
+					uint32_t value1 = arg_mode.endpoints[subset][1][channel] * 2 + arg_mode.p_bits[subset];
+					value0 = (value0 << 1) | (value0 >> 6);
+					value1 = (value1 << 1) | (value1 >> 6);
+					palette[i][channel] = float(((64 - BC7_WEIGHTS_3[i]) * value0 + BC7_WEIGHTS_3[i] * value1 + 32) >> 6);
+				}
+				palette[i][3] = 255.0f;
+			}
+
+			uint16_t mask = subset == 0 ? static_cast<uint16_t>(~BC7_PARTITIONS_2[arg_partition]) : BC7_PARTITIONS_2[arg_partition];
+			arg_mode.error += SelectIndices(arg_block, mask, RGB_WEIGHTS, palette, 8, arg_mode.indices);
+		}
+	}
+
+	void EncodeMode1(const BlockPixels& arg_block, uint32_t arg_partition, CompressionQuality arg_quality, Bc7Mode1& arg_mode)
+	{
+		uint16_t masks[2] = { static_cast<uint16_t>(~BC7_PARTITIONS_2[arg_partition]), BC7_PARTITIONS_2[arg_partition] };
+
+		float endpoints[2][2][4];
+		for (uint32_t subset = 0; subset < 2; ++subset)
+		{
+			FitEndpoints(arg_block, masks[subset], 3, arg_quality, endpoints[subset][0], endpoints[subset][1]);
+		}
+		EvaluateMode1(arg_block, arg_partition, endpoints, arg_mode);
+
+		float index_weights[8];
+		for (uint32_t i = 0; i < 8; ++i)
+		{
+			index_weights[i] = float(BC7_WEIGHTS_3[i]) / 64.0f;
+		}
+
+		for (uint32_t iteration = 0; iteration < GetRefineIterations(arg_quality) && arg_mode.error > 0.0f; ++iteration)
+		{
+			float refined_endpoints[2][2][4];
+			memcpy(refined_endpoints, endpoints, sizeof(endpoints));
+			for (uint32_t subset = 0; subset < 2; ++subset)
+			{
+				RefineEndpoints(arg_block, masks[subset], 3, arg_mode.indices, index_weights, refined_endpoints[subset][0], refined_endpoints[subset][1]);
+			}
+
+			Bc7Mode1 refined;
+			EvaluateMode1(arg_block, arg_partition, refined_endpoints, refined);
+			if (refined.error >= arg_mode.error)
+			{
+				break;
+			}
+			arg_mode = refined;
+			memcpy(endpoints, refined_endpoints, sizeof(endpoints));
+		}
+	}
+
+	void WriteMode1(Bc7Mode1 arg_mode, uint8_t* arg_destination)
+	{
+		uint16_t subset1_mask = BC7_PARTITIONS_2[arg_mode.partition];
+		uint32_t anchors[2] = { 0, BC7_ANCHORS_2[arg_mode.partition] };
+
+		// The high bit of the index of each anchor pixel is implicitly 0.
+		for (uint32_t subset = 0; subset < 2; ++subset)
+		{
+			if (arg_mode.indices[anchors[subset]] < 4)
+			{
+				continue;
+			}
+			for (uint32_t channel = 0; channel < 3; ++channel)
+			{
+				uint32_t endpoint = arg_mode.endpoints[subset][0][channel];
+				arg_mode.endpoints[subset][0][channel] = arg_mode.endpoints[subset][1][channel];
+				arg_mode.endpoints[subset][1][channel] = endpoint;
+			}
+			for (uint32_t pixel = 0; pixel < 16; ++pixel)
+			{
+				if (((subset1_mask >> pixel) & 1) == subset)
+				{
+					arg_mode.indices[pixel] = 7 - arg_mode.indices[pixel];
+				}
+			}
+		}
+
+		BitWriter writer;
+		writer.Write(1 << 1, 2);
+		writer.Write(arg_mode.partition, 6);
+		for (uint32_t channel = 0; channel < 3; ++channel)
+		{
+			for (uint32_t subset = 0; subset < 2; ++subset)
+			{
+				writer.Write(arg_mode.endpoints[subset][0][channel], 6);
+				writer.Write(arg_mode.endpoints[subset][1][channel], 6);
+			}
+		}
+		writer.Write(arg_mode.p_bits[0], 1);
+		writer.Write(arg_mode.p_bits[1], 1);
+		for (uint32_t pixel = 0; pixel < 16; ++pixel)
+		{
+			writer.Write(arg_mode.indices[pixel], pixel == anchors[0] || pixel == anchors[1] ? 2 : 3);
+		}
+		writer.Store(arg_destination);
+	}
+
+	void EncodeBC7(const BlockPixels& arg_block, CompressionQuality arg_quality, uint8_t* arg_destination)
+	{
+		Bc7Mode6 mode6;
+		EncodeMode6(arg_block, arg_quality, mode6);
+
+		bool opaque = true;
+		for (uint32_t pixel = 0; pixel < 16; ++pixel)
+		{
+			opaque = opaque && arg_block.channels[3][pixel] == 255.0f;
+		}
+
+		if (arg_quality == CompressionQuality::High && opaque && mode6.error > 0.0f)
+		{
+			// Estimate the partitions by how well a line fits each subset, and only encode the best few.
+			uint32_t candidates[BC7_PARTITION_CANDIDATES];
+			float candidate_errors[BC7_PARTITION_CANDIDATES];
+			for (uint32_t i = 0; i < BC7_PARTITION_CANDIDATES; ++i)
+			{
+				candidates[i] = 0;
+				candidate_errors[i] = FLT_MAX;
+			}
+
+			for (uint32_t partition = 0; partition < 64; ++partition)
+			{
+				float error = ComputeAxisResidual(arg_block, static_cast<uint16_t>(~BC7_PARTITIONS_2[partition]), 3) +
+							  ComputeAxisResidual(arg_block, BC7_PARTITIONS_2[partition], 3);
+
+				// Insert into the sorted candidates.
+				for (uint32_t i = 0; i < BC7_PARTITION_CANDIDATES; ++i)
+				{
+					if (error < candidate_errors[i])
+					{
+						for (uint32_t j = BC7_PARTITION_CANDIDATES - 1; j > i; --j)
+						{
+							candidates[j] = candidates[j - 1];
+							candidate_errors[j] = candidate_errors[j - 1];
+						}
+						candidates[i] = partition;
+						candidate_errors[i] = error;
+						break;
+					}
+				}
+			}
+
+			Bc7Mode1 best_mode1;
+			best_mode1.error = FLT_MAX;
+			for (uint32_t partition : candidates)
+			{
+				Bc7Mode1 mode1;
+				EncodeMode1(arg_block, partition, arg_quality, mode1);
+				if (mode1.error < best_mode1.error)
+				{
+					best_mode1 = mode1;
+				}
+			}
+
+			if (best_mode1.error < mode6.error)
+			{
+				WriteMode1(best_mode1, arg_destination);
+				return;
+			}
+		}
+
+		WriteMode6(mode6, arg_destination);
+	}
+}
+
+BlockCompressor::BlockCompressor(BlockFormat arg_format, CompressionQuality arg_quality, uint32_t arg_thread_count)
+	: format_(arg_format)
+	, quality_(arg_quality)
+	, thread_count_(arg_thread_count)
+{ }
+
+void BlockCompressor::Compress(const uint8_t* arg_pixels, uint32_t arg_width, uint32_t arg_height, uint32_t arg_row_pitch,
+							   uint8_t* arg_destination, uint32_t arg_destination_row_pitch) const
+{
+	if (arg_width == 0 || arg_height == 0)
+	{
+		ThrowIfFailed(E_INVALIDARG);
+	}
+
+	uint32_t blocks_x = GetBlockCount(arg_width);
+	uint32_t blocks_y = GetBlockCount(arg_height);
+	uint32_t block_size = GetBlockSize();
+
+	ParallelFor(blocks_x * blocks_y, BLOCKS_PER_CHUNK, [&](uint32_t arg_begin, uint32_t arg_end)
+	{
+		for (uint32_t block = arg_begin; block < arg_end; ++block)
+		{
+			uint32_t block_x = block % blocks_x;
+			uint32_t block_y = block / blocks_x;
+			CompressBlock(arg_pixels, arg_width, arg_height, arg_row_pitch, block_x, block_y,
+						  arg_destination + size_t(block_y) * arg_destination_row_pitch + size_t(block_x) * block_size);
+		}
+	}, thread_count_);
+}
+
+DXGI_FORMAT BlockCompressor::GetFormat() const
+{
+	switch (format_)
+	{
+	case BlockFormat::BC1:
+		return DXGI_FORMAT_BC1_UNORM;
+	case BlockFormat::BC3:
+		return DXGI_FORMAT_BC3_UNORM;
+	case BlockFormat::BC4:
+		return DXGI_FORMAT_BC4_UNORM;
+	case BlockFormat::BC5:
+		return DXGI_FORMAT_BC5_UNORM;
+	case BlockFormat::BC7:
+		return DXGI_FORMAT_BC7_UNORM;
+	}
+
+	assert(false && "Unknown block format");
+	return DXGI_FORMAT_UNKNOWN;
+}
+
+uint32_t BlockCompressor::GetBlockSize() const
+{
+	return format_ == BlockFormat::BC1 || format_ == BlockFormat::BC4 ? 8 : 16;
+}
+
+uint32_t BlockCompressor::GetBlockCount(uint32_t arg_size)
+{
+	return (arg_size + 3) / 4;
+}
+
+void BlockCompressor::CompressBlock(const uint8_t* arg_pixels, uint32_t arg_width, uint32_t arg_height, uint32_t arg_row_pitch,
+									uint32_t arg_block_x, uint32_t arg_block_y, uint8_t* arg_destination) const
+{
+	BlockPixels block;
+	LoadBlock(arg_pixels, arg_width, arg_height, arg_row_pitch, arg_block_x, arg_block_y, block);
+
+	switch (format_)
+	{
+	case BlockFormat::BC1:
+		EncodeColorBlock(block, quality_, true, arg_destination);
+		break;
+	case BlockFormat::BC3:
+		EncodeBC4(block, 3, quality_, arg_destination);
+		EncodeColorBlock(block, quality_, false, arg_destination + 8);
+		break;
+	case BlockFormat::BC4:
+		EncodeBC4(block, 0, quality_, arg_destination);
+		break;
+	case BlockFormat::BC5:
+		EncodeBC4(block, 0, quality_, arg_destination);
+		EncodeBC4(block, 1, quality_, arg_destination + 8);
+		break;
+	case BlockFormat::BC7:
+		EncodeBC7(block, quality_, arg_destination);
+		break;
+	}
+}
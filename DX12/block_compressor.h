@@ -0,0 +1,59 @@
+/**
+* The block compressor encodes RGBA8 images into the BC formats. Blocks are independent, so
+* they are spread over threads. Within a block, the search for the nearest palette entry of
+* each pixel, where most of the time goes, runs on four pixels at a time with SSE2.
+*/
+#pragma once
+
+#include <d3d12.h>
+
+#include <cstdint>
+
+enum class BlockFormat
+{
+	BC1,	// RGB with 1-bit alpha, 8 bytes per block.
+	BC3,	// RGBA, 16 bytes per block.
+	BC4,	// The red channel, 8 bytes per block.
+	BC5,	// The red and green channels, 16 bytes per block.
+	BC7		// RGBA at a higher quality than BC3, 16 bytes per block.
+};
+
+enum class CompressionQuality
+{
+	Fast,	// Endpoints from the bounding box of the block.
+	Normal,	// Endpoints along the principal axis of the block, refined once.
+	High	// Refined until they stop improving. BC7 also tries two-subset partitions for opaque blocks.
+};
+
+class BlockCompressor
+{
+public:
+	/**
+	* @param arg_thread_count The number of threads, or 0 for the number of hardware threads.
+	*/
+	BlockCompressor(BlockFormat arg_format, CompressionQuality arg_quality = CompressionQuality::Normal, uint32_t arg_thread_count = 0);
+
+	/**
+	* Compress an image. The blocks on the right and bottom edge of an image whose size is not a
+	* multiple of 4 repeat the last column and row.
+	* @param arg_destination_row_pitch The number of bytes between rows of blocks.
+	*/
+	void Compress(const uint8_t* arg_pixels, uint32_t arg_width, uint32_t arg_height, uint32_t arg_row_pitch,
+				  uint8_t* arg_destination, uint32_t arg_destination_row_pitch) const;
+
+	DXGI_FORMAT GetFormat() const;
+
+	// The size of a 4x4 block in bytes.
+	uint32_t GetBlockSize() const;
+
+	// The number of blocks that cover a width or height.
+	static uint32_t GetBlockCount(uint32_t arg_size);
+
+private:
+	void CompressBlock(const uint8_t* arg_pixels, uint32_t arg_width, uint32_t arg_height, uint32_t arg_row_pitch,
+					   uint32_t arg_block_x, uint32_t arg_block_y, uint8_t* arg_destination) const;
+
+	BlockFormat format_;
+	CompressionQuality quality_;
+	uint32_t thread_count_;
+};
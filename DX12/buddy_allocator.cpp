@@ -0,0 +1,143 @@
+#include <buddy_allocator.h>
+
+#include <algorithm>
+#include <cassert>
+
+BuddyAllocator::BuddyAllocator(uint64_t arg_min_block_size, uint32_t arg_max_order)
+	: min_block_size_(arg_min_block_size)
+	, max_order_(arg_max_order)
+	, free_size_(arg_min_block_size << arg_max_order)
+	, free_blocks_(arg_max_order + 1)
+{
+	assert(arg_min_block_size > 0 && (arg_min_block_size & (arg_min_block_size - 1)) == 0 && "Block size must be a power of two.");
+	assert(arg_max_order < 64 && "Too many orders.");
+
+	free_blocks_[max_order_].insert(0);
+}
+
+uint64_t BuddyAllocator::Allocate(uint64_t arg_size, uint64_t arg_alignment)
+{
+	assert(arg_alignment > 0 && (arg_alignment & (arg_alignment - 1)) == 0 && "Alignment must be a power of two.");
+
+	uint32_t order = std::max(GetOrder(arg_size), GetOrder(arg_alignment));
+	if (order > max_order_)
+	{
+		return invalid_offset_;
+	}
+
+	// Find the smallest free block that is large enough.
+	uint32_t found_order = order;
+	while (found_order <= max_order_ && free_blocks_[found_order].empty())
+	{
+		++found_order;
+	}
+	if (found_order > max_order_)
+	{
+		return invalid_offset_;
+	}
+
+	uint64_t offset = *free_blocks_[found_order].begin();
+	free_blocks_[found_order].erase(free_blocks_[found_order].begin());
+
+	// Split the block down to the requested order. The upper halves become free buddies.
+	while (found_order > order)
+	{
+		--found_order;
+		free_blocks_[found_order].insert(offset + GetBlockSize(found_order));
+	}
+
+	allocations_[offset] = Allocation{order, arg_size};
+	free_size_ -= GetBlockSize(order);
+
+	return offset;
+}
+
+void BuddyAllocator::Free(uint64_t arg_offset)
+{
+	auto iter = allocations_.find(arg_offset);
+	assert(iter != allocations_.end() && "Offset was not allocated by this allocator.");
+	if (iter == allocations_.end())
+	{
+		return;
+	}
+
+	uint32_t order = iter->second.order;
+	uint64_t offset = arg_offset;
+	allocations_.erase(iter);
+	free_size_ += GetBlockSize(order);
+
+	// Merge with the buddy as long as it is free.
+	while (order < max_order_)
+	{
+		uint64_t buddy = offset ^ GetBlockSize(order);
+		auto buddy_iter = free_blocks_[order].find(buddy);
+		if (buddy_iter == free_blocks_[order].end())
+		{
+			break;
+		}
+
+		free_blocks_[order].erase(buddy_iter);
+		offset = std::min(offset, buddy);
+		++order;
+	}
+
+	free_blocks_[order].insert(offset);
+}
+
+uint64_t BuddyAllocator::GetSize() const
+{
+	return GetBlockSize(max_order_);
+}
+
+uint64_t BuddyAllocator::GetFreeSize() const
+{
+	return free_size_;
+}
+
+size_t BuddyAllocator::GetAllocationCount() const
+{
+	return allocations_.size();
+}
+
+BuddyAllocator::FragmentationReport BuddyAllocator::GetFragmentationReport() const
+{
+	FragmentationReport report = { };
+	report.total_size = GetSize();
+	report.free_size = free_size_;
+	report.allocation_count = allocations_.size();
+	report.free_blocks_per_order.resize(max_order_ + 1);
+
+	for (uint32_t order = 0; order <= max_order_; ++order)
+	{
+		report.free_blocks_per_order[order] = free_blocks_[order].size();
+		if (!free_blocks_[order].empty())
+		{
+			report.largest_free_block = GetBlockSize(order);
+		}
+	}
+
+	for (const auto& allocation : allocations_)
+	{
+		report.internal_fragmentation += GetBlockSize(allocation.second.order) - allocation.second.requested_size;
+	}
+
+	report.external_fragmentation = free_size_ > 0 ? 1.0 - static_cast<double>(report.largest_free_block) / free_size_ : 0.0;
+
+	return report;
+}
+
+uint32_t BuddyAllocator::GetOrder(uint64_t arg_size) const
+{
+	uint32_t order = 0;
+	while (order <= max_order_ && GetBlockSize(order) < arg_size)
+	{
+		++order;
+	}
+
+	return order;
+}
+
+uint64_t BuddyAllocator::GetBlockSize(uint32_t arg_order) const
+{
+	return min_block_size_ << arg_order;
+}
@@ -0,0 +1,77 @@
+/**
+* Binary buddy allocator that manages offsets in a power-of-two sized range. Every block
+* is a power-of-two multiple of the minimum block size and is aligned to its own size.
+* Allocation and free take O(log n) and freed blocks are merged with their buddy
+* immediately. Like the TLSF allocator it does not touch memory and runs without a device.
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class BuddyAllocator
+{
+public:
+	// Returned by Allocate when no block is large enough.
+	static const uint64_t invalid_offset_ = ~0ull;
+
+	// Summary of the state of the allocator, used to decide when to defragment.
+	struct FragmentationReport
+	{
+		uint64_t total_size;
+		uint64_t free_size;
+		uint64_t largest_free_block;
+		// Bytes lost because allocations are rounded up to a power of two.
+		uint64_t internal_fragmentation;
+		// 0 when all free memory is one block, approaching 1 when it is scattered over many small blocks.
+		double external_fragmentation;
+		size_t allocation_count;
+		// Number of free blocks of each order. Order n blocks are min_block_size << n bytes.
+		std::vector<size_t> free_blocks_per_order;
+	};
+
+	/**
+	* @param arg_min_block_size The size of the smallest block. Must be a power of two.
+	* @param arg_max_order The range is min_block_size << max_order bytes.
+	*/
+	BuddyAllocator(uint64_t arg_min_block_size, uint32_t arg_max_order);
+
+	/**
+	* Allocate a block of at least the given size.
+	* @param arg_alignment Must be a power of two. Blocks are aligned to their size, so this
+	* only matters when it is larger than the rounded-up size.
+	* @returns The offset of the block or invalid_offset_.
+	*/
+	uint64_t Allocate(uint64_t arg_size, uint64_t arg_alignment = 1);
+
+	// Free a block returned by Allocate.
+	void Free(uint64_t arg_offset);
+
+	uint64_t GetSize() const;
+	uint64_t GetFreeSize() const;
+	size_t GetAllocationCount() const;
+
+	FragmentationReport GetFragmentationReport() const;
+
+private:
+	struct Allocation
+	{
+		uint32_t order;
+		uint64_t requested_size;
+	};
+
+	// The smallest order whose blocks hold the given size.
+	uint32_t GetOrder(uint64_t arg_size) const;
+	uint64_t GetBlockSize(uint32_t arg_order) const;
+
+	uint64_t min_block_size_;
+	uint32_t max_order_;
+	uint64_t free_size_;
+
+	// Offsets of the free blocks of every order.
+	std::vector<std::unordered_set<uint64_t>> free_blocks_;
+	std::unordered_map<uint64_t, Allocation> allocations_;
+};
@@ -0,0 +1,43 @@
+#include <bundle_cache.h>
+#include <helpers.h>
+
+BundleCache::BundleCache(Microsoft::WRL::ComPtr<ID3D12Device2> arg_device)
+	: d3d12_device_(arg_device)
+{ }
+
+Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> BundleCache::GetOrRecord(uint64_t arg_key, ID3D12PipelineState* arg_pipeline_state,
+																			const RecordFunction& arg_record)
+{
+	auto iter = bundles_.find(arg_key);
+	if (iter != bundles_.end())
+	{
+		return iter->second.bundle;
+	}
+
+	Entry entry;
+	ThrowIfFailed(d3d12_device_->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_BUNDLE, IID_PPV_ARGS(&entry.allocator)));
+	ThrowIfFailed(d3d12_device_->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_BUNDLE, entry.allocator.Get(),
+				  arg_pipeline_state, IID_PPV_ARGS(&entry.bundle)));
+
+	arg_record(entry.bundle.Get());
+	ThrowIfFailed(entry.bundle->Close());
+
+	bundles_.emplace(arg_key, entry);
+
+	return entry.bundle;
+}
+
+bool BundleCache::Contains(uint64_t arg_key) const
+{
+	return bundles_.find(arg_key) != bundles_.end();
+}
+
+void BundleCache::Invalidate(uint64_t arg_key)
+{
+	bundles_.erase(arg_key);
+}
+
+void BundleCache::Clear()
+{
+	bundles_.clear();
+}
@@ -0,0 +1,52 @@
+/**
+* The bundle cache records static command sequences (pipeline state, root signature, vertex
+* and index buffers and draw calls) once into bundles so they can be replayed every frame
+* with ExecuteBundle. Per-frame data such as root constants is set on the calling command
+* list before the bundle is executed and is inherited by the bundle.
+*/
+#pragma once
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
+class BundleCache
+{
+public:
+	// Records the commands of a bundle. The bundle has already been created with the initial pipeline state.
+	using RecordFunction = std::function<void(ID3D12GraphicsCommandList2* arg_bundle)>;
+
+	BundleCache(Microsoft::WRL::ComPtr<ID3D12Device2> arg_device);
+
+	/**
+	* Get the bundle stored for a key, recording it if it does not exist yet.
+	* @param arg_key A user defined key that identifies the command sequence.
+	* @param arg_pipeline_state The initial pipeline state of the bundle.
+	* @param arg_record Records the commands of the bundle. Only invoked on a cache miss.
+	*/
+	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> GetOrRecord(uint64_t arg_key, ID3D12PipelineState* arg_pipeline_state,
+																   const RecordFunction& arg_record);
+
+	// Returns true if a bundle has been recorded for the key.
+	bool Contains(uint64_t arg_key) const;
+
+	/**
+	* Remove a bundle so it is re-recorded on the next request, e.g. after the buffers it references were recreated.
+	* The caller is responsible for making sure the GPU no longer executes the bundle.
+	*/
+	void Invalidate(uint64_t arg_key);
+	void Clear();
+
+private:
+	struct Entry
+	{
+		Microsoft::WRL::ComPtr<ID3D12CommandAllocator> allocator;
+		Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> bundle;
+	};
+
+	Microsoft::WRL::ComPtr<ID3D12Device2> d3d12_device_;
+	std::unordered_map<uint64_t, Entry> bundles_;
+};
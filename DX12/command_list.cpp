@@ -0,0 +1,76 @@
+#include <command_list.h>
+#include <helpers.h>
+
+CommandList::CommandList(Microsoft::WRL::ComPtr<ID3D12Device2> arg_device, D3D12_COMMAND_LIST_TYPE arg_type)
+	: command_list_type_(arg_type)
+{
+	ThrowIfFailed(arg_device->CreateCommandAllocator(command_list_type_, IID_PPV_ARGS(&d3d12_command_allocator_)));
+	ThrowIfFailed(arg_device->CreateCommandList(0, command_list_type_, d3d12_command_allocator_.Get(),
+				  nullptr, IID_PPV_ARGS(&d3d12_command_list_)));
+}
+
+CommandList::~CommandList()
+{ }
+
+D3D12_COMMAND_LIST_TYPE CommandList::GetCommandListType() const
+{
+	return command_list_type_;
+}
+
+const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2>& CommandList::GetGraphicsCommandList() const
+{
+	return d3d12_command_list_;
+}
+
+void CommandList::TransitionBarrier(ID3D12Resource* arg_resource, D3D12_RESOURCE_STATES arg_before_state, D3D12_RESOURCE_STATES arg_after_state, UINT arg_subresource)
+{
+	D3D12_RESOURCE_BARRIER barrier = { };
+	barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+	barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+	barrier.Transition.pResource = arg_resource;
+	barrier.Transition.StateBefore = arg_before_state;
+	barrier.Transition.StateAfter = arg_after_state;
+	barrier.Transition.Subresource = arg_subresource;
+
+	pending_barriers_.push_back(barrier);
+}
+
+void CommandList::AliasingBarrier(ID3D12Resource* arg_before_resource, ID3D12Resource* arg_after_resource)
+{
+	D3D12_RESOURCE_BARRIER barrier = { };
+	barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+	barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+	barrier.Aliasing.pResourceBefore = arg_before_resource;
+	barrier.Aliasing.pResourceAfter = arg_after_resource;
+
+	pending_barriers_.push_back(barrier);
+}
+
+void CommandList::FlushResourceBarriers()
+{
+	if (!pending_barriers_.empty())
+	{
+		d3d12_command_list_->ResourceBarrier(static_cast<UINT>(pending_barriers_.size()), pending_barriers_.data());
+		pending_barriers_.clear();
+	}
+}
+
+void CommandList::TrackResource(Microsoft::WRL::ComPtr<ID3D12Object> arg_object)
+{
+	tracked_objects_.push_back(std::move(arg_object));
+}
+
+void CommandList::Close()
+{
+	FlushResourceBarriers();
+	ThrowIfFailed(d3d12_command_list_->Close());
+}
+
+void CommandList::Reset()
+{
+	ThrowIfFailed(d3d12_command_allocator_->Reset());
+	ThrowIfFailed(d3d12_command_list_->Reset(d3d12_command_allocator_.Get(), nullptr));
+
+	tracked_objects_.clear();
+	pending_barriers_.clear();
+}
@@ -0,0 +1,57 @@
+/**
+* A command list owns its command allocator, the objects it references and the resource
+* barriers that still have to be recorded. Command lists are handed out and recycled by
+* the CommandQueue they were created for.
+*/
+#pragma once
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <vector>
+
+class CommandList
+{
+public:
+	CommandList(Microsoft::WRL::ComPtr<ID3D12Device2> arg_device, D3D12_COMMAND_LIST_TYPE arg_type);
+	virtual ~CommandList();
+
+	D3D12_COMMAND_LIST_TYPE GetCommandListType() const;
+
+	// Get the D3D12 command list to record commands into.
+	const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2>& GetGraphicsCommandList() const;
+
+	/**
+	* Queue a transition barrier. Queued barriers are recorded in a single ResourceBarrier call
+	* by FlushResourceBarriers, or when the command list is closed.
+	*/
+	void TransitionBarrier(ID3D12Resource* arg_resource, D3D12_RESOURCE_STATES arg_before_state, D3D12_RESOURCE_STATES arg_after_state,
+						   UINT arg_subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES);
+
+	/**
+	* Queue an aliasing barrier between two placed resources that share heap memory. A null
+	* before resource means any resource that shared the memory.
+	*/
+	void AliasingBarrier(ID3D12Resource* arg_before_resource, ID3D12Resource* arg_after_resource);
+
+	// Record all queued barriers.
+	void FlushResourceBarriers();
+
+	// Keep an object alive until the command list has finished executing on the GPU.
+	void TrackResource(Microsoft::WRL::ComPtr<ID3D12Object> arg_object);
+
+	// Flush the queued barriers and close the command list for execution.
+	void Close();
+
+	// Reset the allocator and the command list so they can be recorded again and release all tracked objects.
+	// Only call this once the GPU has finished executing the command list.
+	void Reset();
+
+private:
+	D3D12_COMMAND_LIST_TYPE command_list_type_;
+	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> d3d12_command_allocator_;
+	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> d3d12_command_list_;
+
+	std::vector<D3D12_RESOURCE_BARRIER> pending_barriers_;
+	std::vector<Microsoft::WRL::ComPtr<ID3D12Object>> tracked_objects_;
+};
@@ -1,6 +1,8 @@
 #include <command_queue.h>
+#include <command_list.h>
 #include <helpers.h>
 
+#include <algorithm>
 #include <cassert>
 
 CommandQueue::CommandQueue(Microsoft::WRL::ComPtr<ID3D12Device2> arg_device, D3D12_COMMAND_LIST_TYPE arg_type)
@@ -24,80 +26,41 @@ CommandQueue::CommandQueue(Microsoft::WRL::ComPtr<ID3D12Device2> arg_device, D3D
 CommandQueue::~CommandQueue()
 { }
 
-Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CommandQueue::CreateCommandAllocator()
+std::shared_ptr<CommandList> CommandQueue::GetCommandList()
 {
-	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> command_allocator;
-	ThrowIfFailed(d3d12_device_->CreateCommandAllocator(command_list_type_, IID_PPV_ARGS(&command_allocator)));
+	std::shared_ptr<CommandList> command_list;
+	uint64_t completed_fence_value = UpdateCompletedFenceValue();
 
-	return command_allocator;
-}
-
-Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> CommandQueue::CreateCommandList(Microsoft::WRL::ComPtr<ID3D12CommandAllocator> arg_allocator)
-{
-	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> command_list;
-	ThrowIfFailed(d3d12_device_->CreateCommandList(0, command_list_type_, arg_allocator.Get(), nullptr, IID_PPV_ARGS(&command_list)));
-
-	return command_list;
-}
-
-Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> CommandQueue::GetCommandList()
-{
-	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> command_allocator;
-	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> command_list;
+	ReleaseCompletedObjects(completed_fence_value);
 
-	if (!command_allocator_queue_.empty() && IsFenceComplete(command_allocator_queue_.front().fence_value))
+	if (!command_list_queue_.empty() && completed_fence_value >= command_list_queue_.front().fence_value)
 	{
-		command_allocator = command_allocator_queue_.front().command_allocator;
-		command_allocator_queue_.pop();
-
-		ThrowIfFailed(command_allocator->Reset());
-	}
-	else
-	{
-		command_allocator = CreateCommandAllocator();
-	}
-
-	if (!command_list_queue_.empty())
-	{
-		command_list = command_list_queue_.front();
+		command_list = std::move(command_list_queue_.front().command_list);
 		command_list_queue_.pop();
 
-		ThrowIfFailed(command_list->Reset(command_allocator.Get(), nullptr));
+		command_list->Reset();
 	}
 	else
 	{
-		command_list = CreateCommandList(command_allocator);
+		command_list = std::make_shared<CommandList>(d3d12_device_, command_list_type_);
 	}
 
-	// Associate the command allocator with the command list so that it can be
-	// retrieved when the command list is executed.
-	ThrowIfFailed(command_list->SetPrivateDataInterface(__uuidof(ID3D12CommandAllocator), command_allocator.Get()));
-
 	return command_list;
 }
 
-uint64_t CommandQueue::ExecuteCommandList(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> arg_command_list)
+uint64_t CommandQueue::ExecuteCommandList(std::shared_ptr<CommandList> arg_command_list)
 {
 	arg_command_list->Close();
 
-	ID3D12CommandAllocator* command_allocator;
-	UINT data_size = sizeof(command_allocator);
-	ThrowIfFailed(arg_command_list->GetPrivateData(__uuidof(ID3D12CommandAllocator), &data_size, &command_allocator));
-
 	ID3D12CommandList* const command_lists[] = {
-		arg_command_list.Get()
+		arg_command_list->GetGraphicsCommandList().Get()
 	};
 
 	d3d12_command_queue_->ExecuteCommandLists(1, command_lists);
 	uint64_t fence_value = Signal();
 
-	command_allocator_queue_.emplace(CommandAllocatorEntry{fence_value, command_allocator});
-	command_list_queue_.push(arg_command_list);
-
-	// The ownership of the command allocator has been transferred to the ComPtr
-	// in the command allocator queue. It is safe to release the reference 
-	// in this temporary COM pointer here.
-	command_allocator->Release();
+	// The command list keeps its allocator and tracked objects alive until it is recycled.
+	command_list_queue_.push(CommandListEntry{fence_value, std::move(arg_command_list)});
 
 	return fence_value;
 }
@@ -106,29 +69,170 @@ uint64_t CommandQueue::Signal()
 {
 	uint64_t fence_value = ++fence_value_;
 	d3d12_command_queue_->Signal(d3d12_fence_.Get(), fence_value);
+	telemetry_.OnSubmit(fence_value);
+	UpdateCompletedFenceValue();
 	return fence_value;
 }
 
-bool CommandQueue::IsFenceComplete(uint64_t arg_fence_value)
+bool CommandQueue::IsFenceComplete(uint64_t arg_fence_value) const
 {
 	return d3d12_fence_->GetCompletedValue() >= arg_fence_value;
 }
 
+uint64_t CommandQueue::GetCompletedFenceValue() const
+{
+	return d3d12_fence_->GetCompletedValue();
+}
+
+uint64_t CommandQueue::GetLastSignaledFenceValue() const
+{
+	return fence_value_;
+}
+
 void CommandQueue::WaitForFenceValue(uint64_t arg_fence_value)
 {
 	if (!IsFenceComplete(arg_fence_value))
 	{
-		d3d12_fence_->SetEventOnCompletion(arg_fence_value, fence_event_);
-		::WaitForSingleObject(fence_event_, DWORD_MAX);
+		auto wait_start = QueueTelemetry::Clock::now();
+		if (SpinForFenceValue(arg_fence_value))
+		{
+			++wait_stats_.spin_waits;
+			wait_stats_.spin_wait_time += QueueTelemetry::Clock::now() - wait_start;
+		}
+		else
+		{
+			auto block_start = QueueTelemetry::Clock::now();
+			d3d12_fence_->SetEventOnCompletion(arg_fence_value, fence_event_);
+			::WaitForSingleObject(fence_event_, DWORD_MAX);
+			auto wake = QueueTelemetry::Clock::now();
+
+			// The wake latency lasts until the fence reads as complete on this thread.
+			while (!IsFenceComplete(arg_fence_value))
+			{
+				YieldProcessor();
+			}
+			auto wait_end = QueueTelemetry::Clock::now();
+
+			++wait_stats_.blocked_waits;
+			wait_stats_.block_time += wake - block_start;
+			wait_stats_.wake_latency += wait_end - wake;
+			wait_stats_.blocked_wait_time += wait_end - wait_start;
+		}
+		telemetry_.OnCpuWait(arg_fence_value, QueueTelemetry::Clock::now() - wait_start);
+	}
+
+	UpdateCompletedFenceValue();
+}
+
+bool CommandQueue::SpinForFenceValue(uint64_t arg_fence_value)
+{
+	auto deadline = QueueTelemetry::Clock::now() + std::chrono::microseconds(wait_policy_.max_spin_microseconds);
+	uint32_t backoff = wait_policy_.initial_backoff;
+
+	for (uint32_t i = 0; i < wait_policy_.max_spin_iterations; ++i)
+	{
+		for (uint32_t pause = 0; pause < backoff; ++pause)
+		{
+			YieldProcessor();
+		}
+
+		++wait_stats_.spin_iterations;
+		if (IsFenceComplete(arg_fence_value))
+		{
+			return true;
+		}
+		if (QueueTelemetry::Clock::now() >= deadline)
+		{
+			break;
+		}
+
+		backoff = std::min(backoff * 2, wait_policy_.max_backoff);
 	}
+
+	return false;
 }
 
 void CommandQueue::Flush()
 {
 	WaitForFenceValue(Signal());
+	ReleaseCompletedObjects(fence_value_);
+}
+
+void CommandQueue::DeferRelease(Microsoft::WRL::ComPtr<ID3D12Object> arg_object)
+{
+	if (IsFenceComplete(fence_value_))
+	{
+		// The GPU no longer uses the object, so it can be released right away.
+		return;
+	}
+
+	deferred_releases_.push(DeferredReleaseEntry{fence_value_, std::move(arg_object)});
+}
+
+void CommandQueue::ReleaseCompletedObjects(uint64_t arg_completed_fence_value)
+{
+	while (!deferred_releases_.empty() && deferred_releases_.front().fence_value <= arg_completed_fence_value)
+	{
+		deferred_releases_.pop();
+	}
+}
+
+void CommandQueue::Wait(const CommandQueue& arg_other, uint64_t arg_fence_value)
+{
+	// Work on the same queue is already executed in submission order.
+	if (&arg_other == this || arg_other.IsFenceComplete(arg_fence_value))
+	{
+		return;
+	}
+
+	uint64_t& waited_value = waited_fence_values_[&arg_other];
+	if (waited_value >= arg_fence_value)
+	{
+		return;
+	}
+
+	ThrowIfFailed(d3d12_command_queue_->Wait(arg_other.d3d12_fence_.Get(), arg_fence_value));
+	waited_value = arg_fence_value;
 }
 
 Microsoft::WRL::ComPtr<ID3D12CommandQueue> CommandQueue::GetD3D12CommandQueue() const
 {
 	return d3d12_command_queue_;
 }
+
+void CommandQueue::SetWaitPolicy(const FenceWaitPolicy& arg_policy)
+{
+	wait_policy_ = arg_policy;
+}
+
+const FenceWaitPolicy& CommandQueue::GetWaitPolicy() const
+{
+	return wait_policy_;
+}
+
+const FenceWaitStats& CommandQueue::GetWaitStats() const
+{
+	return wait_stats_;
+}
+
+void CommandQueue::ResetWaitStats()
+{
+	wait_stats_ = FenceWaitStats();
+}
+
+const QueueTelemetry& CommandQueue::GetTelemetry() const
+{
+	return telemetry_;
+}
+
+QueueTelemetry& CommandQueue::GetTelemetry()
+{
+	return telemetry_;
+}
+
+uint64_t CommandQueue::UpdateCompletedFenceValue()
+{
+	uint64_t completed_value = d3d12_fence_->GetCompletedValue();
+	telemetry_.OnCompleted(completed_value);
+	return completed_value;
+}
@@ -1,11 +1,47 @@
 #pragma once
 
+#include <queue_telemetry.h>
+
 #include <d3d12.h>  // For ID3D12CommandQueue, ID3D12Device2, and ID3D12Fence
 #include <wrl.h>    // For Microsoft::WRL::ComPtr
 
 #include <cstdint>  // For uint64_t
+#include <map>      // For std::map
+#include <memory>   // For std::shared_ptr
 #include <queue>    // For std::queue
 
+class CommandList;
+
+// Controls how a CPU thread waits for a fence value. The waiter first polls the fence
+// with an exponentially growing number of pause instructions between polls and only
+// blocks on the fence event when the spin budget is exhausted.
+struct FenceWaitPolicy
+{
+	// Maximum number of fence polls before blocking. 0 always blocks immediately.
+	uint32_t max_spin_iterations = 64;
+	// Maximum time spent spinning before blocking, in microseconds.
+	uint32_t max_spin_microseconds = 50;
+	// Pause instructions between the first two polls, doubled after every poll.
+	uint32_t initial_backoff = 1;
+	uint32_t max_backoff = 256;
+};
+
+// Counters for the waits performed by a command queue.
+struct FenceWaitStats
+{
+	uint64_t spin_waits = 0;      // Waits satisfied while spinning.
+	uint64_t blocked_waits = 0;   // Waits that fell back to the fence event.
+	uint64_t spin_iterations = 0; // Total number of fence polls.
+	// Total time spent in each kind of wait. For blocked waits this includes the spin
+	// that preceded the block and the kernel wake-up latency.
+	std::chrono::high_resolution_clock::duration spin_wait_time = { };
+	std::chrono::high_resolution_clock::duration blocked_wait_time = { };
+	// The parts of the blocked waits after the spin: the time from arming the fence event
+	// until the wait on it returns, and from that return until the fence reads as complete.
+	std::chrono::high_resolution_clock::duration block_time = { };
+	std::chrono::high_resolution_clock::duration wake_latency = { };
+};
+
 class CommandQueue
 {
 public:
@@ -13,33 +49,64 @@ public:
 	virtual ~CommandQueue();
 
 	// Get an available command list from the command queue.
-	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> GetCommandList();
+	std::shared_ptr<CommandList> GetCommandList();
 
 	// Execute a command list.
 	// Returns the fence value to wait for for this command list.
-	uint64_t ExecuteCommandList(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> arg_command_list);
+	uint64_t ExecuteCommandList(std::shared_ptr<CommandList> arg_command_list);
 
 	uint64_t Signal();
-	bool IsFenceComplete(uint64_t arg_fence_value);
+	bool IsFenceComplete(uint64_t arg_fence_value) const;
+	uint64_t GetCompletedFenceValue() const;
+	// The fence value of the last Signal, i.e. of the most recent submission.
+	uint64_t GetLastSignaledFenceValue() const;
 	void WaitForFenceValue(uint64_t arg_fence_value);
 	void Flush();
 
+	// Make this queue wait on the GPU until another queue's fence reaches the given value.
+	// Waits that are already satisfied, or implied by an earlier wait, are skipped.
+	void Wait(const CommandQueue& arg_other, uint64_t arg_fence_value);
+
+	// Keep an object alive until all work submitted to this queue so far has finished on the GPU.
+	void DeferRelease(Microsoft::WRL::ComPtr<ID3D12Object> arg_object);
+
 	Microsoft::WRL::ComPtr<ID3D12CommandQueue> GetD3D12CommandQueue() const;
 
+	void SetWaitPolicy(const FenceWaitPolicy& arg_policy);
+	const FenceWaitPolicy& GetWaitPolicy() const;
+	const FenceWaitStats& GetWaitStats() const;
+	void ResetWaitStats();
+
+	// Submit latency and CPU stall statistics for the fence values handed out by this queue.
+	const QueueTelemetry& GetTelemetry() const;
+	QueueTelemetry& GetTelemetry();
+
 protected:
-	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CreateCommandAllocator();
-	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> CreateCommandList(Microsoft::WRL::ComPtr<ID3D12CommandAllocator> arg_allocator);
+	// Read the completed fence value and report it to the telemetry.
+	uint64_t UpdateCompletedFenceValue();
+
+	// Poll the fence according to the wait policy. Returns true if the fence completed while spinning.
+	bool SpinForFenceValue(uint64_t arg_fence_value);
+
+	// Release the deferred objects whose fence value has completed.
+	void ReleaseCompletedObjects(uint64_t arg_completed_fence_value);
 
 private:
-	// Keep track of command allocators that are "in-flight"
-	struct CommandAllocatorEntry
+	// Keep track of command lists (and the allocators they own) that are "in-flight"
+	struct CommandListEntry
 	{
 		uint64_t fence_value;
-		Microsoft::WRL::ComPtr<ID3D12CommandAllocator> command_allocator;
+		std::shared_ptr<CommandList> command_list;
 	};
 
-	using CommandAllocatorQueue = std::queue<CommandAllocatorEntry>;
-	using CommandListQueue = std::queue< Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> >;
+	using CommandListQueue = std::queue<CommandListEntry>;
+
+	// An object that is released once the fence value has completed.
+	struct DeferredReleaseEntry
+	{
+		uint64_t fence_value;
+		Microsoft::WRL::ComPtr<ID3D12Object> object;
+	};
 
 	D3D12_COMMAND_LIST_TYPE                     command_list_type_;
 	Microsoft::WRL::ComPtr<ID3D12Device2>       d3d12_device_;
@@ -48,6 +115,13 @@ private:
 	HANDLE                                      fence_event_;
 	uint64_t                                    fence_value_;
 
-	CommandAllocatorQueue                       command_allocator_queue_;
 	CommandListQueue                            command_list_queue_;
+	std::queue<DeferredReleaseEntry>            deferred_releases_;
+
+	// Highest fence value this queue already waits for, per other queue.
+	std::map<const CommandQueue*, uint64_t>     waited_fence_values_;
+
+	QueueTelemetry                              telemetry_;
+	FenceWaitPolicy                             wait_policy_;
+	FenceWaitStats                              wait_stats_;
 };
\ No newline at end of file
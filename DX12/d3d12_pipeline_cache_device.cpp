@@ -0,0 +1,88 @@
+#include <d3d12_pipeline_cache_device.h>
+#include <hash.h>
+#include <helpers.h>
+
+#include <d3dx12.h>
+
+#include <cstring>
+
+D3D12PipelineCacheDevice::D3D12PipelineCacheDevice(Microsoft::WRL::ComPtr<ID3D12Device2> arg_device, Microsoft::WRL::ComPtr<IDXGIAdapter1> arg_adapter)
+	: d3d12_device_(arg_device)
+	, dxgi_adapter_(arg_adapter)
+{ }
+
+bool D3D12PipelineCacheDevice::GetCompatibilityKey(uint64_t& arg_key)
+{
+	DXGI_ADAPTER_DESC1 adapter_desc;
+	if (FAILED(dxgi_adapter_->GetDesc1(&adapter_desc)))
+	{
+		return false;
+	}
+
+	// The user mode driver version. Without it a blob could be handed to a driver that did not compile it.
+	LARGE_INTEGER driver_version;
+	if (FAILED(dxgi_adapter_->CheckInterfaceSupport(__uuidof(IDXGIDevice), &driver_version)))
+	{
+		return false;
+	}
+
+	uint64_t key = HashValue(adapter_desc.VendorId);
+	key = HashValue(adapter_desc.DeviceId, key);
+	key = HashValue(adapter_desc.SubSysId, key);
+	key = HashValue(adapter_desc.Revision, key);
+	arg_key = HashValue(driver_version.QuadPart, key);
+
+	return true;
+}
+
+HRESULT D3D12PipelineCacheDevice::SerializeRootSignature(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& arg_desc, D3D_ROOT_SIGNATURE_VERSION arg_highest_version,
+														 std::vector<uint8_t>& arg_blob)
+{
+	Microsoft::WRL::ComPtr<ID3DBlob> root_signature_blob;
+	Microsoft::WRL::ComPtr<ID3DBlob> error_blob;
+	HRESULT result = D3DX12SerializeVersionedRootSignature(&arg_desc, arg_highest_version, &root_signature_blob, &error_blob);
+	if (FAILED(result))
+	{
+		return result;
+	}
+
+	const uint8_t* data = static_cast<const uint8_t*>(root_signature_blob->GetBufferPointer());
+	arg_blob.assign(data, data + root_signature_blob->GetBufferSize());
+
+	return S_OK;
+}
+
+HRESULT D3D12PipelineCacheDevice::CreateRootSignature(const void* arg_blob, size_t arg_size, Microsoft::WRL::ComPtr<ID3D12RootSignature>& arg_root_signature)
+{
+	return d3d12_device_->CreateRootSignature(0, arg_blob, arg_size, IID_PPV_ARGS(&arg_root_signature));
+}
+
+HRESULT D3D12PipelineCacheDevice::CreatePipelineState(const D3D12_PIPELINE_STATE_STREAM_DESC& arg_desc, const D3D12_CACHED_PIPELINE_STATE* arg_cached_blob,
+													  Microsoft::WRL::ComPtr<ID3D12PipelineState>& arg_pipeline_state)
+{
+	if (!arg_cached_blob)
+	{
+		return d3d12_device_->CreatePipelineState(&arg_desc, IID_PPV_ARGS(&arg_pipeline_state));
+	}
+
+	// Append the cached blob to a copy of the stream. Subobjects are aligned to pointers.
+	const size_t cached_offset = (arg_desc.SizeInBytes + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+	const size_t stream_size = cached_offset + sizeof(CD3DX12_PIPELINE_STATE_STREAM_CACHED_PSO);
+	std::vector<void*> stream((stream_size + sizeof(void*) - 1) / sizeof(void*));
+
+	BYTE* stream_bytes = reinterpret_cast<BYTE*>(stream.data());
+	memcpy(stream_bytes, arg_desc.pPipelineStateSubobjectStream, arg_desc.SizeInBytes);
+	new (stream_bytes + cached_offset) CD3DX12_PIPELINE_STATE_STREAM_CACHED_PSO(*arg_cached_blob);
+
+	D3D12_PIPELINE_STATE_STREAM_DESC desc = { stream_size, stream_bytes };
+	return d3d12_device_->CreatePipelineState(&desc, IID_PPV_ARGS(&arg_pipeline_state));
+}
+
+void D3D12PipelineCacheDevice::GetCachedBlob(ID3D12PipelineState* arg_pipeline_state, std::vector<uint8_t>& arg_blob)
+{
+	Microsoft::WRL::ComPtr<ID3DBlob> blob;
+	ThrowIfFailed(arg_pipeline_state->GetCachedBlob(&blob));
+
+	const uint8_t* data = static_cast<const uint8_t*>(blob->GetBufferPointer());
+	arg_blob.assign(data, data + blob->GetBufferSize());
+}
@@ -0,0 +1,30 @@
+/**
+* The pipeline cache device for D3D12. It lives apart from the pipeline cache because it needs
+* D3DX12 and the D3D12 runtime, which the cache and its simulated device do not.
+*/
+#pragma once
+
+#include <pipeline_cache.h>
+
+#include <d3d12.h>
+#include <dxgi.h>
+#include <wrl.h>
+
+// Forwards to a D3D12 device. The compatibility key is made from the adapter's identity and driver version.
+class D3D12PipelineCacheDevice : public PipelineCacheDevice
+{
+public:
+	D3D12PipelineCacheDevice(Microsoft::WRL::ComPtr<ID3D12Device2> arg_device, Microsoft::WRL::ComPtr<IDXGIAdapter1> arg_adapter);
+
+	virtual bool GetCompatibilityKey(uint64_t& arg_key) override;
+	virtual HRESULT SerializeRootSignature(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& arg_desc, D3D_ROOT_SIGNATURE_VERSION arg_highest_version,
+										   std::vector<uint8_t>& arg_blob) override;
+	virtual HRESULT CreateRootSignature(const void* arg_blob, size_t arg_size, Microsoft::WRL::ComPtr<ID3D12RootSignature>& arg_root_signature) override;
+	virtual HRESULT CreatePipelineState(const D3D12_PIPELINE_STATE_STREAM_DESC& arg_desc, const D3D12_CACHED_PIPELINE_STATE* arg_cached_blob,
+										Microsoft::WRL::ComPtr<ID3D12PipelineState>& arg_pipeline_state) override;
+	virtual void GetCachedBlob(ID3D12PipelineState* arg_pipeline_state, std::vector<uint8_t>& arg_blob) override;
+
+private:
+	Microsoft::WRL::ComPtr<ID3D12Device2> d3d12_device_;
+	Microsoft::WRL::ComPtr<IDXGIAdapter1> dxgi_adapter_;
+};
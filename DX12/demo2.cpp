@@ -1,16 +1,23 @@
 #include <demo2.h>
 #include <application.h>
+#include <command_list.h>
 #include <command_queue.h>
+#include <gpu_memory_tracker.h>
 #include <helpers.h>
+#include <pipeline_cache.h>
+#include <shader_archive.h>
+#include <texture_allocator.h>
+#include <texture_cooker.h>
+#include <texture_file.h>
 #include <window.h>
 
 #include <wrl.h>
 using namespace Microsoft::WRL;
 
 #include <d3dx12.h>
-#include <d3dcompiler.h>
 
 #include <algorithm> // For std::min and std::max.
+#include <cassert>
 #if defined(min)
 #undef min
 #endif
@@ -85,6 +92,12 @@ static XMFLOAT3 g_colors[8] = {
 	 XMFLOAT3(1.0f, 0.0f, 1.0f)
 };
 
+// Keys of the bundles recorded by this demo.
+enum BundleKey : uint64_t
+{
+	BUNDLE_KEY_CUBE = 0,
+};
+
 static WORD g_indicies[36] =
 {
 	0, 1, 2, 0, 2, 3,
@@ -103,95 +116,107 @@ Demo2::Demo2(Application &arg_app, const std::wstring& arg_name, int arg_width,
 	, content_loaded_(false)
 { }
 
-void Demo2::TransitionResource(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> arg_command_list, Microsoft::WRL::ComPtr<ID3D12Resource> arg_resource, D3D12_RESOURCE_STATES arg_before_state, D3D12_RESOURCE_STATES arg_after_state)
+void Demo2::TransitionResource(std::shared_ptr<CommandList> arg_command_list, Microsoft::WRL::ComPtr<ID3D12Resource> arg_resource, D3D12_RESOURCE_STATES arg_before_state, D3D12_RESOURCE_STATES arg_after_state)
 {
-	CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
-		arg_resource.Get(),
-		arg_before_state, arg_after_state);
-
-	arg_command_list->ResourceBarrier(1, &barrier);
-
+	arg_command_list->TransitionBarrier(arg_resource.Get(), arg_before_state, arg_after_state);
 }
 
-void Demo2::ClearRTV(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> arg_command_list, D3D12_CPU_DESCRIPTOR_HANDLE arg_rtv, FLOAT * arg_clear_color)
+void Demo2::ClearRTV(std::shared_ptr<CommandList> arg_command_list, D3D12_CPU_DESCRIPTOR_HANDLE arg_rtv, FLOAT * arg_clear_color)
 {
-	arg_command_list->ClearRenderTargetView(arg_rtv, arg_clear_color, 0, nullptr);
+	arg_command_list->FlushResourceBarriers();
+	arg_command_list->GetGraphicsCommandList()->ClearRenderTargetView(arg_rtv, arg_clear_color, 0, nullptr);
 }
 
-void Demo2::ClearDepth(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> arg_command_list, D3D12_CPU_DESCRIPTOR_HANDLE arg_dsv, FLOAT arg_depth)
+void Demo2::ClearDepth(std::shared_ptr<CommandList> arg_command_list, D3D12_CPU_DESCRIPTOR_HANDLE arg_dsv, FLOAT arg_depth)
 {
-	arg_command_list->ClearDepthStencilView(arg_dsv, D3D12_CLEAR_FLAG_DEPTH, arg_depth, 0, 0, nullptr);
+	arg_command_list->FlushResourceBarriers();
+	arg_command_list->GetGraphicsCommandList()->ClearDepthStencilView(arg_dsv, D3D12_CLEAR_FLAG_DEPTH, arg_depth, 0, 0, nullptr);
 }
 
 void Demo2::UpdateBufferResource(
-	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> arg_command_list,
-	ID3D12Resource** arg_destination_resource, ID3D12Resource** arg_intermediate_resource,
+	HeapAllocation& arg_destination,
 	size_t arg_num_elements, size_t arg_element_size,
 	const void* arg_buffer_data,
 	D3D12_RESOURCE_FLAGS arg_flags)
 {
-	auto device = app_->GetDevice();
-
 	size_t buffer_size = arg_num_elements * arg_element_size;
 
-	// Create a committed resource for the GPU resource in a default heap.
-	ThrowIfFailed(device->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-		D3D12_HEAP_FLAG_NONE,
-		&CD3DX12_RESOURCE_DESC::Buffer(buffer_size, arg_flags),
-		D3D12_RESOURCE_STATE_COPY_DEST,
-		nullptr,
-		IID_PPV_ARGS(arg_destination_resource)));
+	// Place the GPU resource in one of the default heap blocks. Buffers start in the
+	// common state so they can be written on the copy queue and read on the direct queue.
+	arg_destination = app_->GetHeapAllocator().CreateResource(
+		CD3DX12_RESOURCE_DESC::Buffer(buffer_size, arg_flags),
+		D3D12_RESOURCE_STATE_COMMON);
 
-	// Create an committed resource for the upload.
+	// Record the copy on the copy queue.
 	if (arg_buffer_data)
 	{
-		ThrowIfFailed(device->CreateCommittedResource(
-			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-			D3D12_HEAP_FLAG_NONE,
-			&CD3DX12_RESOURCE_DESC::Buffer(buffer_size),
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-			nullptr,
-			IID_PPV_ARGS(arg_intermediate_resource)));
-
-		D3D12_SUBRESOURCE_DATA subresource_data = { };
-		subresource_data.pData = arg_buffer_data;
-		subresource_data.RowPitch = buffer_size;
-		subresource_data.SlicePitch = subresource_data.RowPitch;
-
-		UpdateSubresources(arg_command_list.Get(),
-						   *arg_destination_resource, *arg_intermediate_resource,
-						   0, 0, 1, &subresource_data);
+		app_->GetUploadManager().UploadBuffer(arg_destination.resource.Get(), 0, arg_buffer_data, buffer_size);
 	}
 }
 
+bool Demo2::RecordCubeBundle()
+{
+	if (cube_bundle_)
+	{
+		return true;
+	}
+
+	if (!pipeline_state_->IsReady())
+	{
+		return false;
+	}
+
+	// Record the static part of the cube draw into a bundle. The MVP constant buffer view is
+	// set on the direct command list every frame and inherited by the bundle.
+	cube_bundle_ = bundle_cache_->GetOrRecord(BUNDLE_KEY_CUBE, pipeline_state_->Get().Get(), [this](ID3D12GraphicsCommandList2* arg_bundle)
+	{
+		arg_bundle->SetGraphicsRootSignature(root_signature_.Get());
+		arg_bundle->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		arg_bundle->IASetVertexBuffers(0, 1, &vertex_buffer_view_);
+		arg_bundle->IASetIndexBuffer(&index_buffer_view_);
+		arg_bundle->DrawIndexedInstanced(_countof(g_indicies), 1, 0, 0, 0);
+	});
+
+	return true;
+}
+
 void Demo2::ResizeDepthBuffer(int arg_width, int arg_height)
 {
 	if (content_loaded_)
 	{
-		// Flush any GPU commands that might be referencing the depth buffer.
-		app_->Flush();
-
 		arg_width = std::max(1, arg_width);
 		arg_height = std::max(1, arg_height);
 
 		auto device = app_->GetDevice();
 
-		// Resize screen dependent resources.
+		// Resize screen dependent resources. The depth buffer is used by the only pass of the frame.
 		// Create a depth buffer.
 		D3D12_CLEAR_VALUE optimized_clear_value = { };
 		optimized_clear_value.Format = DXGI_FORMAT_D32_FLOAT;
 		optimized_clear_value.DepthStencil = {1.0f, 0};
 
-		ThrowIfFailed(device->CreateCommittedResource(
-			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-			D3D12_HEAP_FLAG_NONE,
-			&CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_D32_FLOAT, arg_width, arg_height,
+		transient_pool_->Clear();
+		depth_buffer_ = transient_pool_->Declare(
+			CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_D32_FLOAT, arg_width, arg_height,
 			1, 0, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL),
 			D3D12_RESOURCE_STATE_DEPTH_WRITE,
-			&optimized_clear_value,
-			IID_PPV_ARGS(&depth_buffer_)
-		));
+			&optimized_clear_value, 0, 0);
+
+		// Frames in flight may still use the old depth buffer, so it is released once they finish.
+		std::vector<ComPtr<ID3D12Object>> retired_objects;
+		transient_pool_->Compile(retired_objects);
+
+		GpuMemoryTracker& gpu_memory_tracker = app_->GetGpuMemoryTracker();
+		auto command_queue = app_->GetCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT);
+		for (auto& object : retired_objects)
+		{
+			gpu_memory_tracker.Unregister(object.Get());
+			command_queue->DeferRelease(object);
+		}
+
+		ID3D12Resource* depth_buffer = transient_pool_->GetResource(depth_buffer_);
+		TRACK_PLACED_GPU_MEMORY(gpu_memory_tracker, depth_buffer, "DepthBuffer",
+								GpuMemoryTracker::GetAllocationSize(device.Get(), depth_buffer));
 
 		// Update the depth-stencil view.
 		D3D12_DEPTH_STENCIL_VIEW_DESC dsv = { };
@@ -200,53 +225,52 @@ void Demo2::ResizeDepthBuffer(int arg_width, int arg_height)
 		dsv.Texture2D.MipSlice = 0;
 		dsv.Flags = D3D12_DSV_FLAG_NONE;
 
-		device->CreateDepthStencilView(depth_buffer_.Get(), &dsv,
-									   dsv_heap_->GetCPUDescriptorHandleForHeapStart());
+		device->CreateDepthStencilView(depth_buffer, &dsv,
+									   dsv_.GetDescriptorHandle());
 	}
 }
 
 bool Demo2::LoadContent()
 {
 	auto device = app_->GetDevice();
-	auto command_queue = app_->GetCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT);
-	auto command_list = command_queue->GetCommandList();
+	UploadManager& upload_manager = app_->GetUploadManager();
+
+	// The pixel shader indexes an unbounded texture array, which requires resource binding tier 2.
+	// Check before anything is created, so nothing has to be released on failure.
+	D3D12_FEATURE_DATA_D3D12_OPTIONS options = { };
+	if (FAILED(device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options))) ||
+		options.ResourceBindingTier < D3D12_RESOURCE_BINDING_TIER_2)
+	{
+		MessageBoxA(NULL, "The bindless texture table requires a GPU with resource binding tier 2 or higher.", "Error", MB_OK | MB_ICONERROR);
+		return false;
+	}
 
 	// Upload vertex pos buffer data.
-	ComPtr<ID3D12Resource> intermediate_vertex_buffer;
-	UpdateBufferResource(command_list.Get(),
-						 &vertex_buffer_, &intermediate_vertex_buffer,
+	UpdateBufferResource(vertex_buffer_,
 						 _countof(g_vertices), sizeof(Vertex), g_vertices);
+	TRACK_PLACED_GPU_MEMORY(app_->GetGpuMemoryTracker(), vertex_buffer_.resource.Get(), "VertexBuffer", vertex_buffer_.size);
 
 	// Create the vertex pos buffer view.
-	vertex_buffer_view_.BufferLocation = vertex_buffer_->GetGPUVirtualAddress();
+	vertex_buffer_view_.BufferLocation = vertex_buffer_.resource->GetGPUVirtualAddress();
 	vertex_buffer_view_.SizeInBytes = sizeof(g_vertices);
 	vertex_buffer_view_.StrideInBytes = sizeof(Vertex);
 
 	// Upload index buffer data.
-	ComPtr<ID3D12Resource> intermediate_index_buffer;
-	UpdateBufferResource(command_list.Get(),
-						 &index_buffer_, &intermediate_index_buffer,
+	UpdateBufferResource(index_buffer_,
 						 _countof(g_indicies), sizeof(WORD), g_indicies);
+	TRACK_PLACED_GPU_MEMORY(app_->GetGpuMemoryTracker(), index_buffer_.resource.Get(), "IndexBuffer", index_buffer_.size);
 
 	// Create the index buffer view.
-	index_buffer_view_.BufferLocation = index_buffer_->GetGPUVirtualAddress();
+	index_buffer_view_.BufferLocation = index_buffer_.resource->GetGPUVirtualAddress();
 	index_buffer_view_.SizeInBytes = sizeof(g_indicies);
 	index_buffer_view_.Format = DXGI_FORMAT_R16_UINT;
 
-	// Create the descriptor heap for the depth-stencil view.
-	D3D12_DESCRIPTOR_HEAP_DESC dsv_heap_desc = { };
-	dsv_heap_desc.NumDescriptors = 1;
-	dsv_heap_desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
-	dsv_heap_desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-	ThrowIfFailed(device->CreateDescriptorHeap(&dsv_heap_desc, IID_PPV_ARGS(&dsv_heap_)));
+	// Allocate the descriptor for the depth-stencil view.
+	dsv_ = app_->AllocateDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
 
-	// Load the vertex shader.
-	ComPtr<ID3DBlob> vertex_shader_blob;
-	ThrowIfFailed(D3DReadFileToBlob(L"VertexShader.cso", &vertex_shader_blob));
-
-	// Load the pixel shader.
-	ComPtr<ID3DBlob> pixel_shader_blob;
-	ThrowIfFailed(D3DReadFileToBlob(L"PixelShader.cso", &pixel_shader_blob));
+	// The bytecode points into the mapped shader archive, so it is neither read nor copied.
+	D3D12_SHADER_BYTECODE vertex_shader = app_->GetShaderArchive().GetShader("VertexShader");
+	D3D12_SHADER_BYTECODE pixel_shader = app_->GetShaderArchive().GetShader("PixelShader");
 
 	D3D12_INPUT_ELEMENT_DESC input_layout[] = {
 		{"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
@@ -270,23 +294,25 @@ bool Demo2::LoadContent()
 
 	// ========= TEXTURE STUFF =========
 
-	// create a descriptor range (descriptor table) and fill it out
-	// this is a range of descriptors inside a descriptor heap
-	CD3DX12_DESCRIPTOR_RANGE1  descriptor_table_ranges[1]; // only one range right now
-	descriptor_table_ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);
+	// One unbounded range over the whole bindless table. Shaders index it with the indices of the views,
+	// so it is bound once per frame. Slots that are not in use are not initialized, hence volatile.
+	CD3DX12_DESCRIPTOR_RANGE1  descriptor_table_ranges[1];
+	descriptor_table_ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, UINT_MAX, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE);
 
 	// ========= ENDS TEXTURE STUFF =========
 
-	// A single 32-bit constant root parameter that is used by the vertex shader.
-	CD3DX12_ROOT_PARAMETER1 root_parameters[2];
-	root_parameters[0].InitAsConstants(sizeof(XMMATRIX) / 4, 0);
-	root_parameters[1].InitAsDescriptorTable(_countof(descriptor_table_ranges), descriptor_table_ranges);
+	// A root constant buffer view for the per-object constants used by the vertex shader, and a root
+	// constant with the bindless index of the material's texture used by the pixel shader.
+	CD3DX12_ROOT_PARAMETER1 root_parameters[3];
+	root_parameters[0].InitAsConstantBufferView(0, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE);
+	root_parameters[1].InitAsConstants(1, 1, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+	root_parameters[2].InitAsDescriptorTable(_countof(descriptor_table_ranges), descriptor_table_ranges, D3D12_SHADER_VISIBILITY_PIXEL);
 
 	// ========= TEXTURE STUFF =========
 
 	// create a static sampler
 	D3D12_STATIC_SAMPLER_DESC sampler_desc = {};
-	sampler_desc.Filter = D3D12_FILTER_MIN_MAG_MIP_POINT;
+	sampler_desc.Filter = D3D12_FILTER_MIN_LINEAR_MAG_POINT_MIP_LINEAR; // Blend between the cooked mips when minified
 	sampler_desc.AddressU = D3D12_TEXTURE_ADDRESS_MODE_BORDER;
 	sampler_desc.AddressV = D3D12_TEXTURE_ADDRESS_MODE_BORDER;
 	sampler_desc.AddressW = D3D12_TEXTURE_ADDRESS_MODE_BORDER;
@@ -309,15 +335,9 @@ bool Demo2::LoadContent()
 										// ========= ENDS TEXTURE STUFF =========
 										root_signature_flags);
 
-	// Serialize the root signature.
-	ComPtr<ID3DBlob> root_signature_blob;
-	ComPtr<ID3DBlob> error_blob;
-	ThrowIfFailed(D3DX12SerializeVersionedRootSignature(&root_signature_description,
-				  feature_data.HighestVersion, &root_signature_blob, &error_blob));
-
-	// Create the root signature.
-	ThrowIfFailed(device->CreateRootSignature(0, root_signature_blob->GetBufferPointer(),
-				  root_signature_blob->GetBufferSize(), IID_PPV_ARGS(&root_signature_)));
+	// Serialize and create the root signature, or reuse the one created for the same description.
+	PipelineCache& pipeline_cache = app_->GetPipelineCache();
+	root_signature_ = pipeline_cache.GetRootSignature(root_signature_description, feature_data.HighestVersion);
 
 	struct PipelineStateStream
 	{
@@ -340,8 +360,8 @@ bool Demo2::LoadContent()
 	pipeline_state_stream.input_layout = {input_layout, _countof(input_layout)};
 	pipeline_state_stream.primitive_topology_type = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
 	pipeline_state_stream.rasterizer = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
-	pipeline_state_stream.vs = CD3DX12_SHADER_BYTECODE(vertex_shader_blob.Get());
-	pipeline_state_stream.ps = CD3DX12_SHADER_BYTECODE(pixel_shader_blob.Get());
+	pipeline_state_stream.vs = vertex_shader;
+	pipeline_state_stream.ps = pixel_shader;
 	pipeline_state_stream.dsv_format = DXGI_FORMAT_D32_FLOAT;
 	pipeline_state_stream.rtv_formats = rtv_formats;
 	pipeline_state_stream.blend_desc = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
@@ -349,96 +369,81 @@ bool Demo2::LoadContent()
 	D3D12_PIPELINE_STATE_STREAM_DESC pipeline_state_stream_desc = {
 		sizeof(PipelineStateStream), &pipeline_state_stream
 	};
-	HRESULT hr = device->CreatePipelineState(&pipeline_state_stream_desc, IID_PPV_ARGS(&pipeline_state_));
-	ThrowIfFailed(hr);
+	// Compile on the worker threads so loading does not block on it. Later launches create the
+	// pipeline state from the blob stored on disk. The cube is not drawn until it is ready. The
+	// archive outlives the compiler, so the bytecode is not copied.
+	pipeline_state_ = app_->GetPipelineCompiler().CompileAsync(pipeline_state_stream_desc, nullptr, false);
+
+	frame_constants_ = std::make_unique<FrameConstantAllocator>(device, Window::buffer_count_, frame_constants_size_,
+																&app_->GetGpuMemoryTracker());
+	bundle_cache_ = std::make_unique<BundleCache>(device);
+	RecordCubeBundle();
 
 
 
 	// ============ TEXTURE STUFF ===========
 
-	D3D12_RESOURCE_DESC texture_desc;
-	UINT64 texture_width = 0, texture_height = 0;
-	DXGI_FORMAT texture_format;
-	int pixel_size = 0;
-	unsigned char * texture = LoadTexture("texture.png", texture_desc, texture_width, texture_height, texture_format, pixel_size);
-
-	device->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), // a default heap
-		D3D12_HEAP_FLAG_NONE, // no flags
-		&texture_desc, // the description of our texture
-		D3D12_RESOURCE_STATE_COPY_DEST, // We will copy the texture from the upload heap to here, so we start it out in a copy dest state
-		nullptr, // used for render targets and depth/stencil buffers
-		IID_PPV_ARGS(&texture_buffer_));
-
-	int texture_heap_size = ((((texture_width * pixel_size) + 255) & ~255) * (texture_height - 1)) + (texture_width * pixel_size);
-
-	UINT64 texture_upload_buffer_size;
-	// this function gets the size an upload buffer needs to be to upload a texture to the gpu.
-	// each row must be 256 byte aligned except for the last row, which can just be the size in bytes of the row
-	// eg. textureUploadBufferSize = ((((width * numBytesPerPixel) + 255) & ~255) * (height - 1)) + (width * numBytesPerPixel);
-	//textureUploadBufferSize = (((imageBytesPerRow + 255) & ~255) * (textureDesc.Height - 1)) + imageBytesPerRow;
-	device->GetCopyableFootprints(&texture_desc, 0, 1, 0, nullptr, nullptr, nullptr, &texture_upload_buffer_size);
-
-	// now we create an upload heap to upload our texture to the GPU
-	device->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), // upload heap
-		D3D12_HEAP_FLAG_NONE, // no flags
-		&CD3DX12_RESOURCE_DESC::Buffer(texture_upload_buffer_size), // resource description for a buffer (storing the image data in this heap just to copy to the default heap)
-		D3D12_RESOURCE_STATE_GENERIC_READ, // We will copy the contents from this heap to the default heap above
-		nullptr,
-		IID_PPV_ARGS(&texture_buffer_upload_heap_));
-
-	// store vertex buffer in upload heap
-	D3D12_SUBRESOURCE_DATA texture_data = {};
-	texture_data.pData = &texture[0]; // pointer to our image data
-	texture_data.RowPitch = texture_width * pixel_size; // size of all our triangle vertex data
-	texture_data.SlicePitch = texture_data.RowPitch * texture_height; // also the size of our triangle vertex data
-
-	// Now we copy the upload buffer contents to the default heap
-	ID3D12GraphicsCommandList* cmdlst = command_list.Get();
-	UpdateSubresources(cmdlst, texture_buffer_.Get(), texture_buffer_upload_heap_.Get(), 0, 0, 1, &texture_data);
-
-	// transition the texture default heap to a pixel shader resource (we will be sampling from this heap in the pixel shader to get the color of pixels)
-	command_list->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(texture_buffer_.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ));
-
-	D3D12_DESCRIPTOR_HEAP_DESC heap_desc = {};
-	heap_desc.NumDescriptors = 1;
-	heap_desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-	heap_desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-	device->CreateDescriptorHeap(&heap_desc, IID_PPV_ARGS(&main_descriptor_heap_));
+	// The texture is cooked once, and cooked again when the image changes or the cooked file can not be loaded.
+	if (TextureFile::IsOutOfDate(L"texture.tex", L"texture.png"))
+	{
+		CookTexture("texture.png", L"texture.tex");
+	}
+	D3D12_RESOURCE_DESC texture_desc = LoadTexture(L"texture.tex", texture_buffer_);
+
+	// Views live in the bindless table, the only shader-visible heap, and are indexed by the shaders.
+	bindless_table_ = std::make_unique<BindlessTable>(device, bindless_table_size_);
+	TRACK_GPU_MEMORY(app_->GetGpuMemoryTracker(), bindless_table_->GetHeap(), "DescriptorHeap",
+					 GpuMemoryTracker::GetDescriptorHeapSize(device.Get(), bindless_table_->GetHeap()));
+
+	// Views are shared by all materials that use the same resource and view description.
+	view_cache_ = std::make_unique<ViewCache>(device, app_->GetDescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV), *bindless_table_);
 
 	// now we create a shader resource view (descriptor that points to the texture and describes it)
 	D3D12_SHADER_RESOURCE_VIEW_DESC srv_desc = {};
 	srv_desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
 	srv_desc.Format = texture_desc.Format;
 	srv_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-	srv_desc.Texture2D.MipLevels = 1;
-	device->CreateShaderResourceView(texture_buffer_.Get(), &srv_desc, main_descriptor_heap_->GetCPUDescriptorHandleForHeapStart());
+	srv_desc.Texture2D.MipLevels = texture_desc.MipLevels;
+	texture_handle_ = view_cache_->AcquireShaderResourceView(texture_buffer_.resource.Get(), &srv_desc);
 
 	// ========= ENDS TEXTURE STUFF =========
 	
 
 
 
-	auto fence_value = command_queue->ExecuteCommandList(command_list);
-	command_queue->WaitForFenceValue(fence_value);
+	// The copies write to the heaps on the copy queue, so they must not be evicted before the copies finish.
+	ResidencyManager& residency_manager = app_->GetResidencyManager();
+	ResidencyManager::Handle content_residency_set[] = {
+		app_->GetHeapAllocator().GetResidencyHandle(vertex_buffer_),
+		app_->GetHeapAllocator().GetResidencyHandle(index_buffer_),
+		app_->GetTextureAllocator().GetResidencyHandle(texture_buffer_),
+	};
+	residency_manager.MakeResident(content_residency_set, _countof(content_residency_set), GetCompletedFenceValues());
 
-	stbi_image_free(texture);
+	// Start the copies. The direct queue only waits for them (on the GPU) before the first draw.
+	content_upload_ticket_ = upload_manager.Submit();
+	residency_manager.MarkUsed(content_residency_set, _countof(content_residency_set), ResidencyManager::COPY_QUEUE,
+							   content_upload_ticket_.fence_value);
 	content_loaded_ = true;
 
 
+	transient_pool_ = std::make_unique<TransientResourcePool>(std::make_shared<D3D12HeapAllocatorDevice>(device),
+															  &app_->GetResidencyManager(), &app_->GetGpuMemoryTracker());
+
 	// Resize/Create the depth buffer.
 	ResizeDepthBuffer(GetClientWidth(), GetClientHeight());
 
 	return true;
 }
 
-unsigned char * Demo2::LoadTexture(const char * path, D3D12_RESOURCE_DESC & resource_desc, UINT64 &texture_width, UINT64 &texture_height, DXGI_FORMAT &dxgi_format, int & pixel_size)
+void Demo2::CookTexture(const char* arg_source_path, const std::wstring& arg_path)
 {
+	const int pixel_size = 4;
 
+	// The mips are filtered from the whole image, so it is flipped while it is decoded.
 	int width, height, channels;
 	stbi_set_flip_vertically_on_load(true);
-	unsigned char *image = stbi_load(path,
+	unsigned char *image = stbi_load(arg_source_path,
 									 &width,
 									 &height,
 									 &channels,
@@ -449,26 +454,45 @@ unsigned char * Demo2::LoadTexture(const char * path, D3D12_RESOURCE_DESC & reso
 		ThrowIfFailed(-1);
 	}
 
-	texture_width = width;
-	texture_height = height;
-
-	dxgi_format = DXGI_FORMAT_R8G8B8A8_UNORM;
-	pixel_size = 4;
-
-	resource_desc = {};
-	resource_desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-	resource_desc.Alignment = 0; // may be 0, 4KB, 64KB, or 4MB. 0 will let runtime decide between 64KB and 4MB (4MB for multi-sampled textures)
-	resource_desc.Width = width; // width of the texture
-	resource_desc.Height = height; // height of the texture
-	resource_desc.DepthOrArraySize = 1; // if 3d image, depth of 3d image. Otherwise an array of 1D or 2D textures (we only have one image, so we set 1)
-	resource_desc.MipLevels = 1; // Number of mipmaps. We are not generating mipmaps for this texture, so we have only one level
-	resource_desc.Format = dxgi_format; // This is the dxgi format of the image (format of the pixels)
-	resource_desc.SampleDesc.Count = 1; // This is the number of samples per pixel, we just want 1 sample
-	resource_desc.SampleDesc.Quality = 0; // The quality level of the samples. Higher is better quality, but worse performance
-	resource_desc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN; // The arrangement of the pixels. Setting to unknown lets the driver choose the most efficient one
-	resource_desc.Flags = D3D12_RESOURCE_FLAG_NONE; // no flags
-
-	return image;
+	// The image is sRGB, so the mips are filtered in linear space. The texture is still read as
+	// UNORM, since the shader writes the encoded values straight to the back buffer.
+	TextureCookSettings cook_settings;
+	cook_settings.filter = MipFilter::Kaiser;
+	cook_settings.srgb = true;
+
+	// BC7 needs a quarter of the memory and bandwidth. Images that are not made of whole blocks stay uncompressed.
+	cook_settings.compress = width % 4 == 0 && height % 4 == 0;
+	cook_settings.block_format = BlockFormat::BC7;
+	cook_settings.compression_quality = CompressionQuality::Normal;
+	CookedTexture cooked_texture = TextureCooker(cook_settings).CookRGBA8(image, width, height, width * pixel_size);
+
+	stbi_image_free(image);
+
+	if (!TextureFile::Write(arg_path, &cooked_texture, 1))
+	{
+		ThrowIfFailed(E_FAIL);
+	}
+}
+
+D3D12_RESOURCE_DESC Demo2::LoadTexture(const std::wstring& arg_path, HeapAllocation& arg_texture)
+{
+	TextureFile texture_file(arg_path);
+
+	D3D12_RESOURCE_DESC resource_desc = texture_file.GetResourceDesc();
+	arg_texture = app_->GetTextureAllocator().CreateTexture(
+		resource_desc,
+		D3D12_RESOURCE_STATE_COMMON); // The copy queue promotes the texture to a copy destination, the direct queue to a pixel shader resource
+	TRACK_PLACED_GPU_MEMORY(app_->GetGpuMemoryTracker(), arg_texture.resource.Get(), "Texture", arg_texture.size);
+
+	// The subresources point into the mapped file, at the upload pitch, so each one is a single copy into the upload ring.
+	std::vector<D3D12_SUBRESOURCE_DATA> subresource_data(texture_file.GetSubresourceCount());
+	for (uint32_t subresource = 0; subresource < subresource_data.size(); ++subresource)
+	{
+		subresource_data[subresource] = texture_file.GetSubresourceData(subresource);
+	}
+	app_->GetUploadManager().UploadTexture(arg_texture.resource.Get(), 0, static_cast<UINT>(subresource_data.size()), subresource_data.data());
+
+	return resource_desc;
 }
 
 void Demo2::LoadTextures()
@@ -477,6 +501,16 @@ void Demo2::LoadTextures()
 
 	
 
+}
+
+ResidencyManager::FenceValues Demo2::GetCompletedFenceValues() const
+{
+	ResidencyManager::FenceValues completed_fence_values = { };
+	completed_fence_values[ResidencyManager::DIRECT_QUEUE] = app_->GetCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT)->GetCompletedFenceValue();
+	completed_fence_values[ResidencyManager::COMPUTE_QUEUE] = app_->GetCommandQueue(D3D12_COMMAND_LIST_TYPE_COMPUTE)->GetCompletedFenceValue();
+	completed_fence_values[ResidencyManager::COPY_QUEUE] = app_->GetCommandQueue(D3D12_COMMAND_LIST_TYPE_COPY)->GetCompletedFenceValue();
+
+	return completed_fence_values;
 }
 
 void Demo2::OnResize(ResizeEventArgs& arg_e)
@@ -536,11 +570,15 @@ void Demo2::OnRender(RenderEventArgs& arg_e)
 
 	auto command_queue = app_->GetCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT);
 	auto command_list = command_queue->GetCommandList();
+	const auto& d3d12_command_list = command_list->GetGraphicsCommandList();
 
 	UINT current_back_buffer_index = window_->GetCurrentBackBufferIndex();
 	auto back_buffer = window_->GetCurrentBackBuffer();
 	auto rtv = window_->GetCurrentRenderTargetView();
-	auto dsv = dsv_heap_->GetCPUDescriptorHandleForHeapStart();
+	auto dsv = dsv_.GetDescriptorHandle();
+
+	// The previous frame that used this back buffer has finished, so its constants can be overwritten.
+	frame_constants_->BeginFrame(current_back_buffer_index);
 
 	// Clear the render targets.
 	{
@@ -550,45 +588,64 @@ void Demo2::OnRender(RenderEventArgs& arg_e)
 		FLOAT clear_color[] = {0.4f, 0.6f, 0.9f, 1.0f};
 
 		ClearRTV(command_list, rtv, clear_color);
+
+		// The clear initializes the depth buffer if its memory is shared.
+		transient_pool_->BeginUse(*command_list, depth_buffer_);
 		ClearDepth(command_list, dsv);
 	}
 
-	command_list->SetPipelineState(pipeline_state_.Get());
-	command_list->SetGraphicsRootSignature(root_signature_.Get());
-
-	// set the descriptor heap
-	ID3D12DescriptorHeap* descriptorHeaps[] = {main_descriptor_heap_.Get()};
-	command_list->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
+	d3d12_command_list->SetGraphicsRootSignature(root_signature_.Get());
 
-	// set the descriptor table to the descriptor heap (parameter 1, as constant buffer root descriptor is parameter index 0)
-	command_list->SetGraphicsRootDescriptorTable(1, main_descriptor_heap_->GetGPUDescriptorHandleForHeapStart());
+	// Reuse the slots of views freed before the finished frames.
+	bindless_table_->ReleaseStaleSlots(command_queue->GetCompletedFenceValue());
 
-	D3D12_VERTEX_BUFFER_VIEW buffer_views[1] = {
-		vertex_buffer_view_
-	};
+	// set the descriptor heap. Bundles require the same heaps to be bound on the calling command list.
+	ID3D12DescriptorHeap* descriptorHeaps[] = {bindless_table_->GetHeap()};
+	d3d12_command_list->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
 
-	command_list->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	command_list->IASetVertexBuffers(0, 1, buffer_views);
-	command_list->IASetIndexBuffer(&index_buffer_view_);
+	// The bindless table is bound once; materials only change the texture index.
+	d3d12_command_list->SetGraphicsRootDescriptorTable(2, bindless_table_->GetTableStart());
+	d3d12_command_list->SetGraphicsRoot32BitConstant(1, bindless_table_->GetIndex(texture_handle_), 0);
 
-	command_list->RSSetViewports(1, &viewport_);
-	command_list->RSSetScissorRects(1, &scissor_rect_);
+	d3d12_command_list->RSSetViewports(1, &viewport_);
+	d3d12_command_list->RSSetScissorRects(1, &scissor_rect_);
 
-	command_list->OMSetRenderTargets(1, &rtv, FALSE, &dsv);
+	d3d12_command_list->OMSetRenderTargets(1, &rtv, FALSE, &dsv);
 
 	// Update the MVP matrix
 	XMMATRIX mvp_matrix = XMMatrixMultiply(model_matrix_, view_matrix_);
 	mvp_matrix = XMMatrixMultiply(mvp_matrix, projection_matrix_);
-	command_list->SetGraphicsRoot32BitConstants(0, sizeof(XMMATRIX) / 4, &mvp_matrix, 0);
+	d3d12_command_list->SetGraphicsRootConstantBufferView(0, frame_constants_->Allocate(mvp_matrix).gpu_address);
 
-	command_list->DrawIndexedInstanced(_countof(g_indicies), 1, 0, 0, 0);
+	// Replay the static pipeline state, input assembler setup and draw.
+	if (RecordCubeBundle())
+	{
+		d3d12_command_list->ExecuteBundle(cube_bundle_.Get());
+	}
 
 	// Present
 	{
 		TransitionResource(command_list, back_buffer,
 						   D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
 
+		// The cube's buffers and texture are uploaded on the copy queue.
+		app_->GetUploadManager().WaitOnQueue(content_upload_ticket_, *command_queue);
+
+		// Page the heaps used by the frame back in if they were evicted under memory pressure.
+		ResidencyManager& residency_manager = app_->GetResidencyManager();
+		ResidencyManager::Handle residency_set[] = {
+			app_->GetHeapAllocator().GetResidencyHandle(vertex_buffer_),
+			app_->GetHeapAllocator().GetResidencyHandle(index_buffer_),
+			transient_pool_->GetResidencyHandle(),
+			app_->GetTextureAllocator().GetResidencyHandle(texture_buffer_),
+		};
+		ResidencyManager::FenceValues completed_fence_values = GetCompletedFenceValues();
+		residency_manager.Trim(completed_fence_values);
+		residency_manager.MakeResident(residency_set, _countof(residency_set), completed_fence_values);
+
 		fence_values_[current_back_buffer_index] = command_queue->ExecuteCommandList(command_list);
+		residency_manager.MarkUsed(residency_set, _countof(residency_set), ResidencyManager::DIRECT_QUEUE,
+								   fence_values_[current_back_buffer_index]);
 
 		current_back_buffer_index = window_->Present();
 
@@ -632,5 +689,35 @@ void Demo2::OnMouseWheel(MouseWheelEventArgs& arg_e)
 
 void Demo2::UnloadContent()
 {
+	cube_bundle_.Reset();
+	bundle_cache_.reset();
+	pipeline_state_.reset();
+	frame_constants_.reset();
+
+	// The copy queue may still be writing to the resources.
+	app_->GetUploadManager().WaitOnCpu(content_upload_ticket_);
+
+	// Views must be released before their resources.
+	uint64_t fence_value = app_->GetCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT)->GetLastSignaledFenceValue();
+	view_cache_->Release(texture_handle_, fence_value);
+	texture_handle_ = BindlessHandle();
+
+	GpuMemoryTracker& gpu_memory_tracker = app_->GetGpuMemoryTracker();
+	gpu_memory_tracker.Unregister(vertex_buffer_.resource.Get());
+	gpu_memory_tracker.Unregister(index_buffer_.resource.Get());
+	gpu_memory_tracker.Unregister(texture_buffer_.resource.Get());
+	gpu_memory_tracker.Unregister(transient_pool_->GetResource(depth_buffer_));
+	gpu_memory_tracker.Unregister(bindless_table_->GetHeap());
+
+	HeapAllocator& heap_allocator = app_->GetHeapAllocator();
+	heap_allocator.Free(vertex_buffer_);
+	heap_allocator.Free(index_buffer_);
+	app_->GetTextureAllocator().Free(texture_buffer_);
+	transient_pool_.reset();
+
+	view_cache_.reset();
+	bindless_table_.reset();
+	app_->GetDescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE_DSV).Free(dsv_, fence_value);
+
 	content_loaded_ = false;
 }
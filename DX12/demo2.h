@@ -2,9 +2,22 @@
 
 #include <Game.h>
 #include <Window.h>
+#include <bindless_table.h>
+#include <bundle_cache.h>
+#include <frame_constant_allocator.h>
+#include <heap_allocator.h>
+#include <pipeline_compiler.h>
+#include <transient_resource_pool.h>
+#include <upload_manager.h>
+#include <view_cache.h>
 
 #include <DirectXMath.h>
 
+#include <memory>
+#include <string>
+
+class CommandList;
+
 class Demo2 : public Game
 {
 public:
@@ -49,59 +62,87 @@ protected:
 private:
 	// Helper functions
 	// Transition a resource
-	void TransitionResource(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> arg_command_list,
+	void TransitionResource(std::shared_ptr<CommandList> arg_command_list,
 							Microsoft::WRL::ComPtr<ID3D12Resource> arg_resource,
 							D3D12_RESOURCE_STATES arg_before_state, D3D12_RESOURCE_STATES arg_after_state);
 
 	// Clear a render target view.
-	void ClearRTV(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> arg_command_list,
+	void ClearRTV(std::shared_ptr<CommandList> arg_command_list,
 				  D3D12_CPU_DESCRIPTOR_HANDLE arg_rtv, FLOAT* arg_clear_color);
 
 	// Clear the depth of a depth-stencil view.
-	void ClearDepth(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> arg_command_list,
+	void ClearDepth(std::shared_ptr<CommandList> arg_command_list,
 					D3D12_CPU_DESCRIPTOR_HANDLE arg_dsv, FLOAT arg_depth = 1.0f);
 
-	// Create a GPU buffer.
-	void UpdateBufferResource(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> arg_command_list,
-							  ID3D12Resource** arg_destination_resource, ID3D12Resource** arg_intermediate_resource,
+	// Create a GPU buffer. The data is uploaded with the next batch of the application's upload manager.
+	// Callers register the buffer with the GPU memory tracker, so it is attributed to them.
+	void UpdateBufferResource(HeapAllocation& arg_destination,
 							  size_t arg_num_elements, size_t arg_element_size, const void* arg_buffer_data,
 							  D3D12_RESOURCE_FLAGS arg_flags = D3D12_RESOURCE_FLAG_NONE);
 
 	// Resize the depth buffer to match the size of the client area.
 	void ResizeDepthBuffer(int arg_width, int arg_height);
 
-	unsigned char * LoadTexture(const char * path, D3D12_RESOURCE_DESC &resource_desc, UINT64 &texture_width, UINT64 &texture_height, DXGI_FORMAT &dxgi_format, int & pixel_size);
+	// Record the cube bundle once its pipeline state has been compiled. Returns false while it is still compiling.
+	bool RecordCubeBundle();
+
+	// Decode an image, cook its mip chain and write it to a texture file.
+	void CookTexture(const char* arg_source_path, const std::wstring& arg_path);
+
+	// Map a texture file into a new texture. The subresources are copied into the upload ring as they are.
+	D3D12_RESOURCE_DESC LoadTexture(const std::wstring& arg_path, HeapAllocation& arg_texture);
 
 	// Load texture(s)
 	void LoadTextures();
 
+	// The completed fence value of every queue, for the residency manager.
+	ResidencyManager::FenceValues GetCompletedFenceValues() const;
+
 	uint64_t fence_values_[Window::buffer_count_] = { };
 
+	// Uploads of the content loaded in LoadContent.
+	UploadTicket content_upload_ticket_;
+
 	// Vertex buffer for the cube.
-	Microsoft::WRL::ComPtr<ID3D12Resource> vertex_buffer_;
+	HeapAllocation vertex_buffer_;
 	D3D12_VERTEX_BUFFER_VIEW vertex_buffer_view_;
 	// Color buffer for the cube.
 	Microsoft::WRL::ComPtr<ID3D12Resource> color_buffer_;
 	D3D12_VERTEX_BUFFER_VIEW color_buffer_view_;
 	// Index buffer for the cube.
-	Microsoft::WRL::ComPtr<ID3D12Resource> index_buffer_;
+	HeapAllocation index_buffer_;
 	D3D12_INDEX_BUFFER_VIEW index_buffer_view_;
 
+	// Screen-sized render targets. Targets used by disjoint passes share memory.
+	std::unique_ptr<TransientResourcePool> transient_pool_;
 	// Depth buffer.
-	Microsoft::WRL::ComPtr<ID3D12Resource> depth_buffer_;
-	// Descriptor heap for depth buffer.
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> dsv_heap_;
+	TransientResourcePool::Handle depth_buffer_;
+	// Depth-stencil view of the depth buffer.
+	DescriptorAllocation dsv_;
 
 	// Root signature
 	Microsoft::WRL::ComPtr<ID3D12RootSignature> root_signature_;
 
-	// Pipeline state object.
-	Microsoft::WRL::ComPtr<ID3D12PipelineState> pipeline_state_;
+	// Pipeline state object, compiled on the pipeline compiler's workers.
+	std::shared_ptr<AsyncPipelineState> pipeline_state_;
+
+	// Constant buffer data of the frames in flight, one slice per back buffer.
+	static const UINT64 frame_constants_size_ = 1024 * 1024;
+	std::unique_ptr<FrameConstantAllocator> frame_constants_;
+
+	// Static draw commands for the cube, recorded once the pipeline state is ready and replayed every frame.
+	std::unique_ptr<BundleCache> bundle_cache_;
+	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> cube_bundle_;
 
 	// Texture objects
-	Microsoft::WRL::ComPtr<ID3D12Resource> texture_buffer_;
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> main_descriptor_heap_;
-	Microsoft::WRL::ComPtr<ID3D12Resource> texture_buffer_upload_heap_;
+	HeapAllocation texture_buffer_;
+	// The texture's shader resource view in the bindless table.
+	BindlessHandle texture_handle_;
+
+	// Views of all textures and buffers, indexed by shaders.
+	static const uint32_t bindless_table_size_ = 16384;
+	std::unique_ptr<BindlessTable> bindless_table_;
+	std::unique_ptr<ViewCache> view_cache_;
 
 	D3D12_VIEWPORT viewport_;
 	D3D12_RECT scissor_rect_;
@@ -0,0 +1,126 @@
+#include <descriptor_allocator.h>
+#include <gpu_memory_tracker.h>
+#include <helpers.h>
+#include <tlsf_allocator.h>
+
+#include <algorithm>
+#include <cassert>
+
+DescriptorAllocator::DescriptorAllocator(Microsoft::WRL::ComPtr<ID3D12Device2> arg_device, D3D12_DESCRIPTOR_HEAP_TYPE arg_type,
+										 uint32_t arg_descriptors_per_page, GpuMemoryTracker* arg_gpu_memory_tracker)
+	: d3d12_device_(arg_device)
+	, type_(arg_type)
+	, descriptors_per_page_(arg_descriptors_per_page)
+	, descriptor_size_(arg_device->GetDescriptorHandleIncrementSize(arg_type))
+	, gpu_memory_tracker_(arg_gpu_memory_tracker)
+{ }
+
+DescriptorAllocator::~DescriptorAllocator()
+{
+	if (gpu_memory_tracker_)
+	{
+		for (const Page& page : pages_)
+		{
+			gpu_memory_tracker_->Unregister(page.heap.Get());
+		}
+	}
+}
+
+DescriptorAllocation DescriptorAllocator::Allocate(uint32_t arg_count)
+{
+	assert(arg_count > 0 && "At least one descriptor must be allocated.");
+
+	uint32_t page_index = ~0u;
+	uint64_t offset = TlsfAllocator::invalid_offset_;
+
+	for (uint32_t i = 0; i < pages_.size() && offset == TlsfAllocator::invalid_offset_; ++i)
+	{
+		offset = pages_[i].allocator->Allocate(arg_count, 1);
+		page_index = i;
+	}
+
+	if (offset == TlsfAllocator::invalid_offset_)
+	{
+		// TLSF rounds requests up to its size classes, which are exact for powers of two.
+		uint32_t page_size = 1;
+		while (page_size < std::max(arg_count, descriptors_per_page_))
+		{
+			page_size <<= 1;
+		}
+
+		page_index = CreatePage(page_size);
+		offset = pages_[page_index].allocator->Allocate(arg_count, 1);
+		assert(offset != TlsfAllocator::invalid_offset_ && "A new page must fit the range.");
+	}
+
+	DescriptorAllocation allocation;
+	allocation.base.ptr = pages_[page_index].base.ptr + SIZE_T(offset) * descriptor_size_;
+	allocation.count = arg_count;
+	allocation.descriptor_size = descriptor_size_;
+	allocation.page = page_index;
+	allocation.offset = static_cast<uint32_t>(offset);
+
+	return allocation;
+}
+
+void DescriptorAllocator::Free(DescriptorAllocation& arg_allocation, uint64_t arg_fence_value)
+{
+	if (arg_allocation.IsNull())
+	{
+		return;
+	}
+
+	assert(arg_allocation.page < pages_.size() && arg_allocation.descriptor_size == descriptor_size_ && "Invalid descriptor allocation.");
+
+	stale_ranges_.push_back(StaleRange{arg_fence_value, arg_allocation.page, arg_allocation.offset, arg_allocation.count});
+	arg_allocation = DescriptorAllocation();
+}
+
+void DescriptorAllocator::ReleaseStaleDescriptors(uint64_t arg_completed_fence_value)
+{
+	// Ranges are freed in submission order, so the oldest fence values are at the front.
+	while (!stale_ranges_.empty() && stale_ranges_.front().fence_value <= arg_completed_fence_value)
+	{
+		const StaleRange& range = stale_ranges_.front();
+		pages_[range.page].allocator->Free(range.offset);
+		stale_ranges_.pop_front();
+	}
+}
+
+DescriptorAllocator::Stats DescriptorAllocator::GetStats() const
+{
+	Stats stats = { };
+	stats.page_count = pages_.size();
+	for (const Page& page : pages_)
+	{
+		stats.total_descriptors += static_cast<uint32_t>(page.allocator->GetSize());
+		stats.free_descriptors += static_cast<uint32_t>(page.allocator->GetFreeSize());
+	}
+	for (const StaleRange& range : stale_ranges_)
+	{
+		stats.stale_descriptors += range.count;
+	}
+
+	return stats;
+}
+
+uint32_t DescriptorAllocator::CreatePage(uint32_t arg_size)
+{
+	D3D12_DESCRIPTOR_HEAP_DESC desc = { };
+	desc.Type = type_;
+	desc.NumDescriptors = arg_size;
+	desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+
+	Page page;
+	ThrowIfFailed(d3d12_device_->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&page.heap)));
+	page.base = page.heap->GetCPUDescriptorHandleForHeapStart();
+	page.allocator = std::make_unique<TlsfAllocator>(arg_size, 1);
+
+	if (gpu_memory_tracker_)
+	{
+		TRACK_GPU_MEMORY(*gpu_memory_tracker_, page.heap.Get(), "DescriptorHeap", UINT64(arg_size) * descriptor_size_);
+	}
+
+	pages_.push_back(std::move(page));
+	return static_cast<uint32_t>(pages_.size() - 1);
+}
@@ -0,0 +1,98 @@
+/**
+* The descriptor allocator hands out contiguous ranges of CPU (non shader-visible) descriptors
+* of one heap type. Descriptors are allocated from pages of descriptor heaps that are created
+* on demand; every page keeps its free ranges in a TLSF allocator. Freed ranges are returned
+* to their page once the fence value of the last submission that used them has completed.
+*/
+#pragma once
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+class GpuMemoryTracker;
+class TlsfAllocator;
+
+// A contiguous range of CPU descriptors.
+struct DescriptorAllocation
+{
+	D3D12_CPU_DESCRIPTOR_HANDLE base = { };
+	uint32_t count = 0;
+	uint32_t descriptor_size = 0;
+	uint32_t page = ~0u;
+	uint32_t offset = 0;
+
+	bool IsNull() const { return count == 0; }
+
+	// Get the handle of a descriptor in the range.
+	D3D12_CPU_DESCRIPTOR_HANDLE GetDescriptorHandle(uint32_t arg_index = 0) const
+	{
+		return D3D12_CPU_DESCRIPTOR_HANDLE{ base.ptr + SIZE_T(arg_index) * descriptor_size };
+	}
+};
+
+class DescriptorAllocator
+{
+public:
+	struct Stats
+	{
+		size_t page_count;
+		uint32_t total_descriptors;
+		uint32_t free_descriptors;
+		uint32_t stale_descriptors; // Freed, waiting for their fence value.
+	};
+
+	/**
+	* @param arg_descriptors_per_page The size of a page, rounded up to a power of two. Larger ranges
+	* get a page of their own.
+	* @param arg_gpu_memory_tracker If set, the pages are registered with it. Must outlive the allocator.
+	*/
+	DescriptorAllocator(Microsoft::WRL::ComPtr<ID3D12Device2> arg_device, D3D12_DESCRIPTOR_HEAP_TYPE arg_type,
+						uint32_t arg_descriptors_per_page = 256, GpuMemoryTracker* arg_gpu_memory_tracker = nullptr);
+	virtual ~DescriptorAllocator();
+
+	// Allocate a contiguous range of descriptors. Throws if a new page can not be created.
+	DescriptorAllocation Allocate(uint32_t arg_count = 1);
+
+	/**
+	* Free a range once the submission with the fence value has finished. The allocation is reset.
+	* @param arg_fence_value Fence value of the direct queue.
+	*/
+	void Free(DescriptorAllocation& arg_allocation, uint64_t arg_fence_value);
+
+	// Return the freed ranges whose fence value has completed to their pages.
+	void ReleaseStaleDescriptors(uint64_t arg_completed_fence_value);
+
+	Stats GetStats() const;
+
+private:
+	struct Page
+	{
+		Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> heap;
+		D3D12_CPU_DESCRIPTOR_HANDLE base;
+		std::unique_ptr<TlsfAllocator> allocator;
+	};
+
+	struct StaleRange
+	{
+		uint64_t fence_value;
+		uint32_t page;
+		uint32_t offset;
+		uint32_t count;
+	};
+
+	uint32_t CreatePage(uint32_t arg_size);
+
+	Microsoft::WRL::ComPtr<ID3D12Device2> d3d12_device_;
+	D3D12_DESCRIPTOR_HEAP_TYPE type_;
+	uint32_t descriptors_per_page_;
+	uint32_t descriptor_size_;
+	GpuMemoryTracker* gpu_memory_tracker_;
+
+	std::vector<Page> pages_;
+	std::deque<StaleRange> stale_ranges_;
+};
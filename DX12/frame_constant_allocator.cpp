@@ -0,0 +1,85 @@
+#include <frame_constant_allocator.h>
+#include <gpu_memory_tracker.h>
+#include <helpers.h>
+
+#include <d3dx12.h>
+
+#include <cassert>
+
+static UINT64 AlignUp(UINT64 arg_value, UINT64 arg_alignment)
+{
+	return (arg_value + arg_alignment - 1) & ~(arg_alignment - 1);
+}
+
+FrameConstantAllocator::FrameConstantAllocator(Microsoft::WRL::ComPtr<ID3D12Device2> arg_device, UINT arg_frame_count, UINT64 arg_frame_size,
+											   GpuMemoryTracker* arg_gpu_memory_tracker)
+	: cpu_base_(nullptr)
+	, gpu_memory_tracker_(arg_gpu_memory_tracker)
+	, frame_count_(arg_frame_count)
+	, frame_size_(AlignUp(arg_frame_size, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT))
+	, frame_begin_(0)
+	, offset_(0)
+{
+	assert(frame_count_ > 0 && "At least one frame is required.");
+
+	ThrowIfFailed(arg_device->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(frame_size_ * frame_count_),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&buffer_)));
+	if (gpu_memory_tracker_)
+	{
+		TRACK_GPU_MEMORY(*gpu_memory_tracker_, buffer_.Get(), "FrameConstants",
+						 GpuMemoryTracker::GetAllocationSize(arg_device.Get(), buffer_.Get()));
+	}
+
+	// The buffer stays mapped for its whole lifetime. The CPU never reads from it.
+	CD3DX12_RANGE read_range(0, 0);
+	ThrowIfFailed(buffer_->Map(0, &read_range, reinterpret_cast<void**>(&cpu_base_)));
+	gpu_base_ = buffer_->GetGPUVirtualAddress();
+}
+
+FrameConstantAllocator::~FrameConstantAllocator()
+{
+	buffer_->Unmap(0, nullptr);
+	if (gpu_memory_tracker_)
+	{
+		gpu_memory_tracker_->Unregister(buffer_.Get());
+	}
+}
+
+void FrameConstantAllocator::BeginFrame(UINT arg_frame_index)
+{
+	assert(arg_frame_index < frame_count_ && "Invalid frame index.");
+
+	frame_begin_ = frame_size_ * arg_frame_index;
+	offset_ = 0;
+}
+
+FrameConstantAllocator::Allocation FrameConstantAllocator::Allocate(UINT64 arg_size)
+{
+	UINT64 size = AlignUp(arg_size, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+	if (offset_ + size > frame_size_)
+	{
+		ThrowIfFailed(E_OUTOFMEMORY);
+	}
+
+	Allocation allocation;
+	allocation.cpu_address = cpu_base_ + frame_begin_ + offset_;
+	allocation.gpu_address = gpu_base_ + frame_begin_ + offset_;
+	offset_ += size;
+
+	return allocation;
+}
+
+UINT64 FrameConstantAllocator::GetFrameSize() const
+{
+	return frame_size_;
+}
+
+UINT64 FrameConstantAllocator::GetUsedSize() const
+{
+	return offset_;
+}
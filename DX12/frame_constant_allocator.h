@@ -0,0 +1,68 @@
+/**
+* Linear allocator for per-frame constant buffer data. Every back buffer owns a slice of
+* one persistently mapped upload buffer. Allocating constants is a pointer bump; a slice is
+* reset as a whole once the frame that last used it has finished on the GPU.
+*/
+#pragma once
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstring>
+
+class GpuMemoryTracker;
+
+class FrameConstantAllocator
+{
+public:
+	// A 256 byte aligned constant buffer slice.
+	struct Allocation
+	{
+		void* cpu_address;
+		D3D12_GPU_VIRTUAL_ADDRESS gpu_address;
+	};
+
+	/**
+	* @param arg_frame_count The number of frames in flight, usually Window::buffer_count_.
+	* @param arg_frame_size The number of bytes available for constants per frame.
+	* @param arg_gpu_memory_tracker If set, the constant buffer is registered with it. Must outlive the allocator.
+	*/
+	FrameConstantAllocator(Microsoft::WRL::ComPtr<ID3D12Device2> arg_device, UINT arg_frame_count, UINT64 arg_frame_size,
+						   GpuMemoryTracker* arg_gpu_memory_tracker = nullptr);
+	virtual ~FrameConstantAllocator();
+
+	/**
+	* Start allocating from the slice of a frame and discard its previous allocations.
+	* The GPU must have finished the frame that last used the slice.
+	* @param arg_frame_index The index of the current back buffer.
+	*/
+	void BeginFrame(UINT arg_frame_index);
+
+	// Allocate constant buffer memory for the current frame. Throws if the frame's slice is full.
+	Allocation Allocate(UINT64 arg_size);
+
+	// Allocate constant buffer memory for the current frame and copy the data into it.
+	template<typename T>
+	Allocation Allocate(const T& arg_data)
+	{
+		Allocation allocation = Allocate(sizeof(T));
+		memcpy(allocation.cpu_address, &arg_data, sizeof(T));
+		return allocation;
+	}
+
+	UINT64 GetFrameSize() const;
+	// Bytes allocated in the current frame.
+	UINT64 GetUsedSize() const;
+
+private:
+	Microsoft::WRL::ComPtr<ID3D12Resource> buffer_;
+	uint8_t* cpu_base_;
+	D3D12_GPU_VIRTUAL_ADDRESS gpu_base_;
+	GpuMemoryTracker* gpu_memory_tracker_;
+
+	UINT frame_count_;
+	UINT64 frame_size_;
+
+	UINT64 frame_begin_;
+	UINT64 offset_;
+};
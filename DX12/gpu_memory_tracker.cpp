@@ -0,0 +1,122 @@
+#include <gpu_memory_tracker.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+
+GpuMemoryTracker::GpuMemoryTracker()
+	: live_bytes_(0)
+	, peak_bytes_(0)
+{ }
+
+GpuMemoryTracker::~GpuMemoryTracker()
+{ }
+
+void GpuMemoryTracker::Register(ID3D12Object* arg_object, const char* arg_tag, UINT64 arg_size, const char* arg_file, int arg_line,
+								bool arg_placed)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	assert(arg_object && entries_.find(arg_object) == entries_.end() && "The object is already registered.");
+
+	TagStats& tag = tags_[arg_tag];
+	tag.tag = arg_tag;
+	++tag.live_count;
+	tag.live_bytes += arg_size;
+	tag.peak_bytes = std::max(tag.peak_bytes, tag.live_bytes);
+
+	if (!arg_placed)
+	{
+		live_bytes_ += arg_size;
+		peak_bytes_ = std::max(peak_bytes_, live_bytes_);
+	}
+
+	entries_[arg_object] = Entry{&tag, arg_size, arg_file, arg_line, arg_placed};
+}
+
+bool GpuMemoryTracker::Unregister(ID3D12Object* arg_object)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	auto iter = entries_.find(arg_object);
+	if (iter == entries_.end())
+	{
+		return false;
+	}
+
+	Entry& entry = iter->second;
+	--entry.tag->live_count;
+	entry.tag->live_bytes -= entry.size;
+	if (!entry.placed)
+	{
+		live_bytes_ -= entry.size;
+	}
+
+	entries_.erase(iter);
+	return true;
+}
+
+UINT64 GpuMemoryTracker::GetLiveBytes() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	return live_bytes_;
+}
+
+UINT64 GpuMemoryTracker::GetPeakBytes() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	return peak_bytes_;
+}
+
+std::vector<GpuMemoryTracker::TagStats> GpuMemoryTracker::GetTagStats() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	std::vector<TagStats> stats;
+	for (const auto& tag : tags_)
+	{
+		stats.push_back(tag.second);
+	}
+
+	return stats;
+}
+
+std::string GpuMemoryTracker::GetLeakReport() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	std::vector<const Entry*> leaks;
+	for (const auto& entry : entries_)
+	{
+		leaks.push_back(&entry.second);
+	}
+	std::sort(leaks.begin(), leaks.end(), [](const Entry* arg_a, const Entry* arg_b)
+	{
+		return arg_a->size > arg_b->size;
+	});
+
+	std::string report;
+	char line[512];
+	for (const Entry* leak : leaks)
+	{
+		sprintf_s(line, "GPU memory leak: %s, %llu bytes, created at %s(%d)\n", leak->tag->tag.c_str(),
+				  static_cast<unsigned long long>(leak->size), leak->file, leak->line);
+		report += line;
+	}
+
+	return report;
+}
+
+UINT64 GpuMemoryTracker::GetAllocationSize(ID3D12Device* arg_device, ID3D12Resource* arg_resource)
+{
+	D3D12_RESOURCE_DESC desc = arg_resource->GetDesc();
+	return arg_device->GetResourceAllocationInfo(0, 1, &desc).SizeInBytes;
+}
+
+UINT64 GpuMemoryTracker::GetDescriptorHeapSize(ID3D12Device* arg_device, ID3D12DescriptorHeap* arg_heap)
+{
+	D3D12_DESCRIPTOR_HEAP_DESC desc = arg_heap->GetDesc();
+	return UINT64(desc.NumDescriptors) * arg_device->GetDescriptorHandleIncrementSize(desc.Type);
+}
@@ -0,0 +1,86 @@
+/**
+* The GPU memory tracker records every resource and descriptor heap the application creates
+* with a tag, its size and the place it was created. It keeps the live and peak bytes per tag
+* so budgets can be checked at runtime, and lists whatever is still registered at shutdown.
+* All functions may be called from several threads.
+*/
+#pragma once
+
+#include <d3d12.h>
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Register an object with the tracker, recording the current source location.
+#define TRACK_GPU_MEMORY(arg_tracker, arg_object, arg_tag, arg_size) \
+	(arg_tracker).Register((arg_object), (arg_tag), (arg_size), __FILE__, __LINE__)
+
+// Register a resource placed in a heap that is registered itself, recording the current source location.
+#define TRACK_PLACED_GPU_MEMORY(arg_tracker, arg_object, arg_tag, arg_size) \
+	(arg_tracker).Register((arg_object), (arg_tag), (arg_size), __FILE__, __LINE__, true)
+
+class GpuMemoryTracker
+{
+public:
+	struct TagStats
+	{
+		std::string tag;
+		size_t live_count;
+		UINT64 live_bytes;
+		UINT64 peak_bytes;
+	};
+
+	GpuMemoryTracker();
+	virtual ~GpuMemoryTracker();
+
+	/**
+	* Register an object. Use TRACK_GPU_MEMORY or TRACK_PLACED_GPU_MEMORY to fill in the source location.
+	* @param arg_tag Groups objects in the statistics, e.g. "Texture" or "SwapChain".
+	* @param arg_size The memory used by the object in bytes.
+	* @param arg_placed The object is placed in a registered heap. Its size counts towards its tag,
+	* but not towards the live and peak bytes, which already contain the heap.
+	*/
+	void Register(ID3D12Object* arg_object, const char* arg_tag, UINT64 arg_size, const char* arg_file, int arg_line,
+				  bool arg_placed = false);
+
+	// Unregister an object before it is released. Returns false if the object was not registered.
+	bool Unregister(ID3D12Object* arg_object);
+
+	// Bytes of the registered objects, without the resources placed in registered heaps.
+	UINT64 GetLiveBytes() const;
+	UINT64 GetPeakBytes() const;
+
+	// Statistics of every tag that was ever used, sorted by tag.
+	std::vector<TagStats> GetTagStats() const;
+
+	// Objects that are still registered, largest first, one per line. Empty if there are none.
+	std::string GetLeakReport() const;
+
+	// The memory a resource occupies in a heap.
+	static UINT64 GetAllocationSize(ID3D12Device* arg_device, ID3D12Resource* arg_resource);
+	// The memory of a descriptor heap's descriptors.
+	static UINT64 GetDescriptorHeapSize(ID3D12Device* arg_device, ID3D12DescriptorHeap* arg_heap);
+
+private:
+	struct Entry
+	{
+		TagStats* tag;
+		UINT64 size;
+		const char* file;
+		int line;
+		bool placed;
+	};
+
+	std::unordered_map<ID3D12Object*, Entry> entries_;
+	// std::map keeps the addresses of the tag statistics stable.
+	std::map<std::string, TagStats> tags_;
+
+	UINT64 live_bytes_;
+	UINT64 peak_bytes_;
+
+	mutable std::mutex mutex_;
+};
@@ -0,0 +1,31 @@
+/**
+* Stable 64-bit hashing (FNV-1a) for cache keys. The hashes do not depend on the process or
+* the platform, so they can be stored on disk and compared on the next launch.
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+constexpr uint64_t HASH_SEED = 14695981039346656037ull;
+
+// Hash a range of bytes. Pass the result of a previous call as the seed to hash several ranges.
+inline uint64_t HashBytes(const void* arg_data, size_t arg_size, uint64_t arg_seed = HASH_SEED)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(arg_data);
+	uint64_t hash = arg_seed;
+	for (size_t i = 0; i < arg_size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+// Hash a value of a type without padding.
+template<typename T>
+inline uint64_t HashValue(const T& arg_value, uint64_t arg_seed = HASH_SEED)
+{
+	return HashBytes(&arg_value, sizeof(T), arg_seed);
+}
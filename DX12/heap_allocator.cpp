@@ -0,0 +1,304 @@
+#include <heap_allocator.h>
+#include <gpu_memory_tracker.h>
+#include <helpers.h>
+
+#include <algorithm>
+#include <cassert>
+
+D3D12HeapAllocatorDevice::D3D12HeapAllocatorDevice(Microsoft::WRL::ComPtr<ID3D12Device2> arg_device)
+	: d3d12_device_(arg_device)
+{ }
+
+D3D12_RESOURCE_ALLOCATION_INFO D3D12HeapAllocatorDevice::GetResourceAllocationInfo(const D3D12_RESOURCE_DESC& arg_desc)
+{
+	return d3d12_device_->GetResourceAllocationInfo(0, 1, &arg_desc);
+}
+
+Microsoft::WRL::ComPtr<ID3D12Heap> D3D12HeapAllocatorDevice::CreateHeap(const D3D12_HEAP_DESC& arg_desc)
+{
+	Microsoft::WRL::ComPtr<ID3D12Heap> heap;
+	ThrowIfFailed(d3d12_device_->CreateHeap(&arg_desc, IID_PPV_ARGS(&heap)));
+
+	return heap;
+}
+
+Microsoft::WRL::ComPtr<ID3D12Resource> D3D12HeapAllocatorDevice::CreatePlacedResource(ID3D12Heap* arg_heap, UINT64 arg_offset,
+																					  const D3D12_RESOURCE_DESC& arg_desc,
+																					  D3D12_RESOURCE_STATES arg_initial_state,
+																					  const D3D12_CLEAR_VALUE* arg_clear_value)
+{
+	Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+	ThrowIfFailed(d3d12_device_->CreatePlacedResource(arg_heap, arg_offset, &arg_desc, arg_initial_state,
+				  arg_clear_value, IID_PPV_ARGS(&resource)));
+
+	return resource;
+}
+
+SimulatedHeapAllocatorDevice::SimulatedHeapAllocatorDevice()
+	: placement_fails_(false)
+	, heap_count_(0)
+	, placed_count_(0)
+{ }
+
+void SimulatedHeapAllocatorDevice::SetPlacementFails(bool arg_fails)
+{
+	placement_fails_ = arg_fails;
+}
+
+D3D12_RESOURCE_ALLOCATION_INFO SimulatedHeapAllocatorDevice::GetResourceAllocationInfo(const D3D12_RESOURCE_DESC& arg_desc)
+{
+	UINT64 size = arg_desc.Width;
+	if (arg_desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER)
+	{
+		size *= UINT64(arg_desc.Height) * arg_desc.DepthOrArraySize * 4;
+	}
+
+	D3D12_RESOURCE_ALLOCATION_INFO info;
+	info.Alignment = arg_desc.SampleDesc.Count > 1 ? D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+	info.SizeInBytes = (size + info.Alignment - 1) & ~(info.Alignment - 1);
+
+	return info;
+}
+
+Microsoft::WRL::ComPtr<ID3D12Heap> SimulatedHeapAllocatorDevice::CreateHeap(const D3D12_HEAP_DESC&)
+{
+	++heap_count_;
+	return nullptr;
+}
+
+Microsoft::WRL::ComPtr<ID3D12Resource> SimulatedHeapAllocatorDevice::CreatePlacedResource(ID3D12Heap*, UINT64, const D3D12_RESOURCE_DESC&,
+																						  D3D12_RESOURCE_STATES, const D3D12_CLEAR_VALUE*)
+{
+	if (placement_fails_)
+	{
+		ThrowIfFailed(E_OUTOFMEMORY);
+	}
+
+	++placed_count_;
+	return nullptr;
+}
+
+uint64_t SimulatedHeapAllocatorDevice::GetHeapCount() const
+{
+	return heap_count_;
+}
+
+uint64_t SimulatedHeapAllocatorDevice::GetPlacedCount() const
+{
+	return placed_count_;
+}
+
+HeapAllocator::HeapAllocator(std::shared_ptr<HeapAllocatorDevice> arg_device, D3D12_HEAP_TYPE arg_heap_type, UINT64 arg_block_size,
+							 ResidencyManager* arg_residency_manager, GpuMemoryTracker* arg_gpu_memory_tracker)
+	: device_(arg_device)
+	, heap_type_(arg_heap_type)
+	, block_size_(arg_block_size)
+	, residency_manager_(arg_residency_manager)
+	, gpu_memory_tracker_(arg_gpu_memory_tracker)
+{ }
+
+HeapAllocator::~HeapAllocator()
+{
+	for (Block& block : blocks_)
+	{
+		if (block.in_use)
+		{
+			ReleaseBlock(block);
+		}
+	}
+}
+
+HeapAllocation HeapAllocator::CreateResource(const D3D12_RESOURCE_DESC& arg_desc, D3D12_RESOURCE_STATES arg_initial_state,
+											 const D3D12_CLEAR_VALUE* arg_clear_value)
+{
+	D3D12_RESOURCE_ALLOCATION_INFO info = device_->GetResourceAllocationInfo(arg_desc);
+	if (info.SizeInBytes == UINT64_MAX)
+	{
+		// The resource description is invalid.
+		ThrowIfFailed(E_INVALIDARG);
+	}
+
+	// Heaps are at least 64KB aligned. Multi-sampled resources need 4MB.
+	UINT64 alignment = std::max<UINT64>(info.Alignment, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+	HeapCategory category = GetCategory(arg_desc);
+
+	uint32_t block_index = ~0u;
+	UINT64 offset = TlsfAllocator::invalid_offset_;
+
+	for (uint32_t i = 0; i < blocks_.size() && offset == TlsfAllocator::invalid_offset_; ++i)
+	{
+		Block& block = blocks_[i];
+		if (block.in_use && !block.dedicated && block.category == category && block.alignment >= alignment)
+		{
+			offset = block.allocator->Allocate(info.SizeInBytes, alignment);
+			block_index = i;
+		}
+	}
+
+	if (offset == TlsfAllocator::invalid_offset_)
+	{
+		UINT64 heap_alignment = category == RENDER_TARGETS ? D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT : alignment;
+		bool dedicated = info.SizeInBytes > block_size_;
+		UINT64 heap_size = dedicated ? info.SizeInBytes : block_size_;
+
+		block_index = CreateBlock(category, heap_size, std::max(heap_alignment, alignment), dedicated);
+		offset = blocks_[block_index].allocator->Allocate(info.SizeInBytes, alignment);
+		assert(offset != TlsfAllocator::invalid_offset_ && "A new block must fit the resource.");
+	}
+
+	HeapAllocation allocation;
+	allocation.block = block_index;
+	allocation.generation = blocks_[block_index].generation;
+	allocation.offset = offset;
+	allocation.size = info.SizeInBytes;
+
+	try
+	{
+		allocation.resource = device_->CreatePlacedResource(blocks_[block_index].heap.Get(), offset, arg_desc,
+															arg_initial_state, arg_clear_value);
+	}
+	catch (...)
+	{
+		// Return the range, and the heap if it was created for this resource alone.
+		Free(allocation);
+		throw;
+	}
+
+	return allocation;
+}
+
+void HeapAllocator::Free(HeapAllocation& arg_allocation)
+{
+	if (!arg_allocation.IsValid())
+	{
+		return;
+	}
+
+	// The slot of a stale allocation may hold another heap by now, which must not be touched.
+	assert(IsValid(arg_allocation) && "Stale heap allocation.");
+	if (!IsValid(arg_allocation))
+	{
+		arg_allocation = HeapAllocation();
+		return;
+	}
+
+	Block& block = blocks_[arg_allocation.block];
+	arg_allocation.resource.Reset();
+	block.allocator->Free(arg_allocation.offset);
+
+	// Dedicated heaps only ever hold one resource.
+	if (block.dedicated)
+	{
+		ReleaseBlock(block);
+	}
+
+	arg_allocation = HeapAllocation();
+}
+
+bool HeapAllocator::IsValid(const HeapAllocation& arg_allocation) const
+{
+	return arg_allocation.IsValid() && arg_allocation.block < blocks_.size() && blocks_[arg_allocation.block].in_use &&
+		blocks_[arg_allocation.block].generation == arg_allocation.generation;
+}
+
+HeapAllocator::Stats HeapAllocator::GetStats() const
+{
+	Stats stats = { };
+	for (const Block& block : blocks_)
+	{
+		if (!block.in_use)
+		{
+			continue;
+		}
+
+		++stats.heap_count;
+		stats.allocation_count += block.allocator->GetAllocationCount();
+		stats.reserved_bytes += block.allocator->GetSize();
+		stats.allocated_bytes += block.allocator->GetSize() - block.allocator->GetFreeSize();
+		stats.largest_free_block = std::max(stats.largest_free_block, block.allocator->GetLargestFreeBlock());
+		stats.fragmentation = std::max(stats.fragmentation, block.allocator->GetFragmentation());
+	}
+
+	return stats;
+}
+
+ResidencyManager::Handle HeapAllocator::GetResidencyHandle(const HeapAllocation& arg_allocation) const
+{
+	assert(IsValid(arg_allocation) && "Invalid heap allocation.");
+
+	return blocks_[arg_allocation.block].residency_handle;
+}
+
+HeapAllocator::HeapCategory HeapAllocator::GetCategory(const D3D12_RESOURCE_DESC& arg_desc)
+{
+	if (arg_desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+	{
+		return BUFFERS;
+	}
+	if (arg_desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL))
+	{
+		return RENDER_TARGETS;
+	}
+
+	return TEXTURES;
+}
+
+uint32_t HeapAllocator::CreateBlock(HeapCategory arg_category, UINT64 arg_size, UINT64 arg_alignment, bool arg_dedicated)
+{
+	static const D3D12_HEAP_FLAGS category_flags[CATEGORY_COUNT] = {
+		D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS,
+		D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES,
+		D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES,
+	};
+
+	D3D12_HEAP_DESC heap_desc = { };
+	heap_desc.SizeInBytes = (arg_size + arg_alignment - 1) & ~(arg_alignment - 1);
+	heap_desc.Properties.Type = heap_type_;
+	heap_desc.Alignment = arg_alignment;
+	heap_desc.Flags = category_flags[arg_category];
+
+	Block block;
+	block.heap = device_->CreateHeap(heap_desc);
+	block.category = arg_category;
+	block.alignment = arg_alignment;
+	block.dedicated = arg_dedicated;
+	block.in_use = true;
+	block.generation = 0;
+	block.allocator = std::make_unique<TlsfAllocator>(heap_desc.SizeInBytes, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+	block.residency_handle = residency_manager_ ? residency_manager_->Track(block.heap.Get(), heap_desc.SizeInBytes)
+												: ResidencyManager::invalid_handle_;
+	if (gpu_memory_tracker_)
+	{
+		TRACK_GPU_MEMORY(*gpu_memory_tracker_, block.heap.Get(), "HeapAllocatorBlock", heap_desc.SizeInBytes);
+	}
+
+	// Reuse the slot of a released dedicated heap.
+	for (uint32_t i = 0; i < blocks_.size(); ++i)
+	{
+		if (!blocks_[i].in_use)
+		{
+			block.generation = blocks_[i].generation;
+			blocks_[i] = std::move(block);
+			return i;
+		}
+	}
+
+	blocks_.push_back(std::move(block));
+	return static_cast<uint32_t>(blocks_.size() - 1);
+}
+
+void HeapAllocator::ReleaseBlock(Block& arg_block)
+{
+	if (residency_manager_)
+	{
+		residency_manager_->Untrack(arg_block.residency_handle);
+	}
+	if (gpu_memory_tracker_)
+	{
+		gpu_memory_tracker_->Unregister(arg_block.heap.Get());
+	}
+	arg_block.heap.Reset();
+	arg_block.allocator.reset();
+	arg_block.in_use = false;
+	++arg_block.generation;
+}
@@ -0,0 +1,173 @@
+/**
+* The heap allocator places resources in large ID3D12Heap blocks instead of creating a
+* committed resource per object. Every block is sub-allocated with a TLSF allocator.
+* Blocks are separated into buffers, non render target textures and render target /
+* depth-stencil textures so the allocator also works on resource heap tier 1 hardware.
+*/
+#pragma once
+
+#include <residency_manager.h>
+#include <tlsf_allocator.h>
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class GpuMemoryTracker;
+
+/**
+* The device functions used by the heap allocator. Implementing this interface with a
+* stand-in allows the allocator to be exercised without a GPU.
+*/
+class HeapAllocatorDevice
+{
+public:
+	virtual ~HeapAllocatorDevice() { }
+
+	virtual D3D12_RESOURCE_ALLOCATION_INFO GetResourceAllocationInfo(const D3D12_RESOURCE_DESC& arg_desc) = 0;
+	virtual Microsoft::WRL::ComPtr<ID3D12Heap> CreateHeap(const D3D12_HEAP_DESC& arg_desc) = 0;
+	virtual Microsoft::WRL::ComPtr<ID3D12Resource> CreatePlacedResource(ID3D12Heap* arg_heap, UINT64 arg_offset,
+																		const D3D12_RESOURCE_DESC& arg_desc,
+																		D3D12_RESOURCE_STATES arg_initial_state,
+																		const D3D12_CLEAR_VALUE* arg_clear_value) = 0;
+};
+
+// Forwards the heap allocator device functions to a D3D12 device.
+class D3D12HeapAllocatorDevice : public HeapAllocatorDevice
+{
+public:
+	D3D12HeapAllocatorDevice(Microsoft::WRL::ComPtr<ID3D12Device2> arg_device);
+
+	virtual D3D12_RESOURCE_ALLOCATION_INFO GetResourceAllocationInfo(const D3D12_RESOURCE_DESC& arg_desc) override;
+	virtual Microsoft::WRL::ComPtr<ID3D12Heap> CreateHeap(const D3D12_HEAP_DESC& arg_desc) override;
+	virtual Microsoft::WRL::ComPtr<ID3D12Resource> CreatePlacedResource(ID3D12Heap* arg_heap, UINT64 arg_offset,
+																		const D3D12_RESOURCE_DESC& arg_desc,
+																		D3D12_RESOURCE_STATES arg_initial_state,
+																		const D3D12_CLEAR_VALUE* arg_clear_value) override;
+
+private:
+	Microsoft::WRL::ComPtr<ID3D12Device2> d3d12_device_;
+};
+
+/**
+* A CPU stand-in that creates null heaps and resources. A buffer takes its width in bytes and a
+* texture 4 bytes per texel of its top mip, rounded up to the placement alignment. Placing
+* resources can be made to fail, as it does on a device that is out of memory.
+*/
+class SimulatedHeapAllocatorDevice : public HeapAllocatorDevice
+{
+public:
+	SimulatedHeapAllocatorDevice();
+
+	// Make CreatePlacedResource throw until it is reset.
+	void SetPlacementFails(bool arg_fails);
+
+	virtual D3D12_RESOURCE_ALLOCATION_INFO GetResourceAllocationInfo(const D3D12_RESOURCE_DESC& arg_desc) override;
+	virtual Microsoft::WRL::ComPtr<ID3D12Heap> CreateHeap(const D3D12_HEAP_DESC& arg_desc) override;
+	virtual Microsoft::WRL::ComPtr<ID3D12Resource> CreatePlacedResource(ID3D12Heap* arg_heap, UINT64 arg_offset,
+																		const D3D12_RESOURCE_DESC& arg_desc,
+																		D3D12_RESOURCE_STATES arg_initial_state,
+																		const D3D12_CLEAR_VALUE* arg_clear_value) override;
+
+	// Number of heaps created and resources placed so far.
+	uint64_t GetHeapCount() const;
+	uint64_t GetPlacedCount() const;
+
+private:
+	bool placement_fails_;
+	uint64_t heap_count_;
+	uint64_t placed_count_;
+};
+
+// A resource placed in one of the heap allocator's blocks.
+struct HeapAllocation
+{
+	Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+	uint32_t block = ~0u;
+	// The generation of the block slot, so copies of the allocation are detected once the slot is reused.
+	uint32_t generation = 0;
+	UINT64 offset = 0;
+	UINT64 size = 0;
+
+	bool IsValid() const { return block != ~0u; }
+};
+
+class HeapAllocator
+{
+public:
+	struct Stats
+	{
+		size_t heap_count;
+		size_t allocation_count;
+		UINT64 reserved_bytes;     // Size of all heaps.
+		UINT64 allocated_bytes;    // Bytes used by placed resources, including alignment padding.
+		UINT64 largest_free_block; // Largest range any single heap can still place.
+		double fragmentation;      // Worst fragmentation of any heap, see TlsfAllocator::GetFragmentation.
+	};
+
+	/**
+	* @param arg_heap_type The type of all heaps created by this allocator.
+	* @param arg_block_size The size of a heap block. Resources larger than a block get a dedicated heap.
+	* @param arg_residency_manager If set, every heap is tracked by it. Must outlive the allocator.
+	* @param arg_gpu_memory_tracker If set, every heap is registered with it. Must outlive the allocator.
+	*/
+	HeapAllocator(std::shared_ptr<HeapAllocatorDevice> arg_device, D3D12_HEAP_TYPE arg_heap_type = D3D12_HEAP_TYPE_DEFAULT,
+				  UINT64 arg_block_size = 64 * 1024 * 1024, ResidencyManager* arg_residency_manager = nullptr,
+				  GpuMemoryTracker* arg_gpu_memory_tracker = nullptr);
+	virtual ~HeapAllocator();
+
+	// Create a placed resource. Throws if the device fails to create the heap or the resource; no memory is kept then.
+	HeapAllocation CreateResource(const D3D12_RESOURCE_DESC& arg_desc, D3D12_RESOURCE_STATES arg_initial_state,
+								  const D3D12_CLEAR_VALUE* arg_clear_value = nullptr);
+
+	// Release the resource and return its memory. The GPU must no longer use the resource.
+	void Free(HeapAllocation& arg_allocation);
+
+	// Whether the allocation refers to a resource that is still placed by this allocator.
+	bool IsValid(const HeapAllocation& arg_allocation) const;
+
+	Stats GetStats() const;
+
+	// The residency handle of the heap the resource is placed in, for ResidencyManager::MakeResident.
+	ResidencyManager::Handle GetResidencyHandle(const HeapAllocation& arg_allocation) const;
+
+private:
+	enum HeapCategory
+	{
+		BUFFERS,
+		TEXTURES,
+		RENDER_TARGETS,
+		CATEGORY_COUNT
+	};
+
+	struct Block
+	{
+		Microsoft::WRL::ComPtr<ID3D12Heap> heap;
+		HeapCategory category;
+		UINT64 alignment;
+		bool dedicated;
+		bool in_use;
+		// Incremented when the block is released, so allocations from before its slot was reused are stale.
+		uint32_t generation;
+		std::unique_ptr<TlsfAllocator> allocator;
+		ResidencyManager::Handle residency_handle;
+	};
+
+	static HeapCategory GetCategory(const D3D12_RESOURCE_DESC& arg_desc);
+	uint32_t CreateBlock(HeapCategory arg_category, UINT64 arg_size, UINT64 arg_alignment, bool arg_dedicated);
+	// Stop tracking the heap of a block and release it.
+	void ReleaseBlock(Block& arg_block);
+
+	std::shared_ptr<HeapAllocatorDevice> device_;
+	D3D12_HEAP_TYPE heap_type_;
+	UINT64 block_size_;
+	ResidencyManager* residency_manager_;
+	GpuMemoryTracker* gpu_memory_tracker_;
+
+	// Block indices are stored in allocations, so blocks stay at their index. The slots of released
+	// dedicated heaps are reused for new blocks, with the next generation.
+	std::vector<Block> blocks_;
+};
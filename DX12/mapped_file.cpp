@@ -0,0 +1,75 @@
+#include <mapped_file.h>
+#include <helpers.h>
+
+MappedFile::MappedFile(const std::wstring& arg_path)
+	: file_(INVALID_HANDLE_VALUE)
+	, mapping_(nullptr)
+	, data_(nullptr)
+	, size_(0)
+{
+	file_ = CreateFileW(arg_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file_ == INVALID_HANDLE_VALUE)
+	{
+		ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+	}
+
+	LARGE_INTEGER file_size;
+	HRESULT hr = GetFileSizeEx(file_, &file_size) ? S_OK : HRESULT_FROM_WIN32(GetLastError());
+
+	// Empty files can not be mapped.
+	if (SUCCEEDED(hr))
+	{
+		size_ = static_cast<uint64_t>(file_size.QuadPart);
+		hr = size_ > 0 ? S_OK : E_FAIL;
+	}
+	if (SUCCEEDED(hr))
+	{
+		mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		hr = mapping_ ? S_OK : HRESULT_FROM_WIN32(GetLastError());
+	}
+	if (SUCCEEDED(hr))
+	{
+		data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+		hr = data_ ? S_OK : HRESULT_FROM_WIN32(GetLastError());
+	}
+
+	if (FAILED(hr))
+	{
+		Close();
+		ThrowIfFailed(hr);
+	}
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+const uint8_t* MappedFile::GetData() const
+{
+	return data_;
+}
+
+uint64_t MappedFile::GetSize() const
+{
+	return size_;
+}
+
+void MappedFile::Close()
+{
+	if (data_)
+	{
+		UnmapViewOfFile(data_);
+		data_ = nullptr;
+	}
+	if (mapping_)
+	{
+		CloseHandle(mapping_);
+		mapping_ = nullptr;
+	}
+	if (file_ != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(file_);
+		file_ = INVALID_HANDLE_VALUE;
+	}
+}
@@ -0,0 +1,30 @@
+/**
+* A read-only memory mapping of a whole file. Cooked data is read straight from the mapping,
+* so the pages are loaded on first access by the OS instead of being copied into a buffer.
+*/
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+class MappedFile
+{
+public:
+	// Map a file. Throws if it can not be opened or is empty.
+	MappedFile(const std::wstring& arg_path);
+	virtual ~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const uint8_t* GetData() const;
+	uint64_t GetSize() const;
+
+private:
+	void Close();
+
+	void* file_;
+	void* mapping_;
+	const uint8_t* data_;
+	uint64_t size_;
+};
@@ -0,0 +1,72 @@
+/**
+* Splits a range of items into contiguous chunks that are processed on their own threads.
+* Meant for batch work like cooking, where the threads only live for the call.
+*/
+#pragma once
+
+#include <cstdint>
+#include <exception>
+#include <thread>
+#include <vector>
+
+/**
+* Call arg_function(begin, end) for contiguous chunks of [0, arg_count). The calling thread processes the
+* first chunk. Returns once all chunks are done and rethrows the first exception thrown by a chunk.
+* @param arg_min_chunk_size Chunks are not made smaller than this, so small ranges do not pay for threads.
+* @param arg_thread_count The maximum number of threads, or 0 for the number of hardware threads.
+*/
+template<typename Function>
+void ParallelFor(uint32_t arg_count, uint32_t arg_min_chunk_size, const Function& arg_function, uint32_t arg_thread_count = 0)
+{
+	if (arg_thread_count == 0)
+	{
+		uint32_t hardware_thread_count = std::thread::hardware_concurrency();
+		arg_thread_count = hardware_thread_count > 0 ? hardware_thread_count : 1;
+	}
+
+	uint32_t chunk_count = arg_min_chunk_size > 1 ? arg_count / arg_min_chunk_size : arg_count;
+	chunk_count = chunk_count < arg_thread_count ? chunk_count : arg_thread_count;
+	if (chunk_count <= 1)
+	{
+		if (arg_count > 0)
+		{
+			arg_function(0u, arg_count);
+		}
+		return;
+	}
+
+	std::vector<std::exception_ptr> errors(chunk_count);
+	auto run_chunk = [&](uint32_t arg_chunk)
+	{
+		uint32_t begin = static_cast<uint32_t>(uint64_t(arg_count) * arg_chunk / chunk_count);
+		uint32_t end = static_cast<uint32_t>(uint64_t(arg_count) * (arg_chunk + 1) / chunk_count);
+		try
+		{
+			arg_function(begin, end);
+		}
+		catch (...)
+		{
+			errors[arg_chunk] = std::current_exception();
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(chunk_count - 1);
+	for (uint32_t chunk = 1; chunk < chunk_count; ++chunk)
+	{
+		threads.emplace_back(run_chunk, chunk);
+	}
+	run_chunk(0);
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	for (const std::exception_ptr& error : errors)
+	{
+		if (error)
+		{
+			std::rethrow_exception(error);
+		}
+	}
+}
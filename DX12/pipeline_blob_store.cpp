@@ -0,0 +1,135 @@
+#include <pipeline_blob_store.h>
+
+#include <fstream>
+
+PipelineBlobStore::PipelineBlobStore(uint64_t arg_compatibility_key)
+	: compatibility_key_(arg_compatibility_key)
+	, dirty_(false)
+{ }
+
+bool PipelineBlobStore::Load(const std::string& arg_path)
+{
+	blobs_.clear();
+	dirty_ = false;
+
+	std::ifstream file(arg_path, std::ios::binary | std::ios::ate);
+	if (!file)
+	{
+		return false;
+	}
+
+	uint64_t remaining_size = static_cast<uint64_t>(file.tellg());
+	file.seekg(0);
+
+	FileHeader file_header;
+	if (remaining_size < sizeof(file_header) || !file.read(reinterpret_cast<char*>(&file_header), sizeof(file_header)))
+	{
+		return false;
+	}
+	remaining_size -= sizeof(file_header);
+
+	if (file_header.magic != file_magic_ || file_header.format_version != format_version_ ||
+		file_header.compatibility_key != compatibility_key_)
+	{
+		return false;
+	}
+
+	for (uint64_t i = 0; i < file_header.blob_count; ++i)
+	{
+		BlobHeader blob_header;
+		if (remaining_size < sizeof(blob_header) || !file.read(reinterpret_cast<char*>(&blob_header), sizeof(blob_header)))
+		{
+			blobs_.clear();
+			return false;
+		}
+		remaining_size -= sizeof(blob_header);
+
+		// Check the size before allocating, a corrupt size must not be trusted.
+		if (remaining_size < blob_header.size)
+		{
+			blobs_.clear();
+			return false;
+		}
+
+		std::vector<uint8_t>& blob = blobs_[blob_header.key];
+		blob.resize(static_cast<size_t>(blob_header.size));
+		if (!file.read(reinterpret_cast<char*>(blob.data()), blob.size()))
+		{
+			blobs_.clear();
+			return false;
+		}
+		remaining_size -= blob_header.size;
+	}
+
+	return true;
+}
+
+bool PipelineBlobStore::Save(const std::string& arg_path)
+{
+	std::ofstream file(arg_path, std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		return false;
+	}
+
+	FileHeader file_header = { };
+	file_header.magic = file_magic_;
+	file_header.format_version = format_version_;
+	file_header.compatibility_key = compatibility_key_;
+	file_header.blob_count = blobs_.size();
+	file.write(reinterpret_cast<const char*>(&file_header), sizeof(file_header));
+
+	for (const auto& blob : blobs_)
+	{
+		BlobHeader blob_header = { };
+		blob_header.key = blob.first;
+		blob_header.size = blob.second.size();
+		file.write(reinterpret_cast<const char*>(&blob_header), sizeof(blob_header));
+		file.write(reinterpret_cast<const char*>(blob.second.data()), blob.second.size());
+	}
+
+	file.close();
+	if (!file)
+	{
+		return false;
+	}
+
+	dirty_ = false;
+	return true;
+}
+
+const std::vector<uint8_t>* PipelineBlobStore::Find(uint64_t arg_key) const
+{
+	auto it = blobs_.find(arg_key);
+	return it != blobs_.end() ? &it->second : nullptr;
+}
+
+void PipelineBlobStore::Store(uint64_t arg_key, const void* arg_data, size_t arg_size)
+{
+	const uint8_t* data = static_cast<const uint8_t*>(arg_data);
+	blobs_[arg_key].assign(data, data + arg_size);
+	dirty_ = true;
+}
+
+void PipelineBlobStore::Remove(uint64_t arg_key)
+{
+	if (blobs_.erase(arg_key) > 0)
+	{
+		dirty_ = true;
+	}
+}
+
+uint64_t PipelineBlobStore::GetCompatibilityKey() const
+{
+	return compatibility_key_;
+}
+
+size_t PipelineBlobStore::GetBlobCount() const
+{
+	return blobs_.size();
+}
+
+bool PipelineBlobStore::IsDirty() const
+{
+	return dirty_;
+}
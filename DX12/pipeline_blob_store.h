@@ -0,0 +1,65 @@
+/**
+* The pipeline blob store keeps compiled pipeline blobs by the hash of their description and
+* persists them in one file between launches. The file is versioned: it is discarded when its
+* format version or its compatibility key (the adapter and driver the blobs were compiled for)
+* does not match. The store only uses the standard library.
+*/
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class PipelineBlobStore
+{
+public:
+	static const uint32_t format_version_ = 1;
+
+	/**
+	* @param arg_compatibility_key Identifies the adapter and driver. Files written with another key are ignored.
+	*/
+	PipelineBlobStore(uint64_t arg_compatibility_key);
+
+	/**
+	* Replace the contents of the store with a file.
+	* @returns false if the file does not exist, is truncated, or was written for another version or compatibility key.
+	* The store is empty in that case.
+	*/
+	bool Load(const std::string& arg_path);
+
+	// Write all blobs to a file. Returns false if the file could not be written.
+	bool Save(const std::string& arg_path);
+
+	// Get the blob stored for a key, or null.
+	const std::vector<uint8_t>* Find(uint64_t arg_key) const;
+	void Store(uint64_t arg_key, const void* arg_data, size_t arg_size);
+	void Remove(uint64_t arg_key);
+
+	uint64_t GetCompatibilityKey() const;
+	size_t GetBlobCount() const;
+
+	// Whether blobs were stored or removed since the last Load or Save.
+	bool IsDirty() const;
+
+private:
+	struct FileHeader
+	{
+		uint32_t magic;
+		uint32_t format_version;
+		uint64_t compatibility_key;
+		uint64_t blob_count;
+	};
+
+	struct BlobHeader
+	{
+		uint64_t key;
+		uint64_t size;
+	};
+
+	static const uint32_t file_magic_ = 0x43505350; // "PSPC"
+
+	uint64_t compatibility_key_;
+	std::unordered_map<uint64_t, std::vector<uint8_t>> blobs_;
+	bool dirty_;
+};
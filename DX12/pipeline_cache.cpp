@@ -0,0 +1,263 @@
+#include <pipeline_cache.h>
+#include <hash.h>
+#include <helpers.h>
+#include <pipeline_stream_hash.h>
+
+#include <cstring>
+
+SimulatedPipelineCacheDevice::SimulatedPipelineCacheDevice(uint64_t arg_driver_version)
+	: driver_version_(arg_driver_version)
+	, compiled_count_(0)
+	, cached_count_(0)
+{ }
+
+void SimulatedPipelineCacheDevice::SetDriverVersion(uint64_t arg_driver_version)
+{
+	driver_version_ = arg_driver_version;
+}
+
+bool SimulatedPipelineCacheDevice::GetCompatibilityKey(uint64_t& arg_key)
+{
+	arg_key = driver_version_;
+	return driver_version_ != 0;
+}
+
+HRESULT SimulatedPipelineCacheDevice::SerializeRootSignature(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& arg_desc, D3D_ROOT_SIGNATURE_VERSION,
+															 std::vector<uint8_t>& arg_blob)
+{
+	uint32_t fields[4] = { };
+	fields[0] = static_cast<uint32_t>(arg_desc.Version);
+	if (arg_desc.Version == D3D_ROOT_SIGNATURE_VERSION_1_0)
+	{
+		fields[1] = arg_desc.Desc_1_0.NumParameters;
+		fields[2] = arg_desc.Desc_1_0.NumStaticSamplers;
+		fields[3] = static_cast<uint32_t>(arg_desc.Desc_1_0.Flags);
+	}
+	else
+	{
+		fields[1] = arg_desc.Desc_1_1.NumParameters;
+		fields[2] = arg_desc.Desc_1_1.NumStaticSamplers;
+		fields[3] = static_cast<uint32_t>(arg_desc.Desc_1_1.Flags);
+	}
+
+	arg_blob.resize(sizeof(fields));
+	memcpy(arg_blob.data(), fields, sizeof(fields));
+	return S_OK;
+}
+
+HRESULT SimulatedPipelineCacheDevice::CreateRootSignature(const void*, size_t, Microsoft::WRL::ComPtr<ID3D12RootSignature>& arg_root_signature)
+{
+	arg_root_signature = nullptr;
+	return S_OK;
+}
+
+HRESULT SimulatedPipelineCacheDevice::CreatePipelineState(const D3D12_PIPELINE_STATE_STREAM_DESC&, const D3D12_CACHED_PIPELINE_STATE* arg_cached_blob,
+														  Microsoft::WRL::ComPtr<ID3D12PipelineState>& arg_pipeline_state)
+{
+	arg_pipeline_state = nullptr;
+
+	if (!arg_cached_blob)
+	{
+		++compiled_count_;
+		return S_OK;
+	}
+
+	if (arg_cached_blob->CachedBlobSizeInBytes != sizeof(driver_version_) ||
+		memcmp(arg_cached_blob->pCachedBlob, &driver_version_, sizeof(driver_version_)) != 0)
+	{
+		return D3D12_ERROR_DRIVER_VERSION_MISMATCH;
+	}
+
+	++cached_count_;
+	return S_OK;
+}
+
+void SimulatedPipelineCacheDevice::GetCachedBlob(ID3D12PipelineState*, std::vector<uint8_t>& arg_blob)
+{
+	const uint8_t* data = reinterpret_cast<const uint8_t*>(&driver_version_);
+	arg_blob.assign(data, data + sizeof(driver_version_));
+}
+
+uint64_t SimulatedPipelineCacheDevice::GetCompiledCount() const
+{
+	return compiled_count_;
+}
+
+uint64_t SimulatedPipelineCacheDevice::GetCachedCount() const
+{
+	return cached_count_;
+}
+
+PipelineCache::PipelineCache(std::shared_ptr<PipelineCacheDevice> arg_device, const std::string& arg_path)
+	: device_(arg_device)
+	, path_(arg_path)
+	, blob_store_(0)
+	, memory_hit_count_(0)
+	, disk_hit_count_(0)
+	, compile_count_(0)
+{
+	uint64_t compatibility_key;
+	if (!device_->GetCompatibilityKey(compatibility_key))
+	{
+		// Blobs could not be matched to the driver that compiled them, so they stay in memory.
+		path_.clear();
+		return;
+	}
+
+	blob_store_ = PipelineBlobStore(compatibility_key);
+	if (!path_.empty())
+	{
+		blob_store_.Load(path_);
+	}
+}
+
+PipelineCache::~PipelineCache()
+{
+	if (blob_store_.IsDirty())
+	{
+		Save();
+	}
+}
+
+Microsoft::WRL::ComPtr<ID3D12RootSignature> PipelineCache::GetRootSignature(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& arg_desc,
+																			D3D_ROOT_SIGNATURE_VERSION arg_highest_version)
+{
+	std::vector<uint8_t> root_signature_blob;
+	ThrowIfFailed(device_->SerializeRootSignature(arg_desc, arg_highest_version, root_signature_blob));
+
+	uint64_t hash = HashBytes(root_signature_blob.data(), root_signature_blob.size());
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	auto it = root_signatures_.find(hash);
+	if (it != root_signatures_.end())
+	{
+		++memory_hit_count_;
+		return it->second;
+	}
+
+	Microsoft::WRL::ComPtr<ID3D12RootSignature> root_signature;
+	ThrowIfFailed(device_->CreateRootSignature(root_signature_blob.data(), root_signature_blob.size(), root_signature));
+
+	root_signatures_[hash] = root_signature;
+	root_signature_hashes_[root_signature.Get()] = hash;
+
+	return root_signature;
+}
+
+Microsoft::WRL::ComPtr<ID3D12PipelineState> PipelineCache::GetPipelineState(const D3D12_PIPELINE_STATE_STREAM_DESC& arg_desc)
+{
+	uint64_t hash = HashPipelineStream(arg_desc);
+
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> pipeline_state = FindPipelineState(hash);
+	if (pipeline_state)
+	{
+		return pipeline_state;
+	}
+
+	return CreatePipelineState(hash, arg_desc);
+}
+
+uint64_t PipelineCache::HashPipelineStream(const D3D12_PIPELINE_STATE_STREAM_DESC& arg_desc) const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	uint64_t hash;
+	ThrowIfFailed(::HashPipelineStream(arg_desc, root_signature_hashes_, hash));
+
+	return hash;
+}
+
+Microsoft::WRL::ComPtr<ID3D12PipelineState> PipelineCache::FindPipelineState(uint64_t arg_hash)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	auto it = pipeline_states_.find(arg_hash);
+	if (it == pipeline_states_.end())
+	{
+		return nullptr;
+	}
+
+	++memory_hit_count_;
+	return it->second;
+}
+
+Microsoft::WRL::ComPtr<ID3D12PipelineState> PipelineCache::CreatePipelineState(uint64_t arg_hash, const D3D12_PIPELINE_STATE_STREAM_DESC& arg_desc)
+{
+	// Copy the stored blob, the store may change while the lock is released.
+	std::vector<uint8_t> stored_blob;
+	bool has_stored_blob = false;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		const std::vector<uint8_t>* blob = blob_store_.Find(arg_hash);
+		if (blob)
+		{
+			stored_blob = *blob;
+			has_stored_blob = true;
+		}
+	}
+
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> pipeline_state;
+	bool compiled = false;
+
+	if (has_stored_blob)
+	{
+		D3D12_CACHED_PIPELINE_STATE cached_blob = { stored_blob.data(), stored_blob.size() };
+		if (FAILED(device_->CreatePipelineState(arg_desc, &cached_blob, pipeline_state)))
+		{
+			// The driver or adapter changed since the blob was stored.
+			has_stored_blob = false;
+		}
+	}
+
+	std::vector<uint8_t> compiled_blob;
+	if (!has_stored_blob)
+	{
+		ThrowIfFailed(device_->CreatePipelineState(arg_desc, nullptr, pipeline_state));
+		device_->GetCachedBlob(pipeline_state.Get(), compiled_blob);
+		compiled = true;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	auto it = pipeline_states_.find(arg_hash);
+	if (it != pipeline_states_.end())
+	{
+		++memory_hit_count_;
+		return it->second;
+	}
+
+	if (compiled)
+	{
+		++compile_count_;
+		blob_store_.Store(arg_hash, compiled_blob.data(), compiled_blob.size());
+	}
+	else
+	{
+		++disk_hit_count_;
+	}
+
+	pipeline_states_[arg_hash] = pipeline_state;
+	return pipeline_state;
+}
+
+bool PipelineCache::Save()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	return !path_.empty() && blob_store_.Save(path_);
+}
+
+PipelineCache::Stats PipelineCache::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	Stats stats = { };
+	stats.root_signature_count = root_signatures_.size();
+	stats.pipeline_state_count = pipeline_states_.size();
+	stats.memory_hit_count = memory_hit_count_;
+	stats.disk_hit_count = disk_hit_count_;
+	stats.compile_count = compile_count_;
+
+	return stats;
+}
@@ -0,0 +1,151 @@
+/**
+* The pipeline cache creates root signatures and pipeline state objects once per description.
+* Root signatures are keyed by the hash of their serialized description, pipeline states by the
+* hash of the contents of their pipeline stream (shader bytecode, input layout and state, with
+* the root signature replaced by its hash). Duplicates are returned from memory, and the blobs of
+* compiled pipeline states are kept in a PipelineBlobStore so the next launch skips compilation.
+* All functions may be called from several threads; pipeline states are created outside the lock.
+*/
+#pragma once
+
+#include <pipeline_blob_store.h>
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+* The device functions used by the pipeline cache. The simulated device below stands in for a
+* driver, so hashing and storage can be exercised without compiling pipelines. The D3D12 device
+* is declared in d3d12_pipeline_cache_device.h.
+*/
+class PipelineCacheDevice
+{
+public:
+	virtual ~PipelineCacheDevice() { }
+
+	/**
+	* Get the key that identifies the adapter and driver compiled pipeline blobs are valid for.
+	* @returns false if the driver can not be identified; blobs are then not loaded or saved.
+	*/
+	virtual bool GetCompatibilityKey(uint64_t& arg_key) = 0;
+
+	// Serialize a root signature description, converting it to the highest version the device supports.
+	virtual HRESULT SerializeRootSignature(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& arg_desc, D3D_ROOT_SIGNATURE_VERSION arg_highest_version,
+										   std::vector<uint8_t>& arg_blob) = 0;
+	virtual HRESULT CreateRootSignature(const void* arg_blob, size_t arg_size, Microsoft::WRL::ComPtr<ID3D12RootSignature>& arg_root_signature) = 0;
+
+	/**
+	* @param arg_cached_blob A blob returned by GetCachedBlob on an earlier launch, or null to compile.
+	* Fails with D3D12_ERROR_DRIVER_VERSION_MISMATCH or D3D12_ERROR_ADAPTER_NOT_FOUND if the blob is stale.
+	*/
+	virtual HRESULT CreatePipelineState(const D3D12_PIPELINE_STATE_STREAM_DESC& arg_desc, const D3D12_CACHED_PIPELINE_STATE* arg_cached_blob,
+										Microsoft::WRL::ComPtr<ID3D12PipelineState>& arg_pipeline_state) = 0;
+	virtual void GetCachedBlob(ID3D12PipelineState* arg_pipeline_state, std::vector<uint8_t>& arg_blob) = 0;
+};
+
+/**
+* A CPU stand-in that creates null objects. Its cached blobs hold the driver version, and they
+* are rejected once the driver version is changed. A driver version of 0 can not be identified.
+* Root signatures are serialized to their version, flags and counts of parameters and samplers.
+*/
+class SimulatedPipelineCacheDevice : public PipelineCacheDevice
+{
+public:
+	SimulatedPipelineCacheDevice(uint64_t arg_driver_version);
+
+	void SetDriverVersion(uint64_t arg_driver_version);
+
+	virtual bool GetCompatibilityKey(uint64_t& arg_key) override;
+	virtual HRESULT SerializeRootSignature(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& arg_desc, D3D_ROOT_SIGNATURE_VERSION arg_highest_version,
+										   std::vector<uint8_t>& arg_blob) override;
+	virtual HRESULT CreateRootSignature(const void* arg_blob, size_t arg_size, Microsoft::WRL::ComPtr<ID3D12RootSignature>& arg_root_signature) override;
+	virtual HRESULT CreatePipelineState(const D3D12_PIPELINE_STATE_STREAM_DESC& arg_desc, const D3D12_CACHED_PIPELINE_STATE* arg_cached_blob,
+										Microsoft::WRL::ComPtr<ID3D12PipelineState>& arg_pipeline_state) override;
+	virtual void GetCachedBlob(ID3D12PipelineState* arg_pipeline_state, std::vector<uint8_t>& arg_blob) override;
+
+	// Number of pipeline states compiled from scratch and created from cached blobs so far.
+	uint64_t GetCompiledCount() const;
+	uint64_t GetCachedCount() const;
+
+private:
+	uint64_t driver_version_;
+	uint64_t compiled_count_;
+	uint64_t cached_count_;
+};
+
+class PipelineCache
+{
+public:
+	struct Stats
+	{
+		size_t root_signature_count;
+		size_t pipeline_state_count;
+		uint64_t memory_hit_count;  // Returned an object created earlier in this launch.
+		uint64_t disk_hit_count;    // Created from a blob stored by an earlier launch.
+		uint64_t compile_count;     // Compiled from scratch.
+	};
+
+	/**
+	* @param arg_path The file the blobs are loaded from and saved to. Empty to keep them in memory only,
+	* as they are when the device can not identify its driver.
+	*/
+	PipelineCache(std::shared_ptr<PipelineCacheDevice> arg_device, const std::string& arg_path);
+
+	// Saves the blobs if new pipeline states were compiled.
+	virtual ~PipelineCache();
+
+	/**
+	* Get the root signature for a description, creating it if it does not exist yet.
+	* @param arg_highest_version The highest root signature version the device supports.
+	*/
+	Microsoft::WRL::ComPtr<ID3D12RootSignature> GetRootSignature(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& arg_desc,
+																 D3D_ROOT_SIGNATURE_VERSION arg_highest_version);
+
+	/**
+	* Get the pipeline state for a pipeline stream, creating it from a stored blob or compiling it if it
+	* does not exist yet. The root signature of the stream must have been created by this cache.
+	* The stream must not contain a cached PSO.
+	*/
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> GetPipelineState(const D3D12_PIPELINE_STATE_STREAM_DESC& arg_desc);
+
+	// Get the stable hash of a pipeline stream that pipeline states are keyed by.
+	uint64_t HashPipelineStream(const D3D12_PIPELINE_STATE_STREAM_DESC& arg_desc) const;
+
+	// Get the pipeline state created for a hash during this launch, or null.
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> FindPipelineState(uint64_t arg_hash);
+
+	/**
+	* Create the pipeline state for a hash from its stored blob, or compile it. If another thread created
+	* the same pipeline state in the meantime, that one is returned.
+	* @param arg_hash The hash of the stream returned by HashPipelineStream.
+	*/
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> CreatePipelineState(uint64_t arg_hash, const D3D12_PIPELINE_STATE_STREAM_DESC& arg_desc);
+
+	// Write the blobs to the file. Returns false if there is no file or it could not be written.
+	bool Save();
+
+	Stats GetStats() const;
+
+private:
+	std::shared_ptr<PipelineCacheDevice> device_;
+	std::string path_;
+	PipelineBlobStore blob_store_;
+
+	std::unordered_map<uint64_t, Microsoft::WRL::ComPtr<ID3D12RootSignature>> root_signatures_;
+	// The hash of every root signature created by the cache, used in place of the pointer when hashing pipeline streams.
+	std::unordered_map<ID3D12RootSignature*, uint64_t> root_signature_hashes_;
+	std::unordered_map<uint64_t, Microsoft::WRL::ComPtr<ID3D12PipelineState>> pipeline_states_;
+
+	uint64_t memory_hit_count_;
+	uint64_t disk_hit_count_;
+	uint64_t compile_count_;
+
+	mutable std::mutex mutex_;
+};
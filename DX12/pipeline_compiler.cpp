@@ -0,0 +1,297 @@
+#include <pipeline_compiler.h>
+#include <helpers.h>
+#include <pipeline_cache.h>
+
+#include <d3dx12.h>
+
+#include <cassert>
+#include <string>
+
+AsyncPipelineState::AsyncPipelineState(Microsoft::WRL::ComPtr<ID3D12PipelineState> arg_fallback)
+	: fallback_(arg_fallback)
+	, ready_(false)
+{ }
+
+bool AsyncPipelineState::IsReady() const
+{
+	return ready_.load(std::memory_order_acquire);
+}
+
+void AsyncPipelineState::Wait() const
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	ready_condition_.wait(lock, [this]() { return ready_.load(std::memory_order_acquire); });
+
+	if (error_)
+	{
+		std::rethrow_exception(error_);
+	}
+}
+
+Microsoft::WRL::ComPtr<ID3D12PipelineState> AsyncPipelineState::Get() const
+{
+	if (!IsReady())
+	{
+		return fallback_;
+	}
+
+	// The result is not written again once the request is ready.
+	if (error_)
+	{
+		std::rethrow_exception(error_);
+	}
+
+	return pipeline_state_;
+}
+
+void AsyncPipelineState::SetResult(Microsoft::WRL::ComPtr<ID3D12PipelineState> arg_pipeline_state)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	assert(!ready_ && "The request has already finished.");
+
+	pipeline_state_ = arg_pipeline_state;
+	ready_.store(true, std::memory_order_release);
+	ready_condition_.notify_all();
+}
+
+void AsyncPipelineState::SetError(std::exception_ptr arg_error)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	assert(!ready_ && "The request has already finished.");
+
+	error_ = arg_error;
+	ready_.store(true, std::memory_order_release);
+	ready_condition_.notify_all();
+}
+
+/**
+* A deep copy of a pipeline stream. The subobjects are copied in their original order, and the
+* shader bytecode, input layout and stream output declarations they point to are owned by the
+* copy, so the copy hashes the same as the original. The shader bytecode may be left where it is.
+*/
+class PipelineCompiler::StreamCopy : public ID3DX12PipelineParserCallbacks
+{
+public:
+	StreamCopy(const D3D12_PIPELINE_STATE_STREAM_DESC& arg_desc, bool arg_copy_shaders)
+		: copy_shaders_(arg_copy_shaders)
+	{
+		ThrowIfFailed(D3DX12ParsePipelineStream(arg_desc, this));
+	}
+
+	StreamCopy(const StreamCopy&) = delete;
+	StreamCopy& operator=(const StreamCopy&) = delete;
+
+	D3D12_PIPELINE_STATE_STREAM_DESC GetDesc()
+	{
+		return D3D12_PIPELINE_STATE_STREAM_DESC{ stream_.size() * sizeof(void*), stream_.data() };
+	}
+
+	virtual void FlagsCb(D3D12_PIPELINE_STATE_FLAGS arg_flags) override { Append<CD3DX12_PIPELINE_STATE_STREAM_FLAGS>(arg_flags); }
+	virtual void NodeMaskCb(UINT arg_node_mask) override { Append<CD3DX12_PIPELINE_STATE_STREAM_NODE_MASK>(arg_node_mask); }
+
+	virtual void RootSignatureCb(ID3D12RootSignature* arg_root_signature) override
+	{
+		root_signature_ = arg_root_signature;
+		Append<CD3DX12_PIPELINE_STATE_STREAM_ROOT_SIGNATURE>(arg_root_signature);
+	}
+
+	virtual void InputLayoutCb(const D3D12_INPUT_LAYOUT_DESC& arg_input_layout) override
+	{
+		input_elements_.assign(arg_input_layout.pInputElementDescs, arg_input_layout.pInputElementDescs + arg_input_layout.NumElements);
+		for (D3D12_INPUT_ELEMENT_DESC& element : input_elements_)
+		{
+			element.SemanticName = CopyString(element.SemanticName);
+		}
+
+		D3D12_INPUT_LAYOUT_DESC input_layout = { input_elements_.data(), static_cast<UINT>(input_elements_.size()) };
+		Append<CD3DX12_PIPELINE_STATE_STREAM_INPUT_LAYOUT>(input_layout);
+	}
+
+	virtual void IBStripCutValueCb(D3D12_INDEX_BUFFER_STRIP_CUT_VALUE arg_value) override { Append<CD3DX12_PIPELINE_STATE_STREAM_IB_STRIP_CUT_VALUE>(arg_value); }
+	virtual void PrimitiveTopologyTypeCb(D3D12_PRIMITIVE_TOPOLOGY_TYPE arg_type) override { Append<CD3DX12_PIPELINE_STATE_STREAM_PRIMITIVE_TOPOLOGY>(arg_type); }
+
+	virtual void VSCb(const D3D12_SHADER_BYTECODE& arg_shader) override { Append<CD3DX12_PIPELINE_STATE_STREAM_VS>(CopyShader(arg_shader)); }
+	virtual void GSCb(const D3D12_SHADER_BYTECODE& arg_shader) override { Append<CD3DX12_PIPELINE_STATE_STREAM_GS>(CopyShader(arg_shader)); }
+	virtual void HSCb(const D3D12_SHADER_BYTECODE& arg_shader) override { Append<CD3DX12_PIPELINE_STATE_STREAM_HS>(CopyShader(arg_shader)); }
+	virtual void DSCb(const D3D12_SHADER_BYTECODE& arg_shader) override { Append<CD3DX12_PIPELINE_STATE_STREAM_DS>(CopyShader(arg_shader)); }
+	virtual void PSCb(const D3D12_SHADER_BYTECODE& arg_shader) override { Append<CD3DX12_PIPELINE_STATE_STREAM_PS>(CopyShader(arg_shader)); }
+	virtual void CSCb(const D3D12_SHADER_BYTECODE& arg_shader) override { Append<CD3DX12_PIPELINE_STATE_STREAM_CS>(CopyShader(arg_shader)); }
+
+	virtual void StreamOutputCb(const D3D12_STREAM_OUTPUT_DESC& arg_stream_output) override
+	{
+		so_entries_.assign(arg_stream_output.pSODeclaration, arg_stream_output.pSODeclaration + arg_stream_output.NumEntries);
+		for (D3D12_SO_DECLARATION_ENTRY& entry : so_entries_)
+		{
+			entry.SemanticName = entry.SemanticName ? CopyString(entry.SemanticName) : nullptr;
+		}
+		so_strides_.assign(arg_stream_output.pBufferStrides, arg_stream_output.pBufferStrides + arg_stream_output.NumStrides);
+
+		D3D12_STREAM_OUTPUT_DESC stream_output = arg_stream_output;
+		stream_output.pSODeclaration = so_entries_.data();
+		stream_output.pBufferStrides = so_strides_.data();
+		Append<CD3DX12_PIPELINE_STATE_STREAM_STREAM_OUTPUT>(stream_output);
+	}
+
+	virtual void BlendStateCb(const D3D12_BLEND_DESC& arg_blend) override { Append<CD3DX12_PIPELINE_STATE_STREAM_BLEND_DESC>(CD3DX12_BLEND_DESC(arg_blend)); }
+	virtual void DepthStencilStateCb(const D3D12_DEPTH_STENCIL_DESC& arg_depth_stencil) override { Append<CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL>(CD3DX12_DEPTH_STENCIL_DESC(arg_depth_stencil)); }
+	virtual void DepthStencilState1Cb(const D3D12_DEPTH_STENCIL_DESC1& arg_depth_stencil) override { Append<CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL1>(CD3DX12_DEPTH_STENCIL_DESC1(arg_depth_stencil)); }
+	virtual void DSVFormatCb(DXGI_FORMAT arg_format) override { Append<CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL_FORMAT>(arg_format); }
+	virtual void RasterizerStateCb(const D3D12_RASTERIZER_DESC& arg_rasterizer) override { Append<CD3DX12_PIPELINE_STATE_STREAM_RASTERIZER>(CD3DX12_RASTERIZER_DESC(arg_rasterizer)); }
+	virtual void RTVFormatsCb(const D3D12_RT_FORMAT_ARRAY& arg_formats) override { Append<CD3DX12_PIPELINE_STATE_STREAM_RENDER_TARGET_FORMATS>(arg_formats); }
+	virtual void SampleDescCb(const DXGI_SAMPLE_DESC& arg_sample_desc) override { Append<CD3DX12_PIPELINE_STATE_STREAM_SAMPLE_DESC>(arg_sample_desc); }
+	virtual void SampleMaskCb(UINT arg_sample_mask) override { Append<CD3DX12_PIPELINE_STATE_STREAM_SAMPLE_MASK>(arg_sample_mask); }
+
+	virtual void CachedPSOCb(const D3D12_CACHED_PIPELINE_STATE&) override
+	{
+		assert(false && "Pipeline streams passed to the compiler must not contain a cached PSO.");
+	}
+
+private:
+	// Subobjects are aligned to pointers, so the stream is stored as pointers.
+	template<typename Subobject, typename Inner>
+	void Append(const Inner& arg_value)
+	{
+		static_assert(sizeof(Subobject) % sizeof(void*) == 0, "Subobjects are pointer aligned.");
+
+		size_t offset = stream_.size();
+		stream_.resize(offset + sizeof(Subobject) / sizeof(void*));
+		new (&stream_[offset]) Subobject(arg_value);
+	}
+
+	D3D12_SHADER_BYTECODE CopyShader(const D3D12_SHADER_BYTECODE& arg_shader)
+	{
+		if (!copy_shaders_)
+		{
+			return arg_shader;
+		}
+
+		const uint8_t* bytecode = static_cast<const uint8_t*>(arg_shader.pShaderBytecode);
+		shaders_.emplace_back(bytecode, bytecode + arg_shader.BytecodeLength);
+		return D3D12_SHADER_BYTECODE{ shaders_.back().data(), shaders_.back().size() };
+	}
+
+	const char* CopyString(const char* arg_string)
+	{
+		strings_.emplace_back(arg_string);
+		return strings_.back().c_str();
+	}
+
+	bool copy_shaders_;
+	std::vector<void*> stream_;
+	Microsoft::WRL::ComPtr<ID3D12RootSignature> root_signature_;
+	// Deques do not move their elements, so pointers into them stay valid.
+	std::deque<std::vector<uint8_t>> shaders_;
+	std::deque<std::string> strings_;
+	std::vector<D3D12_INPUT_ELEMENT_DESC> input_elements_;
+	std::vector<D3D12_SO_DECLARATION_ENTRY> so_entries_;
+	std::vector<UINT> so_strides_;
+};
+
+PipelineCompiler::PipelineCompiler(PipelineCache& arg_pipeline_cache, uint32_t arg_thread_count)
+	: pipeline_cache_(arg_pipeline_cache)
+	, active_request_count_(0)
+	, stopping_(false)
+{
+	if (arg_thread_count == 0)
+	{
+		// Leave one hardware thread to the render thread.
+		uint32_t hardware_thread_count = std::thread::hardware_concurrency();
+		arg_thread_count = hardware_thread_count > 2 ? hardware_thread_count - 1 : 1;
+	}
+
+	for (uint32_t i = 0; i < arg_thread_count; ++i)
+	{
+		workers_.emplace_back(&PipelineCompiler::WorkerMain, this);
+	}
+}
+
+PipelineCompiler::~PipelineCompiler()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stopping_ = true;
+	}
+	request_condition_.notify_all();
+
+	for (std::thread& worker : workers_)
+	{
+		worker.join();
+	}
+}
+
+std::shared_ptr<AsyncPipelineState> PipelineCompiler::CompileAsync(const D3D12_PIPELINE_STATE_STREAM_DESC& arg_desc,
+																   Microsoft::WRL::ComPtr<ID3D12PipelineState> arg_fallback,
+																   bool arg_copy_shaders)
+{
+	auto result = std::make_shared<AsyncPipelineState>(arg_fallback);
+
+	uint64_t hash = pipeline_cache_.HashPipelineStream(arg_desc);
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> pipeline_state = pipeline_cache_.FindPipelineState(hash);
+	if (pipeline_state)
+	{
+		result->SetResult(pipeline_state);
+		return result;
+	}
+
+	Request request;
+	request.hash = hash;
+	request.stream = std::make_unique<StreamCopy>(arg_desc, arg_copy_shaders);
+	request.result = result;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		requests_.push_back(std::move(request));
+	}
+	request_condition_.notify_one();
+
+	return result;
+}
+
+void PipelineCompiler::WaitIdle()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	idle_condition_.wait(lock, [this]() { return requests_.empty() && active_request_count_ == 0; });
+}
+
+uint32_t PipelineCompiler::GetThreadCount() const
+{
+	return static_cast<uint32_t>(workers_.size());
+}
+
+void PipelineCompiler::WorkerMain()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+
+	for (;;)
+	{
+		request_condition_.wait(lock, [this]() { return stopping_ || !requests_.empty(); });
+
+		// Queued requests are finished before the workers stop.
+		if (requests_.empty())
+		{
+			return;
+		}
+
+		Request request = std::move(requests_.front());
+		requests_.pop_front();
+		++active_request_count_;
+		lock.unlock();
+
+		try
+		{
+			request.result->SetResult(pipeline_cache_.CreatePipelineState(request.hash, request.stream->GetDesc()));
+		}
+		catch (...)
+		{
+			request.result->SetError(std::current_exception());
+		}
+		request.stream.reset();
+
+		lock.lock();
+		--active_request_count_;
+		if (requests_.empty() && active_request_count_ == 0)
+		{
+			idle_condition_.notify_all();
+		}
+	}
+}
@@ -0,0 +1,106 @@
+/**
+* The pipeline compiler creates pipeline states on worker threads so loading does not block
+* on compilation. Requests are deep copied, so the caller's shaders and input layouts do not
+* need to outlive the request. Every request returns an AsyncPipelineState that can be polled
+* or waited on, and that returns a fallback pipeline state until the compiled one is ready.
+* Pipeline states are created through a PipelineCache, so stored blobs are used when available.
+*/
+#pragma once
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class PipelineCache;
+
+// The result of a pipeline compiler request.
+class AsyncPipelineState
+{
+public:
+	AsyncPipelineState(Microsoft::WRL::ComPtr<ID3D12PipelineState> arg_fallback);
+
+	// Whether the request has finished. Cheap enough to be polled every frame.
+	bool IsReady() const;
+
+	// Block until the request has finished. Rethrows the error of a failed request.
+	void Wait() const;
+
+	/**
+	* Get the compiled pipeline state, or the fallback while the request has not finished.
+	* Rethrows the error of a failed request.
+	*/
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> Get() const;
+
+	// Used by the compiler to finish the request.
+	void SetResult(Microsoft::WRL::ComPtr<ID3D12PipelineState> arg_pipeline_state);
+	void SetError(std::exception_ptr arg_error);
+
+private:
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> fallback_;
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> pipeline_state_;
+	std::exception_ptr error_;
+
+	std::atomic<bool> ready_;
+	mutable std::mutex mutex_;
+	mutable std::condition_variable ready_condition_;
+};
+
+class PipelineCompiler
+{
+public:
+	/**
+	* @param arg_pipeline_cache Must outlive the compiler.
+	* @param arg_thread_count The number of worker threads, or 0 for one less than the number of hardware threads.
+	*/
+	PipelineCompiler(PipelineCache& arg_pipeline_cache, uint32_t arg_thread_count = 0);
+
+	// Finishes the queued requests, so their blobs are stored for the next launch, and stops the workers.
+	virtual ~PipelineCompiler();
+
+	/**
+	* Queue the creation of a pipeline state. The stream is hashed and copied before the function returns.
+	* A pipeline state that was already created is returned ready.
+	* @param arg_fallback Returned by the result until the pipeline state is ready. May be null.
+	* @param arg_copy_shaders Whether to copy the shader bytecode. Bytecode that outlives the request, like
+	* the bytecode of the shader archive, does not need to be copied.
+	*/
+	std::shared_ptr<AsyncPipelineState> CompileAsync(const D3D12_PIPELINE_STATE_STREAM_DESC& arg_desc,
+													 Microsoft::WRL::ComPtr<ID3D12PipelineState> arg_fallback = nullptr,
+													 bool arg_copy_shaders = true);
+
+	// Block until all queued requests have finished.
+	void WaitIdle();
+
+	uint32_t GetThreadCount() const;
+
+private:
+	class StreamCopy;
+
+	struct Request
+	{
+		uint64_t hash;
+		std::unique_ptr<StreamCopy> stream;
+		std::shared_ptr<AsyncPipelineState> result;
+	};
+
+	void WorkerMain();
+
+	PipelineCache& pipeline_cache_;
+	std::vector<std::thread> workers_;
+
+	std::deque<Request> requests_;
+	uint32_t active_request_count_;
+	bool stopping_;
+	std::mutex mutex_;
+	std::condition_variable request_condition_;
+	std::condition_variable idle_condition_;
+};
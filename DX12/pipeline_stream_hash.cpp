@@ -0,0 +1,318 @@
+#include <pipeline_stream_hash.h>
+#include <hash.h>
+
+#include <cstring>
+
+namespace
+{
+	// A subobject as laid out by the D3DX12 stream helpers.
+	template<typename T>
+	struct alignas(void*) Subobject
+	{
+		D3D12_PIPELINE_STATE_SUBOBJECT_TYPE type;
+		T desc;
+	};
+
+	class PipelineStreamHasher
+	{
+	public:
+		PipelineStreamHasher(const D3D12_PIPELINE_STATE_STREAM_DESC& arg_desc, const std::unordered_map<ID3D12RootSignature*, uint64_t>& arg_root_signature_hashes)
+			: stream_(static_cast<const uint8_t*>(arg_desc.pPipelineStateSubobjectStream))
+			, size_(arg_desc.SizeInBytes)
+			, offset_(0)
+			, root_signature_hashes_(arg_root_signature_hashes)
+			, hash_(HASH_SEED)
+		{ }
+
+		HRESULT Hash(uint64_t& arg_hash)
+		{
+			while (offset_ < size_)
+			{
+				if (size_ - offset_ < sizeof(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE))
+				{
+					return E_INVALIDARG;
+				}
+
+				D3D12_PIPELINE_STATE_SUBOBJECT_TYPE type = *reinterpret_cast<const D3D12_PIPELINE_STATE_SUBOBJECT_TYPE*>(stream_ + offset_);
+				if (!HashSubobject(type))
+				{
+					return E_INVALIDARG;
+				}
+			}
+
+			arg_hash = hash_;
+			return S_OK;
+		}
+
+	private:
+		// Hash the subobject at the current offset and move past it. Returns false if it can not be hashed.
+		bool HashSubobject(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE arg_type)
+		{
+			switch (arg_type)
+			{
+			case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_FLAGS:
+				return AddSubobject<D3D12_PIPELINE_STATE_FLAGS>(arg_type);
+			case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_NODE_MASK:
+			case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_MASK:
+				return AddSubobject<UINT>(arg_type);
+			case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_ROOT_SIGNATURE:
+				return AddRootSignature(arg_type);
+			case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_INPUT_LAYOUT:
+				return AddInputLayout(arg_type);
+			case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_IB_STRIP_CUT_VALUE:
+				return AddSubobject<D3D12_INDEX_BUFFER_STRIP_CUT_VALUE>(arg_type);
+			case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PRIMITIVE_TOPOLOGY:
+				return AddSubobject<D3D12_PRIMITIVE_TOPOLOGY_TYPE>(arg_type);
+			case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VS:
+			case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_GS:
+			case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_HS:
+			case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DS:
+			case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PS:
+			case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CS:
+				return AddShader(arg_type);
+			case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_STREAM_OUTPUT:
+				return AddStreamOutput(arg_type);
+			case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_BLEND:
+				return AddBlend(arg_type);
+			case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL:
+				return AddDepthStencil();
+			case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL1:
+				return AddDepthStencil1();
+			case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL_FORMAT:
+				return AddSubobject<DXGI_FORMAT>(arg_type);
+			case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RASTERIZER:
+				return AddSubobject<D3D12_RASTERIZER_DESC>(arg_type);
+			case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RENDER_TARGET_FORMATS:
+				return AddSubobject<D3D12_RT_FORMAT_ARRAY>(arg_type);
+			case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_DESC:
+				return AddSubobject<DXGI_SAMPLE_DESC>(arg_type);
+			default:
+				// Cached PSOs are added by the pipeline cache itself, and unknown subobjects can not be hashed.
+				return false;
+			}
+		}
+
+		// Get the description of the subobject at the current offset and move past it, or null if the stream is truncated.
+		template<typename T>
+		const T* Next()
+		{
+			if (size_ - offset_ < sizeof(Subobject<T>))
+			{
+				return nullptr;
+			}
+
+			const Subobject<T>* subobject = reinterpret_cast<const Subobject<T>*>(stream_ + offset_);
+			offset_ += sizeof(Subobject<T>);
+			return &subobject->desc;
+		}
+
+		// Hash a subobject whose description has no padding or pointers.
+		template<typename T>
+		bool AddSubobject(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE arg_type)
+		{
+			const T* desc = Next<T>();
+			if (!desc)
+			{
+				return false;
+			}
+
+			Add(arg_type, *desc);
+			return true;
+		}
+
+		bool AddRootSignature(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE arg_type)
+		{
+			ID3D12RootSignature* const* root_signature = Next<ID3D12RootSignature*>();
+			if (!root_signature)
+			{
+				return false;
+			}
+
+			auto it = root_signature_hashes_.find(*root_signature);
+			if (it == root_signature_hashes_.end())
+			{
+				return false;
+			}
+
+			Add(arg_type, it->second);
+			return true;
+		}
+
+		bool AddInputLayout(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE arg_type)
+		{
+			const D3D12_INPUT_LAYOUT_DESC* input_layout = Next<D3D12_INPUT_LAYOUT_DESC>();
+			if (!input_layout)
+			{
+				return false;
+			}
+
+			Add(arg_type, input_layout->NumElements);
+			for (UINT i = 0; i < input_layout->NumElements; ++i)
+			{
+				const D3D12_INPUT_ELEMENT_DESC& element = input_layout->pInputElementDescs[i];
+				AddString(element.SemanticName);
+				AddValue(element.SemanticIndex);
+				AddValue(element.Format);
+				AddValue(element.InputSlot);
+				AddValue(element.AlignedByteOffset);
+				AddValue(element.InputSlotClass);
+				AddValue(element.InstanceDataStepRate);
+			}
+
+			return true;
+		}
+
+		bool AddShader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE arg_type)
+		{
+			const D3D12_SHADER_BYTECODE* shader = Next<D3D12_SHADER_BYTECODE>();
+			if (!shader)
+			{
+				return false;
+			}
+
+			Add(arg_type, static_cast<uint64_t>(shader->BytecodeLength));
+			hash_ = HashBytes(shader->pShaderBytecode, shader->BytecodeLength, hash_);
+			return true;
+		}
+
+		bool AddStreamOutput(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE arg_type)
+		{
+			const D3D12_STREAM_OUTPUT_DESC* stream_output = Next<D3D12_STREAM_OUTPUT_DESC>();
+			if (!stream_output)
+			{
+				return false;
+			}
+
+			Add(arg_type, stream_output->NumEntries);
+			for (UINT i = 0; i < stream_output->NumEntries; ++i)
+			{
+				const D3D12_SO_DECLARATION_ENTRY& entry = stream_output->pSODeclaration[i];
+				AddValue(entry.Stream);
+				AddString(entry.SemanticName);
+				AddValue(entry.SemanticIndex);
+				AddValue(entry.StartComponent);
+				AddValue(entry.ComponentCount);
+				AddValue(entry.OutputSlot);
+			}
+			AddValue(stream_output->NumStrides);
+			if (stream_output->NumStrides > 0)
+			{
+				hash_ = HashBytes(stream_output->pBufferStrides, sizeof(UINT) * stream_output->NumStrides, hash_);
+			}
+			AddValue(stream_output->RasterizedStream);
+
+			return true;
+		}
+
+		bool AddBlend(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE arg_type)
+		{
+			const D3D12_BLEND_DESC* blend = Next<D3D12_BLEND_DESC>();
+			if (!blend)
+			{
+				return false;
+			}
+
+			Add(arg_type, blend->AlphaToCoverageEnable);
+			AddValue(blend->IndependentBlendEnable);
+			for (const D3D12_RENDER_TARGET_BLEND_DESC& target : blend->RenderTarget)
+			{
+				AddValue(target.BlendEnable);
+				AddValue(target.LogicOpEnable);
+				AddValue(target.SrcBlend);
+				AddValue(target.DestBlend);
+				AddValue(target.BlendOp);
+				AddValue(target.SrcBlendAlpha);
+				AddValue(target.DestBlendAlpha);
+				AddValue(target.BlendOpAlpha);
+				AddValue(target.LogicOp);
+				AddValue(target.RenderTargetWriteMask);
+			}
+
+			return true;
+		}
+
+		bool AddDepthStencil()
+		{
+			const D3D12_DEPTH_STENCIL_DESC* depth_stencil = Next<D3D12_DEPTH_STENCIL_DESC>();
+			if (!depth_stencil)
+			{
+				return false;
+			}
+
+			// Both versions hash the same, as the pipeline is the same.
+			D3D12_DEPTH_STENCIL_DESC1 depth_stencil1 = { };
+			depth_stencil1.DepthEnable = depth_stencil->DepthEnable;
+			depth_stencil1.DepthWriteMask = depth_stencil->DepthWriteMask;
+			depth_stencil1.DepthFunc = depth_stencil->DepthFunc;
+			depth_stencil1.StencilEnable = depth_stencil->StencilEnable;
+			depth_stencil1.StencilReadMask = depth_stencil->StencilReadMask;
+			depth_stencil1.StencilWriteMask = depth_stencil->StencilWriteMask;
+			depth_stencil1.FrontFace = depth_stencil->FrontFace;
+			depth_stencil1.BackFace = depth_stencil->BackFace;
+			depth_stencil1.DepthBoundsTestEnable = FALSE;
+			AddDepthStencilDesc(depth_stencil1);
+
+			return true;
+		}
+
+		bool AddDepthStencil1()
+		{
+			const D3D12_DEPTH_STENCIL_DESC1* depth_stencil = Next<D3D12_DEPTH_STENCIL_DESC1>();
+			if (!depth_stencil)
+			{
+				return false;
+			}
+
+			AddDepthStencilDesc(*depth_stencil);
+			return true;
+		}
+
+		void AddDepthStencilDesc(const D3D12_DEPTH_STENCIL_DESC1& arg_depth_stencil)
+		{
+			Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL1, arg_depth_stencil.DepthEnable);
+			AddValue(arg_depth_stencil.DepthWriteMask);
+			AddValue(arg_depth_stencil.DepthFunc);
+			AddValue(arg_depth_stencil.StencilEnable);
+			AddValue(arg_depth_stencil.StencilReadMask);
+			AddValue(arg_depth_stencil.StencilWriteMask);
+			AddValue(arg_depth_stencil.FrontFace);
+			AddValue(arg_depth_stencil.BackFace);
+			AddValue(arg_depth_stencil.DepthBoundsTestEnable);
+		}
+
+		// Hash a value without padding, preceded by the type of its subobject.
+		template<typename T>
+		void Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE arg_type, const T& arg_value)
+		{
+			AddValue(arg_type);
+			AddValue(arg_value);
+		}
+
+		template<typename T>
+		void AddValue(const T& arg_value)
+		{
+			hash_ = HashValue(arg_value, hash_);
+		}
+
+		void AddString(const char* arg_string)
+		{
+			size_t length = arg_string ? strlen(arg_string) : 0;
+			AddValue(length);
+			hash_ = HashBytes(arg_string, length, hash_);
+		}
+
+		const uint8_t* stream_;
+		size_t size_;
+		size_t offset_;
+
+		const std::unordered_map<ID3D12RootSignature*, uint64_t>& root_signature_hashes_;
+		uint64_t hash_;
+	};
+}
+
+HRESULT HashPipelineStream(const D3D12_PIPELINE_STATE_STREAM_DESC& arg_desc,
+						   const std::unordered_map<ID3D12RootSignature*, uint64_t>& arg_root_signature_hashes, uint64_t& arg_hash)
+{
+	PipelineStreamHasher hasher(arg_desc, arg_root_signature_hashes);
+	return hasher.Hash(arg_hash);
+}
@@ -0,0 +1,24 @@
+/**
+* Stable hashing of pipeline streams, the key pipeline states are cached by. The stream is walked
+* subobject by subobject with the layout of the D3DX12 stream helpers (each subobject is its type
+* followed by its description, aligned to pointers), but without D3DX12 or the D3D12 runtime, so
+* it only needs the D3D12 type declarations. Every subobject is hashed with its type, pointers are
+* followed, and structures with padding are hashed field by field.
+*/
+#pragma once
+
+#include <d3d12.h>
+
+#include <cstdint>
+#include <unordered_map>
+
+/**
+* Hash the contents of a pipeline stream.
+* @param arg_root_signature_hashes The hash to use in place of each root signature the stream may
+* reference, as pointers differ between launches.
+* @param arg_hash Set to the hash of the stream.
+* @returns E_INVALIDARG if the stream holds an unknown subobject, a cached PSO, a root signature
+* without a hash, or is truncated.
+*/
+HRESULT HashPipelineStream(const D3D12_PIPELINE_STATE_STREAM_DESC& arg_desc,
+						   const std::unordered_map<ID3D12RootSignature*, uint64_t>& arg_root_signature_hashes, uint64_t& arg_hash);
@@ -0,0 +1,142 @@
+#include <queue_telemetry.h>
+
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+
+QueueTelemetry::QueueTelemetry(size_t arg_window_size)
+	: window_size_(std::max<size_t>(1, arg_window_size))
+	, t0_(Clock::now())
+	, histograms_()
+{ }
+
+void QueueTelemetry::OnSubmit(uint64_t arg_fence_value)
+{
+	assert((pending_.empty() || pending_.back().fence_value < arg_fence_value) && "Fence values must increase.");
+	pending_.push_back(PendingSubmission{arg_fence_value, Clock::now(), Clock::duration()});
+}
+
+void QueueTelemetry::OnCpuWait(uint64_t arg_fence_value, Clock::duration arg_blocked_time)
+{
+	// Pending submissions are sorted by fence value.
+	auto iter = std::lower_bound(pending_.begin(), pending_.end(), arg_fence_value,
+								 [](const PendingSubmission& arg_entry, uint64_t arg_value) { return arg_entry.fence_value < arg_value; });
+	if (iter != pending_.end() && iter->fence_value == arg_fence_value)
+	{
+		iter->cpu_wait += arg_blocked_time;
+	}
+}
+
+void QueueTelemetry::OnCompleted(uint64_t arg_completed_value)
+{
+	if (pending_.empty() || pending_.front().fence_value > arg_completed_value)
+	{
+		return;
+	}
+
+	Clock::time_point now = Clock::now();
+	while (!pending_.empty() && pending_.front().fence_value <= arg_completed_value)
+	{
+		const PendingSubmission& entry = pending_.front();
+
+		Sample sample;
+		sample.fence_value = entry.fence_value;
+		sample.submit_time_us = std::chrono::duration<double, std::micro>(entry.submit_time - t0_).count();
+		sample.gpu_latency_us = std::chrono::duration<double, std::micro>(now - entry.submit_time).count();
+		sample.cpu_wait_us = std::chrono::duration<double, std::micro>(entry.cpu_wait).count();
+		pending_.pop_front();
+
+		if (samples_.size() == window_size_)
+		{
+			AddToHistograms(samples_.front(), -1);
+			samples_.pop_front();
+		}
+		samples_.push_back(sample);
+		AddToHistograms(sample, 1);
+	}
+}
+
+double QueueTelemetry::GetPercentile(Metric arg_metric, double arg_percentile) const
+{
+	if (samples_.empty())
+	{
+		return 0.0;
+	}
+
+	std::vector<double> values;
+	values.reserve(samples_.size());
+	for (const Sample& sample : samples_)
+	{
+		values.push_back(GetValue(sample, arg_metric));
+	}
+
+	double clamped = std::min(100.0, std::max(0.0, arg_percentile));
+	size_t index = static_cast<size_t>(clamped / 100.0 * (values.size() - 1) + 0.5);
+	std::nth_element(values.begin(), values.begin() + index, values.end());
+
+	return values[index];
+}
+
+const QueueTelemetry::Histogram& QueueTelemetry::GetHistogram(Metric arg_metric) const
+{
+	return histograms_[arg_metric];
+}
+
+const std::deque<QueueTelemetry::Sample>& QueueTelemetry::GetSamples() const
+{
+	return samples_;
+}
+
+bool QueueTelemetry::DumpCsv(const std::string& arg_path) const
+{
+	std::ofstream file(arg_path);
+	if (!file)
+	{
+		return false;
+	}
+
+	file << "fence_value,submit_time_us,gpu_latency_us,cpu_wait_us\n";
+	for (const Sample& sample : samples_)
+	{
+		file << sample.fence_value << ',' << sample.submit_time_us << ','
+			<< sample.gpu_latency_us << ',' << sample.cpu_wait_us << '\n';
+	}
+
+	return static_cast<bool>(file);
+}
+
+void QueueTelemetry::Reset()
+{
+	pending_.clear();
+	samples_.clear();
+	for (Histogram& histogram : histograms_)
+	{
+		histogram.fill(0);
+	}
+}
+
+size_t QueueTelemetry::GetBucket(double arg_microseconds)
+{
+	size_t bucket = 0;
+	double upper = 1.0;
+	while (arg_microseconds >= upper && bucket < bucket_count_ - 1)
+	{
+		upper *= 2.0;
+		++bucket;
+	}
+
+	return bucket;
+}
+
+double QueueTelemetry::GetValue(const Sample& arg_sample, Metric arg_metric)
+{
+	return arg_metric == GpuLatency ? arg_sample.gpu_latency_us : arg_sample.cpu_wait_us;
+}
+
+void QueueTelemetry::AddToHistograms(const Sample& arg_sample, int arg_delta)
+{
+	for (int metric = 0; metric < MetricCount; ++metric)
+	{
+		histograms_[metric][GetBucket(GetValue(arg_sample, static_cast<Metric>(metric)))] += arg_delta;
+	}
+}
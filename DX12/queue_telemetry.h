@@ -0,0 +1,86 @@
+/**
+* Latency telemetry for a command queue. For every fence value the queue hands out
+* the CPU submit time, the time the fence was observed complete and the time CPU
+* waiters spent blocked on it are recorded into a rolling window.
+*/
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+class QueueTelemetry
+{
+public:
+	using Clock = std::chrono::high_resolution_clock;
+
+	enum Metric
+	{
+		GpuLatency, // Time between the CPU submit and the fence being observed complete.
+		CpuWait,    // Time a CPU waiter spent blocked on the fence.
+		MetricCount
+	};
+
+	// Histogram buckets are powers of two in microseconds: [0, 1), [1, 2), [2, 4) ... [2^30, inf).
+	static const size_t bucket_count_ = 32;
+	using Histogram = std::array<uint32_t, bucket_count_>;
+
+	// A single completed submission.
+	struct Sample
+	{
+		uint64_t fence_value;
+		double submit_time_us;  // Relative to the creation of the telemetry object.
+		double gpu_latency_us;
+		double cpu_wait_us;
+	};
+
+	/**
+	* @param arg_window_size The number of most recent submissions the statistics are computed over.
+	*/
+	QueueTelemetry(size_t arg_window_size = 1024);
+
+	// A fence value has been signaled on the queue.
+	void OnSubmit(uint64_t arg_fence_value);
+	// A CPU thread was blocked waiting for a fence value.
+	void OnCpuWait(uint64_t arg_fence_value, Clock::duration arg_blocked_time);
+	// The queue's fence has been observed at the given completed value.
+	void OnCompleted(uint64_t arg_completed_value);
+
+	/**
+	* Get a percentile over the rolling window in microseconds.
+	* @param arg_percentile A value in the range [0, 100].
+	*/
+	double GetPercentile(Metric arg_metric, double arg_percentile) const;
+	const Histogram& GetHistogram(Metric arg_metric) const;
+	const std::deque<Sample>& GetSamples() const;
+
+	// Write all samples in the rolling window to a CSV file. Returns false if the file could not be written.
+	bool DumpCsv(const std::string& arg_path) const;
+
+	void Reset();
+
+	// Histogram bucket that contains the given duration.
+	static size_t GetBucket(double arg_microseconds);
+
+private:
+	struct PendingSubmission
+	{
+		uint64_t fence_value;
+		Clock::time_point submit_time;
+		Clock::duration cpu_wait;
+	};
+
+	static double GetValue(const Sample& arg_sample, Metric arg_metric);
+	void AddToHistograms(const Sample& arg_sample, int arg_delta);
+
+	size_t window_size_;
+	Clock::time_point t0_;
+
+	// Submissions in fence order that have not been observed complete yet.
+	std::deque<PendingSubmission> pending_;
+	std::deque<Sample> samples_;
+	Histogram histograms_[MetricCount];
+};
@@ -0,0 +1,319 @@
+#include <residency_manager.h>
+#include <helpers.h>
+
+#include <algorithm>
+#include <cassert>
+
+D3D12ResidencyDevice::D3D12ResidencyDevice(Microsoft::WRL::ComPtr<ID3D12Device2> arg_device, Microsoft::WRL::ComPtr<IDXGIAdapter3> arg_adapter)
+	: d3d12_device_(arg_device)
+	, dxgi_adapter_(arg_adapter)
+{ }
+
+UINT64 D3D12ResidencyDevice::GetBudget()
+{
+	DXGI_QUERY_VIDEO_MEMORY_INFO info;
+	ThrowIfFailed(dxgi_adapter_->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &info));
+
+	return info.Budget;
+}
+
+UINT64 D3D12ResidencyDevice::GetUsage()
+{
+	DXGI_QUERY_VIDEO_MEMORY_INFO info;
+	ThrowIfFailed(dxgi_adapter_->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &info));
+
+	return info.CurrentUsage;
+}
+
+void D3D12ResidencyDevice::MakeResident(ID3D12Pageable* const* arg_objects, UINT arg_count)
+{
+	ThrowIfFailed(d3d12_device_->MakeResident(arg_count, arg_objects));
+}
+
+void D3D12ResidencyDevice::Evict(ID3D12Pageable* const* arg_objects, UINT arg_count)
+{
+	ThrowIfFailed(d3d12_device_->Evict(arg_count, arg_objects));
+}
+
+SimulatedResidencyDevice::SimulatedResidencyDevice(UINT64 arg_budget)
+	: budget_(arg_budget)
+	, usage_(0)
+	, made_resident_count_(0)
+	, evicted_count_(0)
+{ }
+
+void SimulatedResidencyDevice::SetBudget(UINT64 arg_budget)
+{
+	budget_ = arg_budget;
+}
+
+void SimulatedResidencyDevice::SetUsage(UINT64 arg_usage)
+{
+	usage_ = arg_usage;
+}
+
+UINT64 SimulatedResidencyDevice::GetBudget()
+{
+	return budget_;
+}
+
+UINT64 SimulatedResidencyDevice::GetUsage()
+{
+	return usage_;
+}
+
+void SimulatedResidencyDevice::MakeResident(ID3D12Pageable* const*, UINT arg_count)
+{
+	made_resident_count_ += arg_count;
+}
+
+void SimulatedResidencyDevice::Evict(ID3D12Pageable* const*, UINT arg_count)
+{
+	evicted_count_ += arg_count;
+}
+
+uint64_t SimulatedResidencyDevice::GetMadeResidentCount() const
+{
+	return made_resident_count_;
+}
+
+uint64_t SimulatedResidencyDevice::GetEvictedCount() const
+{
+	return evicted_count_;
+}
+
+ResidencyManager::ResidencyManager(std::shared_ptr<ResidencyDevice> arg_device)
+	: device_(arg_device)
+	, budget_limit_(UINT64_MAX)
+	, budget_(0)
+	, request_id_(0)
+	, tracked_bytes_(0)
+	, resident_bytes_(0)
+	, untracked_bytes_(0)
+	, evicted_count_(0)
+	, made_resident_count_(0)
+	, over_budget_count_(0)
+{
+	UpdateBudget();
+}
+
+ResidencyManager::~ResidencyManager()
+{ }
+
+void ResidencyManager::SetBudgetLimit(UINT64 arg_limit)
+{
+	budget_limit_ = arg_limit;
+	UpdateBudget();
+}
+
+UINT64 ResidencyManager::GetBudgetLimit() const
+{
+	return budget_limit_;
+}
+
+ResidencyManager::Handle ResidencyManager::Track(ID3D12Pageable* arg_object, UINT64 arg_size)
+{
+	Handle handle;
+	if (!free_handles_.empty())
+	{
+		handle = free_handles_.back();
+		free_handles_.pop_back();
+	}
+	else
+	{
+		handle = static_cast<Handle>(entries_.size());
+		entries_.emplace_back();
+	}
+
+	Entry& entry = entries_[handle];
+	entry.object = arg_object;
+	entry.size = arg_size;
+	entry.last_used_fence_values.fill(0);
+	entry.request_id = 0;
+	entry.resident = true;
+	entry.in_use = true;
+	entry.lru_position = lru_.insert(lru_.end(), handle);
+
+	tracked_bytes_ += arg_size;
+	resident_bytes_ += arg_size;
+
+	return handle;
+}
+
+void ResidencyManager::Untrack(Handle arg_handle)
+{
+	assert(arg_handle < entries_.size() && entries_[arg_handle].in_use && "Invalid residency handle.");
+
+	Entry& entry = entries_[arg_handle];
+	if (entry.resident)
+	{
+		lru_.erase(entry.lru_position);
+		resident_bytes_ -= entry.size;
+	}
+	tracked_bytes_ -= entry.size;
+
+	entry.object = nullptr;
+	entry.in_use = false;
+	free_handles_.push_back(arg_handle);
+}
+
+bool ResidencyManager::MakeResident(const Handle* arg_handles, size_t arg_count, const FenceValues& arg_completed_fence_values)
+{
+	UpdateBudget();
+	++request_id_;
+
+	// Move the requested objects to the back of the list so they are not evicted to make room for each other.
+	UINT64 required_bytes = 0;
+	for (size_t i = 0; i < arg_count; ++i)
+	{
+		assert(arg_handles[i] < entries_.size() && entries_[arg_handles[i]].in_use && "Invalid residency handle.");
+
+		Entry& entry = entries_[arg_handles[i]];
+		if (entry.request_id == request_id_)
+		{
+			continue;
+		}
+		entry.request_id = request_id_;
+
+		if (entry.resident)
+		{
+			lru_.splice(lru_.end(), lru_, entry.lru_position);
+		}
+		else
+		{
+			required_bytes += entry.size;
+		}
+	}
+
+	bool fits = EvictUntilFits(required_bytes, arg_completed_fence_values);
+
+	batch_.clear();
+	for (size_t i = 0; i < arg_count; ++i)
+	{
+		Entry& entry = entries_[arg_handles[i]];
+		if (!entry.resident)
+		{
+			entry.resident = true;
+			entry.lru_position = lru_.insert(lru_.end(), arg_handles[i]);
+			resident_bytes_ += entry.size;
+			batch_.push_back(entry.object);
+		}
+	}
+
+	if (!batch_.empty())
+	{
+		device_->MakeResident(batch_.data(), static_cast<UINT>(batch_.size()));
+		made_resident_count_ += batch_.size();
+	}
+
+	return fits;
+}
+
+void ResidencyManager::MarkUsed(const Handle* arg_handles, size_t arg_count, Queue arg_queue, uint64_t arg_fence_value)
+{
+	assert(arg_queue < QUEUE_COUNT && "Invalid queue.");
+
+	for (size_t i = 0; i < arg_count; ++i)
+	{
+		assert(arg_handles[i] < entries_.size() && entries_[arg_handles[i]].in_use && "Invalid residency handle.");
+
+		Entry& entry = entries_[arg_handles[i]];
+		assert(entry.resident && "Objects must be made resident before they are used.");
+
+		entry.last_used_fence_values[arg_queue] = std::max(entry.last_used_fence_values[arg_queue], arg_fence_value);
+		lru_.splice(lru_.end(), lru_, entry.lru_position);
+	}
+}
+
+bool ResidencyManager::Trim(const FenceValues& arg_completed_fence_values)
+{
+	UpdateBudget();
+
+	// Nothing is requested, so no object is protected from eviction.
+	++request_id_;
+	return EvictUntilFits(0, arg_completed_fence_values);
+}
+
+bool ResidencyManager::IsResident(Handle arg_handle) const
+{
+	assert(arg_handle < entries_.size() && entries_[arg_handle].in_use && "Invalid residency handle.");
+
+	return entries_[arg_handle].resident;
+}
+
+ResidencyManager::Stats ResidencyManager::GetStats() const
+{
+	Stats stats;
+	stats.tracked_count = entries_.size() - free_handles_.size();
+	stats.resident_count = lru_.size();
+	stats.tracked_bytes = tracked_bytes_;
+	stats.resident_bytes = resident_bytes_;
+	stats.untracked_bytes = untracked_bytes_;
+	stats.budget = budget_;
+	stats.evicted_count = evicted_count_;
+	stats.made_resident_count = made_resident_count_;
+	stats.over_budget_count = over_budget_count_;
+
+	return stats;
+}
+
+void ResidencyManager::UpdateBudget()
+{
+	budget_ = std::min(device_->GetBudget(), budget_limit_);
+
+	// The usage includes the resident tracked objects. Whatever it holds beyond them, such as
+	// committed resources and the swap chain, takes up budget the tracked objects can not use.
+	UINT64 usage = device_->GetUsage();
+	untracked_bytes_ = usage > resident_bytes_ ? usage - resident_bytes_ : 0;
+}
+
+bool ResidencyManager::EvictUntilFits(UINT64 arg_required_bytes, const FenceValues& arg_completed_fence_values)
+{
+	batch_.clear();
+
+	auto it = lru_.begin();
+	while (resident_bytes_ + untracked_bytes_ + arg_required_bytes > budget_ && it != lru_.end())
+	{
+		Entry& entry = entries_[*it];
+
+		// Objects are used on several queues, so an object the GPU is still using can be
+		// followed by ones it has finished with. Skip it rather than stopping.
+		if (entry.request_id == request_id_ || IsUsedByGpu(entry, arg_completed_fence_values))
+		{
+			++it;
+			continue;
+		}
+
+		it = lru_.erase(it);
+		entry.resident = false;
+		resident_bytes_ -= entry.size;
+		batch_.push_back(entry.object);
+	}
+
+	if (!batch_.empty())
+	{
+		device_->Evict(batch_.data(), static_cast<UINT>(batch_.size()));
+		evicted_count_ += batch_.size();
+	}
+
+	bool fits = resident_bytes_ + untracked_bytes_ + arg_required_bytes <= budget_;
+	if (!fits)
+	{
+		++over_budget_count_;
+	}
+
+	return fits;
+}
+
+bool ResidencyManager::IsUsedByGpu(const Entry& arg_entry, const FenceValues& arg_completed_fence_values)
+{
+	for (size_t queue = 0; queue < QUEUE_COUNT; ++queue)
+	{
+		if (arg_entry.last_used_fence_values[queue] > arg_completed_fence_values[queue])
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,192 @@
+/**
+* The residency manager keeps the tracked heaps and resources within a video memory budget.
+* Objects are kept in a least recently used list ordered by the fence value of the last
+* submission that used them. When the budget is exceeded, objects the GPU has finished with
+* are evicted, oldest first, and they are made resident again before a submission needs them.
+* Video memory the process uses for objects that are not tracked is left out of the budget.
+*
+* Fence values of different queues are not comparable, so every object keeps the last fence
+* value of each queue that used it, and is only evicted once all of them have completed.
+*/
+#pragma once
+
+#include <d3d12.h>
+#include <dxgi1_4.h>
+#include <wrl.h>
+
+#include <array>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <vector>
+
+/**
+* The device functions used by the residency manager. The simulated device below stands in
+* for a GPU so the budget can be driven by hand.
+*/
+class ResidencyDevice
+{
+public:
+	virtual ~ResidencyDevice() { }
+
+	// The current video memory budget of the process in bytes.
+	virtual UINT64 GetBudget() = 0;
+	// The video memory the process currently uses in bytes, including objects that are not tracked.
+	virtual UINT64 GetUsage() = 0;
+	virtual void MakeResident(ID3D12Pageable* const* arg_objects, UINT arg_count) = 0;
+	virtual void Evict(ID3D12Pageable* const* arg_objects, UINT arg_count) = 0;
+};
+
+// Forwards the residency functions to a D3D12 device and reads the budget of the adapter's local memory.
+class D3D12ResidencyDevice : public ResidencyDevice
+{
+public:
+	D3D12ResidencyDevice(Microsoft::WRL::ComPtr<ID3D12Device2> arg_device, Microsoft::WRL::ComPtr<IDXGIAdapter3> arg_adapter);
+
+	virtual UINT64 GetBudget() override;
+	virtual UINT64 GetUsage() override;
+	virtual void MakeResident(ID3D12Pageable* const* arg_objects, UINT arg_count) override;
+	virtual void Evict(ID3D12Pageable* const* arg_objects, UINT arg_count) override;
+
+private:
+	Microsoft::WRL::ComPtr<ID3D12Device2> d3d12_device_;
+	Microsoft::WRL::ComPtr<IDXGIAdapter3> dxgi_adapter_;
+};
+
+/**
+* A CPU stand-in with a budget and usage that are set by hand. Objects may be null. The usage
+* starts at 0, so only tracked objects count against the budget until it is set.
+*/
+class SimulatedResidencyDevice : public ResidencyDevice
+{
+public:
+	SimulatedResidencyDevice(UINT64 arg_budget);
+
+	void SetBudget(UINT64 arg_budget);
+	void SetUsage(UINT64 arg_usage);
+
+	virtual UINT64 GetBudget() override;
+	virtual UINT64 GetUsage() override;
+	virtual void MakeResident(ID3D12Pageable* const* arg_objects, UINT arg_count) override;
+	virtual void Evict(ID3D12Pageable* const* arg_objects, UINT arg_count) override;
+
+	// Number of objects passed to MakeResident and Evict so far.
+	uint64_t GetMadeResidentCount() const;
+	uint64_t GetEvictedCount() const;
+
+private:
+	UINT64 budget_;
+	UINT64 usage_;
+	uint64_t made_resident_count_;
+	uint64_t evicted_count_;
+};
+
+class ResidencyManager
+{
+public:
+	using Handle = uint32_t;
+	static const Handle invalid_handle_ = ~0u;
+
+	// The queues that use objects. Fence values are only compared with those of the same queue.
+	enum Queue
+	{
+		DIRECT_QUEUE,
+		COMPUTE_QUEUE,
+		COPY_QUEUE,
+		QUEUE_COUNT
+	};
+
+	// A fence value of every queue, indexed by Queue.
+	using FenceValues = std::array<uint64_t, QUEUE_COUNT>;
+
+	struct Stats
+	{
+		size_t tracked_count;
+		size_t resident_count;
+		UINT64 tracked_bytes;
+		UINT64 resident_bytes;
+		UINT64 untracked_bytes;       // Video memory used by objects that are not tracked, e.g. committed resources.
+		UINT64 budget;
+		uint64_t evicted_count;       // Objects evicted since creation.
+		uint64_t made_resident_count; // Objects paged back in since creation.
+		uint64_t over_budget_count;   // Calls that could not get within the budget.
+	};
+
+	ResidencyManager(std::shared_ptr<ResidencyDevice> arg_device);
+	virtual ~ResidencyManager();
+
+	/**
+	* Limit the budget below the one reported by the device, e.g. to leave room for other
+	* applications or to test behaviour under memory pressure.
+	*/
+	void SetBudgetLimit(UINT64 arg_limit);
+	UINT64 GetBudgetLimit() const;
+
+	// Start tracking a newly created object. Objects are resident when they are created.
+	Handle Track(ID3D12Pageable* arg_object, UINT64 arg_size);
+	// Stop tracking an object before it is released.
+	void Untrack(Handle arg_handle);
+
+	/**
+	* Make the objects resident ahead of a submission that uses them. Evicts least recently
+	* used objects the GPU has finished with if the budget would otherwise be exceeded.
+	* @param arg_completed_fence_values The completed fence value of every queue.
+	* @returns false if the objects only fit by exceeding the budget.
+	*/
+	bool MakeResident(const Handle* arg_handles, size_t arg_count, const FenceValues& arg_completed_fence_values);
+
+	// Record that the submission with the fence value on the queue uses the objects.
+	void MarkUsed(const Handle* arg_handles, size_t arg_count, Queue arg_queue, uint64_t arg_fence_value);
+
+	/**
+	* Re-read the budget and evict least recently used objects the GPU has finished with until
+	* the resident objects fit. Call once per frame so budget changes are picked up.
+	* @returns false if the resident objects still exceed the budget.
+	*/
+	bool Trim(const FenceValues& arg_completed_fence_values);
+
+	bool IsResident(Handle arg_handle) const;
+	Stats GetStats() const;
+
+private:
+	struct Entry
+	{
+		ID3D12Pageable* object;
+		UINT64 size;
+		FenceValues last_used_fence_values;
+		uint64_t request_id; // The MakeResident call that last requested the object.
+		bool resident;
+		bool in_use;
+		std::list<Handle>::iterator lru_position;
+	};
+
+	// Re-read the budget, and the usage of objects that are not tracked, which is left out of it.
+	void UpdateBudget();
+
+	// Evict least recently used objects until arg_required_bytes more fit in the budget.
+	bool EvictUntilFits(UINT64 arg_required_bytes, const FenceValues& arg_completed_fence_values);
+
+	// Whether a submission on any queue that uses the object has not completed yet.
+	static bool IsUsedByGpu(const Entry& arg_entry, const FenceValues& arg_completed_fence_values);
+
+	std::shared_ptr<ResidencyDevice> device_;
+	UINT64 budget_limit_;
+	UINT64 budget_;
+
+	std::vector<Entry> entries_;
+	std::vector<Handle> free_handles_;
+
+	// Resident objects, least recently used first.
+	std::list<Handle> lru_;
+
+	uint64_t request_id_;
+	UINT64 tracked_bytes_;
+	UINT64 resident_bytes_;
+	UINT64 untracked_bytes_;
+	uint64_t evicted_count_;
+	uint64_t made_resident_count_;
+	uint64_t over_budget_count_;
+
+	// Scratch array for batching device calls.
+	std::vector<ID3D12Pageable*> batch_;
+};
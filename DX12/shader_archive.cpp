@@ -0,0 +1,245 @@
+#include <shader_archive.h>
+#include <hash.h>
+#include <helpers.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+
+ShaderArchive::ShaderArchive(const std::wstring& arg_path)
+	: file_(arg_path)
+	, entries_(nullptr)
+	, entry_count_(0)
+{
+	const uint8_t* data = file_.GetData();
+	uint64_t size = file_.GetSize();
+	if (size < sizeof(FileHeader))
+	{
+		ThrowIfFailed(E_FAIL);
+	}
+
+	// Check the index once, so lookups can trust it.
+	const FileHeader* header = reinterpret_cast<const FileHeader*>(data);
+	entries_ = reinterpret_cast<const Entry*>(data + sizeof(FileHeader));
+	entry_count_ = header->entry_count;
+
+	if (header->magic != file_magic_ || header->format_version != format_version_ ||
+		(size - sizeof(FileHeader)) / sizeof(Entry) < entry_count_)
+	{
+		ThrowIfFailed(E_FAIL);
+	}
+	for (uint32_t i = 0; i < entry_count_; ++i)
+	{
+		const Entry& entry = entries_[i];
+		if (uint64_t(entry.name_offset) + entry.name_length > size || entry.data_offset > size || entry.data_size > size - entry.data_offset ||
+			(i > 0 && entries_[i - 1].name_hash > entry.name_hash))
+		{
+			ThrowIfFailed(E_FAIL);
+		}
+	}
+}
+
+ShaderArchive::~ShaderArchive()
+{ }
+
+D3D12_SHADER_BYTECODE ShaderArchive::GetShader(const char* arg_name) const
+{
+	const Entry* entry = Find(arg_name);
+	if (!entry)
+	{
+		ThrowIfFailed(E_INVALIDARG);
+	}
+
+	return D3D12_SHADER_BYTECODE{ file_.GetData() + entry->data_offset, static_cast<SIZE_T>(entry->data_size) };
+}
+
+bool ShaderArchive::Contains(const char* arg_name) const
+{
+	return Find(arg_name) != nullptr;
+}
+
+size_t ShaderArchive::GetShaderCount() const
+{
+	return entry_count_;
+}
+
+const ShaderArchive::Entry* ShaderArchive::Find(const char* arg_name) const
+{
+	size_t name_length = strlen(arg_name);
+	uint64_t name_hash = HashBytes(arg_name, name_length);
+
+	const Entry* end = entries_ + entry_count_;
+	const Entry* entry = std::lower_bound(entries_, end, name_hash, [](const Entry& arg_entry, uint64_t arg_hash)
+	{
+		return arg_entry.name_hash < arg_hash;
+	});
+
+	// Compare the names in case of a hash collision.
+	for (; entry != end && entry->name_hash == name_hash; ++entry)
+	{
+		if (entry->name_length == name_length && memcmp(file_.GetData() + entry->name_offset, arg_name, name_length) == 0)
+		{
+			return entry;
+		}
+	}
+
+	return nullptr;
+}
+
+bool ShaderArchiveWriter::IsOutOfDate(const std::wstring& arg_archive_path, const std::wstring& arg_pattern)
+{
+	WIN32_FILE_ATTRIBUTE_DATA archive_attributes;
+	if (!GetFileAttributesExW(arg_archive_path.c_str(), GetFileExInfoStandard, &archive_attributes))
+	{
+		return true;
+	}
+
+	bool out_of_date = false;
+
+	WIN32_FIND_DATAW find_data;
+	HANDLE find = FindFirstFileW(arg_pattern.c_str(), &find_data);
+	if (find != INVALID_HANDLE_VALUE)
+	{
+		do
+		{
+			if (CompareFileTime(&find_data.ftLastWriteTime, &archive_attributes.ftLastWriteTime) > 0)
+			{
+				out_of_date = true;
+			}
+		} while (!out_of_date && FindNextFileW(find, &find_data));
+
+		FindClose(find);
+	}
+
+	return out_of_date;
+}
+
+void ShaderArchiveWriter::Add(const std::string& arg_name, const void* arg_data, size_t arg_size)
+{
+	const uint8_t* data = static_cast<const uint8_t*>(arg_data);
+	shaders_.push_back(Shader{arg_name, std::vector<uint8_t>(data, data + arg_size)});
+}
+
+bool ShaderArchiveWriter::AddFile(const std::string& arg_name, const std::wstring& arg_path)
+{
+	std::ifstream file(arg_path, std::ios::binary | std::ios::ate);
+	if (!file)
+	{
+		return false;
+	}
+
+	Shader shader;
+	shader.name = arg_name;
+	shader.data.resize(static_cast<size_t>(file.tellg()));
+	file.seekg(0);
+	if (!file.read(reinterpret_cast<char*>(shader.data.data()), shader.data.size()))
+	{
+		return false;
+	}
+
+	shaders_.push_back(std::move(shader));
+	return true;
+}
+
+size_t ShaderArchiveWriter::AddFiles(const std::wstring& arg_pattern)
+{
+	// Found file names are relative to the directory of the pattern.
+	size_t directory_end = arg_pattern.find_last_of(L"\\/");
+	std::wstring directory = directory_end != std::wstring::npos ? arg_pattern.substr(0, directory_end + 1) : std::wstring();
+
+	size_t added_count = 0;
+
+	WIN32_FIND_DATAW find_data;
+	HANDLE find = FindFirstFileW(arg_pattern.c_str(), &find_data);
+	if (find == INVALID_HANDLE_VALUE)
+	{
+		return 0;
+	}
+
+	do
+	{
+		if (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+		{
+			continue;
+		}
+
+		std::wstring file_name = find_data.cFileName;
+		std::wstring stem = file_name.substr(0, file_name.find_last_of(L'.'));
+
+		char name[MAX_PATH];
+		int name_length = WideCharToMultiByte(CP_UTF8, 0, stem.c_str(), static_cast<int>(stem.size()), name, sizeof(name), nullptr, nullptr);
+
+		if (name_length > 0 && AddFile(std::string(name, name_length), directory + file_name))
+		{
+			++added_count;
+		}
+	} while (FindNextFileW(find, &find_data));
+
+	FindClose(find);
+	return added_count;
+}
+
+bool ShaderArchiveWriter::Write(const std::wstring& arg_path) const
+{
+	using FileHeader = ShaderArchive::FileHeader;
+	using Entry = ShaderArchive::Entry;
+
+	// The index is sorted by name hash, so lookups can use a binary search.
+	std::vector<Entry> entries(shaders_.size());
+	std::vector<const Shader*> sorted_shaders(shaders_.size());
+	for (size_t i = 0; i < shaders_.size(); ++i)
+	{
+		sorted_shaders[i] = &shaders_[i];
+	}
+	std::sort(sorted_shaders.begin(), sorted_shaders.end(), [](const Shader* arg_a, const Shader* arg_b)
+	{
+		return HashBytes(arg_a->name.data(), arg_a->name.size()) < HashBytes(arg_b->name.data(), arg_b->name.size());
+	});
+
+	// Names follow the index, the bytecode follows the names.
+	uint64_t offset = sizeof(FileHeader) + sizeof(Entry) * entries.size();
+	for (size_t i = 0; i < sorted_shaders.size(); ++i)
+	{
+		entries[i].name_hash = HashBytes(sorted_shaders[i]->name.data(), sorted_shaders[i]->name.size());
+		entries[i].name_offset = static_cast<uint32_t>(offset);
+		entries[i].name_length = static_cast<uint32_t>(sorted_shaders[i]->name.size());
+		offset += sorted_shaders[i]->name.size();
+	}
+	for (size_t i = 0; i < sorted_shaders.size(); ++i)
+	{
+		offset = (offset + ShaderArchive::data_alignment_ - 1) & ~(ShaderArchive::data_alignment_ - 1);
+		entries[i].data_offset = offset;
+		entries[i].data_size = sorted_shaders[i]->data.size();
+		offset += sorted_shaders[i]->data.size();
+	}
+
+	std::ofstream file(arg_path, std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		return false;
+	}
+
+	FileHeader header = { };
+	header.magic = ShaderArchive::file_magic_;
+	header.format_version = ShaderArchive::format_version_;
+	header.entry_count = static_cast<uint32_t>(entries.size());
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(entries.data()), sizeof(Entry) * entries.size());
+
+	for (const Shader* shader : sorted_shaders)
+	{
+		file.write(shader->name.data(), shader->name.size());
+	}
+
+	static const char padding[ShaderArchive::data_alignment_] = { };
+	for (size_t i = 0; i < sorted_shaders.size(); ++i)
+	{
+		uint64_t position = static_cast<uint64_t>(file.tellp());
+		file.write(padding, static_cast<std::streamsize>(entries[i].data_offset - position));
+		file.write(reinterpret_cast<const char*>(sorted_shaders[i]->data.data()), sorted_shaders[i]->data.size());
+	}
+
+	file.close();
+	return !file.fail();
+}
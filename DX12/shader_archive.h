@@ -0,0 +1,98 @@
+/**
+* The shader archive packs compiled shaders into one file with an index sorted by the hash of
+* the shader names. The archive is memory-mapped, and shaders are returned as bytecode that
+* points into the mapping, so loading a shader neither opens a file nor copies it. The
+* bytecode is valid as long as the archive is.
+*/
+#pragma once
+
+#include <mapped_file.h>
+
+#include <d3d12.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class ShaderArchive
+{
+public:
+	static const uint32_t format_version_ = 1;
+
+	// Map an archive. Throws if it can not be opened or is not a valid archive.
+	ShaderArchive(const std::wstring& arg_path);
+	virtual ~ShaderArchive();
+
+	ShaderArchive(const ShaderArchive&) = delete;
+	ShaderArchive& operator=(const ShaderArchive&) = delete;
+
+	// Get the bytecode of a shader. Throws if the archive does not contain it.
+	D3D12_SHADER_BYTECODE GetShader(const char* arg_name) const;
+	bool Contains(const char* arg_name) const;
+
+	size_t GetShaderCount() const;
+
+private:
+	friend class ShaderArchiveWriter;
+
+	struct FileHeader
+	{
+		uint32_t magic;
+		uint32_t format_version;
+		uint32_t entry_count;
+		uint32_t reserved;
+	};
+
+	// Offsets are from the start of the file.
+	struct Entry
+	{
+		uint64_t name_hash;
+		uint32_t name_offset;
+		uint32_t name_length;
+		uint64_t data_offset;
+		uint64_t data_size;
+	};
+
+	static const uint32_t file_magic_ = 0x52414853; // "SHAR"
+	static const uint64_t data_alignment_ = 16;
+
+	const Entry* Find(const char* arg_name) const;
+
+	MappedFile file_;
+
+	const Entry* entries_;
+	uint32_t entry_count_;
+};
+
+// Packs shaders into an archive.
+class ShaderArchiveWriter
+{
+public:
+	/**
+	* Whether the archive is missing or older than one of the files matching the pattern, e.g. L"*.cso".
+	*/
+	static bool IsOutOfDate(const std::wstring& arg_archive_path, const std::wstring& arg_pattern);
+
+	void Add(const std::string& arg_name, const void* arg_data, size_t arg_size);
+
+	// Add a compiled shader file. Returns false if it can not be read.
+	bool AddFile(const std::string& arg_name, const std::wstring& arg_path);
+
+	/**
+	* Add all files that match the pattern, named after the file without its extension.
+	* @returns The number of files added.
+	*/
+	size_t AddFiles(const std::wstring& arg_pattern);
+
+	// Write the archive. Returns false if it could not be written.
+	bool Write(const std::wstring& arg_path) const;
+
+private:
+	struct Shader
+	{
+		std::string name;
+		std::vector<uint8_t> data;
+	};
+
+	std::vector<Shader> shaders_;
+};
@@ -0,0 +1,69 @@
+#include <submission_graph.h>
+#include <application.h>
+#include <command_list.h>
+#include <command_queue.h>
+
+#include <cassert>
+
+SubmissionGraph::SubmissionGraph(Application &arg_app)
+	: app_(&arg_app)
+	, submitted_(false)
+{ }
+
+SubmissionGraph::NodeId SubmissionGraph::AddWork(D3D12_COMMAND_LIST_TYPE arg_type,
+												  std::shared_ptr<CommandList> arg_command_list,
+												  const std::vector<NodeId>& arg_dependencies)
+{
+	assert(!submitted_ && "Reset the graph before adding new work.");
+
+	NodeId id = nodes_.size();
+	for (NodeId dependency : arg_dependencies)
+	{
+		assert(dependency < id && "Dependencies must be added before the nodes that depend on them.");
+	}
+
+	nodes_.push_back(Node{app_->GetCommandQueue(arg_type).get(), std::move(arg_command_list), arg_dependencies, { }, 0});
+
+	return id;
+}
+
+void SubmissionGraph::AddExternalDependency(NodeId arg_node, const QueueSyncPoint& arg_sync_point)
+{
+	assert(arg_node < nodes_.size() && "Invalid node.");
+	nodes_[arg_node].external_dependencies.push_back(arg_sync_point);
+}
+
+void SubmissionGraph::Submit()
+{
+	assert(!submitted_ && "The graph has already been submitted.");
+
+	for (Node& node : nodes_)
+	{
+		for (const QueueSyncPoint& sync_point : node.external_dependencies)
+		{
+			node.queue->Wait(*sync_point.queue, sync_point.fence_value);
+		}
+
+		for (NodeId dependency : node.dependencies)
+		{
+			const Node& other = nodes_[dependency];
+			node.queue->Wait(*other.queue, other.fence_value);
+		}
+
+		node.fence_value = node.queue->ExecuteCommandList(std::move(node.command_list));
+	}
+
+	submitted_ = true;
+}
+
+QueueSyncPoint SubmissionGraph::GetSyncPoint(NodeId arg_node) const
+{
+	assert(submitted_ && arg_node < nodes_.size() && "Node has not been submitted.");
+	return QueueSyncPoint{nodes_[arg_node].queue, nodes_[arg_node].fence_value};
+}
+
+void SubmissionGraph::Reset()
+{
+	nodes_.clear();
+	submitted_ = false;
+}
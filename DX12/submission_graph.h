@@ -0,0 +1,76 @@
+/**
+* The submission graph collects command lists for the direct, compute and copy queues
+* together with their dependencies and submits them with GPU-side waits between queues.
+*/
+#pragma once
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class Application;
+class CommandList;
+class CommandQueue;
+
+// A point on a command queue's timeline that other work can depend on.
+struct QueueSyncPoint
+{
+	CommandQueue* queue;
+	uint64_t fence_value;
+};
+
+class SubmissionGraph
+{
+public:
+	using NodeId = size_t;
+
+	SubmissionGraph(Application &arg_app);
+
+	/**
+	* Add a recorded command list to the graph.
+	* @param arg_type The queue the command list will be executed on. The command list must have been
+	* obtained from that queue.
+	* @param arg_dependencies Nodes that have to finish on the GPU before this work starts. Dependencies
+	* must have been added before this node, so insertion order is always a valid submission order.
+	* @returns The id of the new node.
+	*/
+	NodeId AddWork(D3D12_COMMAND_LIST_TYPE arg_type,
+				   std::shared_ptr<CommandList> arg_command_list,
+				   const std::vector<NodeId>& arg_dependencies = {});
+
+	/**
+	* Make a node wait for work that was submitted outside of this graph.
+	*/
+	void AddExternalDependency(NodeId arg_node, const QueueSyncPoint& arg_sync_point);
+
+	/**
+	* Execute all nodes in order. Dependencies on other queues become GPU waits,
+	* dependencies on the same queue are implied by submission order.
+	*/
+	void Submit();
+
+	/**
+	* Get the fence value that signals completion of a submitted node.
+	*/
+	QueueSyncPoint GetSyncPoint(NodeId arg_node) const;
+
+	// Remove all nodes so the graph can be reused for the next frame.
+	void Reset();
+
+private:
+	struct Node
+	{
+		CommandQueue* queue;
+		std::shared_ptr<CommandList> command_list;
+		std::vector<NodeId> dependencies;
+		std::vector<QueueSyncPoint> external_dependencies;
+		uint64_t fence_value;
+	};
+
+	Application *app_;
+	std::vector<Node> nodes_;
+	bool submitted_;
+};
@@ -0,0 +1,225 @@
+#include <texture_allocator.h>
+#include <gpu_memory_tracker.h>
+#include <helpers.h>
+
+#include <algorithm>
+#include <cassert>
+
+TextureAllocator::TextureAllocator(std::shared_ptr<HeapAllocatorDevice> arg_device, uint32_t arg_block_order,
+								   ResidencyManager* arg_residency_manager, GpuMemoryTracker* arg_gpu_memory_tracker)
+	: device_(arg_device)
+	, block_order_(arg_block_order)
+	, residency_manager_(arg_residency_manager)
+	, gpu_memory_tracker_(arg_gpu_memory_tracker)
+{ }
+
+TextureAllocator::~TextureAllocator()
+{
+	for (Block& block : blocks_)
+	{
+		if (block.in_use)
+		{
+			ReleaseBlock(block);
+		}
+	}
+}
+
+HeapAllocation TextureAllocator::CreateTexture(const D3D12_RESOURCE_DESC& arg_desc, D3D12_RESOURCE_STATES arg_initial_state)
+{
+	assert(arg_desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER &&
+		   !(arg_desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) &&
+		   "The texture allocator only places non render target textures.");
+
+	D3D12_RESOURCE_ALLOCATION_INFO info = device_->GetResourceAllocationInfo(arg_desc);
+	if (info.SizeInBytes == UINT64_MAX)
+	{
+		// The resource description is invalid.
+		ThrowIfFailed(E_INVALIDARG);
+	}
+
+	UINT64 alignment = std::max<UINT64>(info.Alignment, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+
+	uint32_t block_index = ~0u;
+	UINT64 offset = BuddyAllocator::invalid_offset_;
+
+	for (uint32_t i = 0; i < blocks_.size() && offset == BuddyAllocator::invalid_offset_; ++i)
+	{
+		if (blocks_[i].in_use && blocks_[i].allocator)
+		{
+			offset = blocks_[i].allocator->Allocate(info.SizeInBytes, alignment);
+			block_index = i;
+		}
+	}
+
+	if (offset == BuddyAllocator::invalid_offset_)
+	{
+		UINT64 block_size = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT << block_order_;
+		bool dedicated = info.SizeInBytes > block_size || alignment > block_size;
+
+		block_index = CreateBlock(dedicated ? info.SizeInBytes : block_size, dedicated);
+		offset = dedicated ? 0 : blocks_[block_index].allocator->Allocate(info.SizeInBytes, alignment);
+		assert(offset != BuddyAllocator::invalid_offset_ && "A new block must fit the texture.");
+	}
+
+	HeapAllocation allocation;
+	allocation.block = block_index;
+	allocation.generation = blocks_[block_index].generation;
+	allocation.offset = offset;
+	allocation.size = info.SizeInBytes;
+
+	try
+	{
+		allocation.resource = device_->CreatePlacedResource(blocks_[block_index].heap.Get(), offset, arg_desc,
+															arg_initial_state, nullptr);
+	}
+	catch (...)
+	{
+		// Return the buddy block, and the heap if it was created for this texture alone.
+		Free(allocation);
+		throw;
+	}
+
+	return allocation;
+}
+
+void TextureAllocator::Free(HeapAllocation& arg_allocation)
+{
+	if (!arg_allocation.IsValid())
+	{
+		return;
+	}
+
+	// The slot of a stale allocation may hold another heap by now, which must not be touched.
+	assert(IsValid(arg_allocation) && "Stale texture allocation.");
+	if (!IsValid(arg_allocation))
+	{
+		arg_allocation = HeapAllocation();
+		return;
+	}
+
+	Block& block = blocks_[arg_allocation.block];
+	arg_allocation.resource.Reset();
+
+	if (block.allocator)
+	{
+		block.allocator->Free(arg_allocation.offset);
+	}
+	else
+	{
+		ReleaseBlock(block);
+	}
+
+	arg_allocation = HeapAllocation();
+}
+
+bool TextureAllocator::IsValid(const HeapAllocation& arg_allocation) const
+{
+	return arg_allocation.IsValid() && arg_allocation.block < blocks_.size() && blocks_[arg_allocation.block].in_use &&
+		blocks_[arg_allocation.block].generation == arg_allocation.generation;
+}
+
+TextureAllocator::Stats TextureAllocator::GetStats() const
+{
+	Stats stats = { };
+	for (const Block& block : blocks_)
+	{
+		if (!block.in_use)
+		{
+			continue;
+		}
+
+		++stats.heap_count;
+		stats.reserved_bytes += block.size;
+
+		if (block.allocator)
+		{
+			BuddyAllocator::FragmentationReport report = block.allocator->GetFragmentationReport();
+			stats.allocation_count += report.allocation_count;
+			stats.free_bytes += report.free_size;
+			stats.internal_fragmentation += report.internal_fragmentation;
+			stats.external_fragmentation = std::max(stats.external_fragmentation, report.external_fragmentation);
+		}
+		else
+		{
+			++stats.allocation_count;
+		}
+	}
+
+	return stats;
+}
+
+ResidencyManager::Handle TextureAllocator::GetResidencyHandle(const HeapAllocation& arg_allocation) const
+{
+	assert(IsValid(arg_allocation) && "Invalid texture allocation.");
+
+	return blocks_[arg_allocation.block].residency_handle;
+}
+
+std::vector<BuddyAllocator::FragmentationReport> TextureAllocator::GetFragmentationReports() const
+{
+	std::vector<BuddyAllocator::FragmentationReport> reports;
+	for (const Block& block : blocks_)
+	{
+		if (block.in_use && block.allocator)
+		{
+			reports.push_back(block.allocator->GetFragmentationReport());
+		}
+	}
+
+	return reports;
+}
+
+uint32_t TextureAllocator::CreateBlock(UINT64 arg_size, bool arg_dedicated)
+{
+	D3D12_HEAP_DESC heap_desc = { };
+	heap_desc.SizeInBytes = (arg_size + D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT - 1) & ~(D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT - 1);
+	heap_desc.Properties.Type = D3D12_HEAP_TYPE_DEFAULT;
+	heap_desc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+	heap_desc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+
+	Block block;
+	block.heap = device_->CreateHeap(heap_desc);
+	block.size = heap_desc.SizeInBytes;
+	block.in_use = true;
+	block.generation = 0;
+	block.residency_handle = residency_manager_ ? residency_manager_->Track(block.heap.Get(), block.size)
+												: ResidencyManager::invalid_handle_;
+	if (gpu_memory_tracker_)
+	{
+		TRACK_GPU_MEMORY(*gpu_memory_tracker_, block.heap.Get(), "TextureAllocatorBlock", block.size);
+	}
+	if (!arg_dedicated)
+	{
+		block.allocator = std::make_unique<BuddyAllocator>(D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT, block_order_);
+	}
+
+	// Reuse the slot of a released dedicated heap.
+	for (uint32_t i = 0; i < blocks_.size(); ++i)
+	{
+		if (!blocks_[i].in_use)
+		{
+			block.generation = blocks_[i].generation;
+			blocks_[i] = std::move(block);
+			return i;
+		}
+	}
+
+	blocks_.push_back(std::move(block));
+	return static_cast<uint32_t>(blocks_.size() - 1);
+}
+
+void TextureAllocator::ReleaseBlock(Block& arg_block)
+{
+	if (residency_manager_)
+	{
+		residency_manager_->Untrack(arg_block.residency_handle);
+	}
+	if (gpu_memory_tracker_)
+	{
+		gpu_memory_tracker_->Unregister(arg_block.heap.Get());
+	}
+	arg_block.heap.Reset();
+	arg_block.allocator.reset();
+	arg_block.in_use = false;
+	++arg_block.generation;
+}
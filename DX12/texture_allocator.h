@@ -0,0 +1,86 @@
+/**
+* The texture allocator places textures in heap blocks that are managed by a buddy
+* allocator. Texture sizes cluster at powers of two, so buddy blocks waste little memory
+* and streaming textures in and out cannot fragment the heaps beyond one block per order.
+* Render target and depth-stencil textures belong in the general HeapAllocator.
+*/
+#pragma once
+
+#include <buddy_allocator.h>
+#include <heap_allocator.h>
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class GpuMemoryTracker;
+
+class TextureAllocator
+{
+public:
+	struct Stats
+	{
+		size_t heap_count;
+		size_t allocation_count;
+		UINT64 reserved_bytes;
+		UINT64 free_bytes;
+		UINT64 internal_fragmentation; // Bytes lost to power-of-two rounding.
+		double external_fragmentation; // Worst external fragmentation of any heap.
+	};
+
+	/**
+	* @param arg_block_order Heap blocks are 64KB << arg_block_order bytes. Textures larger than a
+	* block get a dedicated heap.
+	* @param arg_residency_manager If set, every heap is tracked by it. Must outlive the allocator.
+	* @param arg_gpu_memory_tracker If set, every heap is registered with it. Must outlive the allocator.
+	*/
+	TextureAllocator(std::shared_ptr<HeapAllocatorDevice> arg_device, uint32_t arg_block_order = 10,
+					 ResidencyManager* arg_residency_manager = nullptr, GpuMemoryTracker* arg_gpu_memory_tracker = nullptr);
+	virtual ~TextureAllocator();
+
+	// Create a placed texture. Throws if the device fails to create the heap or the resource; no memory is kept then.
+	HeapAllocation CreateTexture(const D3D12_RESOURCE_DESC& arg_desc, D3D12_RESOURCE_STATES arg_initial_state);
+
+	// Release the texture and return its memory. The GPU must no longer use the texture.
+	void Free(HeapAllocation& arg_allocation);
+
+	// Whether the allocation refers to a texture that is still placed by this allocator.
+	bool IsValid(const HeapAllocation& arg_allocation) const;
+
+	Stats GetStats() const;
+
+	// The residency handle of the heap the texture is placed in, for ResidencyManager::MakeResident.
+	ResidencyManager::Handle GetResidencyHandle(const HeapAllocation& arg_allocation) const;
+
+	// Per-heap buddy reports, for deciding which heaps are worth defragmenting.
+	std::vector<BuddyAllocator::FragmentationReport> GetFragmentationReports() const;
+
+private:
+	struct Block
+	{
+		Microsoft::WRL::ComPtr<ID3D12Heap> heap;
+		UINT64 size;
+		bool in_use;
+		// Incremented when the block is released, so allocations from before its slot was reused are stale.
+		uint32_t generation;
+		// Null for dedicated heaps that hold a single texture.
+		std::unique_ptr<BuddyAllocator> allocator;
+		ResidencyManager::Handle residency_handle;
+	};
+
+	uint32_t CreateBlock(UINT64 arg_size, bool arg_dedicated);
+	// Stop tracking the heap of a block and release it.
+	void ReleaseBlock(Block& arg_block);
+
+	std::shared_ptr<HeapAllocatorDevice> device_;
+	uint32_t block_order_;
+	ResidencyManager* residency_manager_;
+	GpuMemoryTracker* gpu_memory_tracker_;
+
+	// Block indices are stored in allocations, so blocks stay at their index. The slots of released
+	// dedicated heaps are reused for new blocks, with the next generation.
+	std::vector<Block> blocks_;
+};
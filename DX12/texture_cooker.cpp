@@ -0,0 +1,442 @@
+#include <texture_cooker.h>
+#include <helpers.h>
+#include <parallel_for.h>
+
+#include <emmintrin.h>
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	// Rows per chunk of work. Smaller mips are filtered on fewer threads.
+	constexpr uint32_t ROWS_PER_CHUNK = 16;
+
+	// The Kaiser filter covers source texels 2x-2 ... 2x+3 of destination texel x.
+	constexpr uint32_t KAISER_TAP_COUNT = 6;
+	constexpr float KAISER_ALPHA = 4.0f;
+	constexpr float KAISER_RADIUS = 1.5f; // In destination texels.
+
+	constexpr uint32_t SRGB_ENCODE_TABLE_SIZE = 4096;
+
+	float BesselI0(float arg_x)
+	{
+		// Power series, converges quickly for the small arguments of the window.
+		float sum = 1.0f;
+		float term = 1.0f;
+		float half_x_squared = arg_x * arg_x * 0.25f;
+		for (int k = 1; k < 32 && term > sum * 1e-7f; ++k)
+		{
+			term *= half_x_squared / float(k * k);
+			sum += term;
+		}
+		return sum;
+	}
+
+	struct KaiserWeights
+	{
+		__m128 weights[KAISER_TAP_COUNT];
+
+		KaiserWeights()
+		{
+			const float pi = 3.14159265358979f;
+
+			float values[KAISER_TAP_COUNT];
+			float sum = 0.0f;
+			for (uint32_t i = 0; i < KAISER_TAP_COUNT; ++i)
+			{
+				// Distance of the source texel center from the destination texel center, in destination texels.
+				float t = (float(i) - 2.5f) * 0.5f;
+				float sinc = sinf(pi * t) / (pi * t);
+				float ratio = t / KAISER_RADIUS;
+				float window = BesselI0(KAISER_ALPHA * sqrtf(1.0f - ratio * ratio)) / BesselI0(KAISER_ALPHA);
+				values[i] = sinc * window;
+				sum += values[i];
+			}
+			for (uint32_t i = 0; i < KAISER_TAP_COUNT; ++i)
+			{
+				weights[i] = _mm_set1_ps(values[i] / sum);
+			}
+		}
+	};
+
+	struct SrgbTables
+	{
+		float decode[256];
+		uint8_t encode[SRGB_ENCODE_TABLE_SIZE];
+
+		SrgbTables()
+		{
+			for (uint32_t i = 0; i < 256; ++i)
+			{
+				float value = float(i) / 255.0f;
+				decode[i] = value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+			}
+			for (uint32_t i = 0; i < SRGB_ENCODE_TABLE_SIZE; ++i)
+			{
+				float value = float(i) / float(SRGB_ENCODE_TABLE_SIZE - 1);
+				float encoded = value <= 0.0031308f ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+				encode[i] = static_cast<uint8_t>(encoded * 255.0f + 0.5f);
+			}
+		}
+	};
+
+	const KaiserWeights& GetKaiserWeights()
+	{
+		static const KaiserWeights kaiser_weights;
+		return kaiser_weights;
+	}
+
+	const SrgbTables& GetSrgbTables()
+	{
+		static const SrgbTables srgb_tables;
+		return srgb_tables;
+	}
+
+	uint32_t Clamp(int64_t arg_value, uint32_t arg_size)
+	{
+		return arg_value < 0 ? 0 : (arg_value >= arg_size ? arg_size - 1 : static_cast<uint32_t>(arg_value));
+	}
+}
+
+// A float RGBA image, four floats per pixel.
+struct TextureCooker::Image
+{
+	uint32_t width;
+	uint32_t height;
+	std::vector<float> pixels;
+
+	Image(uint32_t arg_width, uint32_t arg_height)
+		: width(arg_width)
+		, height(arg_height)
+		, pixels(size_t(arg_width) * arg_height * 4)
+	{ }
+
+	float* GetRow(uint32_t arg_y) { return pixels.data() + size_t(arg_y) * width * 4; }
+	const float* GetRow(uint32_t arg_y) const { return pixels.data() + size_t(arg_y) * width * 4; }
+};
+
+D3D12_RESOURCE_DESC CookedTexture::GetResourceDesc() const
+{
+	D3D12_RESOURCE_DESC desc = { };
+	desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	desc.Width = width;
+	desc.Height = height;
+	desc.DepthOrArraySize = 1;
+	desc.MipLevels = static_cast<UINT16>(mips.size());
+	desc.Format = format;
+	desc.SampleDesc.Count = 1;
+	desc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+	desc.Flags = D3D12_RESOURCE_FLAG_NONE;
+	return desc;
+}
+
+D3D12_SUBRESOURCE_DATA CookedTexture::GetSubresourceData(uint32_t arg_mip) const
+{
+	assert(arg_mip < mips.size() && "Mip out of range");
+
+	const CookedMip& mip = mips[arg_mip];
+	D3D12_SUBRESOURCE_DATA subresource_data;
+	subresource_data.pData = data.data() + mip.offset;
+	subresource_data.RowPitch = mip.row_pitch;
+	subresource_data.SlicePitch = static_cast<LONG_PTR>(mip.size);
+	return subresource_data;
+}
+
+TextureCooker::TextureCooker(const TextureCookSettings& arg_settings)
+	: settings_(arg_settings)
+{ }
+
+CookedTexture TextureCooker::CookRGBA8(const uint8_t* arg_pixels, uint32_t arg_width, uint32_t arg_height, uint32_t arg_row_pitch) const
+{
+	// Fail before filtering if the texture can not be compressed.
+	if (settings_.compress && (arg_width % 4 != 0 || arg_height % 4 != 0))
+	{
+		ThrowIfFailed(E_INVALIDARG);
+	}
+
+	CookedTexture texture = CreateLayout(DXGI_FORMAT_R8G8B8A8_UNORM, 4, 1, arg_width, arg_height);
+	texture.srgb = settings_.srgb;
+
+	// The first mip is copied as is, so it does not lose precision in a round trip through float.
+	const CookedMip& first_mip = texture.mips[0];
+	for (uint32_t y = 0; y < arg_height; ++y)
+	{
+		memcpy(texture.data.data() + first_mip.offset + size_t(y) * first_mip.row_pitch, arg_pixels + size_t(y) * arg_row_pitch, first_mip.row_pitch);
+	}
+
+	if (texture.mips.size() > 1)
+	{
+		Image image(arg_width, arg_height);
+		ParallelFor(arg_height, ROWS_PER_CHUNK, [&](uint32_t arg_begin, uint32_t arg_end)
+		{
+			const float* decode_table = GetSrgbTables().decode;
+			const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+			const __m128i zero = _mm_setzero_si128();
+
+			for (uint32_t y = arg_begin; y < arg_end; ++y)
+			{
+				const uint8_t* source = arg_pixels + size_t(y) * arg_row_pitch;
+				float* destination = image.GetRow(y);
+				for (uint32_t x = 0; x < arg_width; ++x, source += 4, destination += 4)
+				{
+					int32_t packed;
+					memcpy(&packed, source, sizeof(packed));
+					__m128i value = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+					_mm_storeu_ps(destination, _mm_mul_ps(_mm_cvtepi32_ps(value), scale));
+
+					if (settings_.srgb)
+					{
+						destination[0] = decode_table[source[0]];
+						destination[1] = decode_table[source[1]];
+						destination[2] = decode_table[source[2]];
+					}
+				}
+			}
+		}, settings_.thread_count);
+
+		GenerateMips(image, texture);
+	}
+
+	return settings_.compress ? Compress(texture) : texture;
+}
+
+CookedTexture TextureCooker::CookFloat(const float* arg_pixels, uint32_t arg_width, uint32_t arg_height, uint32_t arg_row_pitch) const
+{
+	assert(!settings_.srgb && "Float textures are linear");
+
+	// None of the BC formats the compressor encodes hold float data.
+	if (settings_.compress)
+	{
+		ThrowIfFailed(E_INVALIDARG);
+	}
+
+	CookedTexture texture = CreateLayout(DXGI_FORMAT_R32G32B32A32_FLOAT, 16, 1, arg_width, arg_height);
+
+	Image image(arg_width, arg_height);
+	const uint8_t* source = reinterpret_cast<const uint8_t*>(arg_pixels);
+	for (uint32_t y = 0; y < arg_height; ++y)
+	{
+		memcpy(image.GetRow(y), source + size_t(y) * arg_row_pitch, size_t(arg_width) * 16);
+	}
+	memcpy(texture.data.data() + texture.mips[0].offset, image.pixels.data(), texture.mips[0].size);
+
+	GenerateMips(image, texture);
+
+	return texture;
+}
+
+uint32_t TextureCooker::GetFullMipCount(uint32_t arg_width, uint32_t arg_height)
+{
+	uint32_t size = arg_width > arg_height ? arg_width : arg_height;
+	uint32_t mip_count = 1;
+	while (size > 1)
+	{
+		size >>= 1;
+		++mip_count;
+	}
+	return mip_count;
+}
+
+const TextureCookSettings& TextureCooker::GetSettings() const
+{
+	return settings_;
+}
+
+CookedTexture TextureCooker::CreateLayout(DXGI_FORMAT arg_format, uint32_t arg_block_size, uint32_t arg_block_dimension,
+										   uint32_t arg_width, uint32_t arg_height) const
+{
+	// Smaller mips of block compressed textures are padded to whole blocks, but the first one can not be.
+	if (arg_width == 0 || arg_height == 0 || arg_width % arg_block_dimension != 0 || arg_height % arg_block_dimension != 0)
+	{
+		ThrowIfFailed(E_INVALIDARG);
+	}
+
+	uint32_t mip_count = GetFullMipCount(arg_width, arg_height);
+	if (settings_.mip_count != 0 && settings_.mip_count < mip_count)
+	{
+		mip_count = settings_.mip_count;
+	}
+
+	CookedTexture texture;
+	texture.format = arg_format;
+	texture.width = arg_width;
+	texture.height = arg_height;
+	texture.mips.resize(mip_count);
+
+	// Mips are stored one after another with tightly packed rows.
+	uint64_t offset = 0;
+	uint32_t width = arg_width;
+	uint32_t height = arg_height;
+	for (CookedMip& mip : texture.mips)
+	{
+		mip.offset = offset;
+		mip.width = width;
+		mip.height = height;
+		mip.row_pitch = (width + arg_block_dimension - 1) / arg_block_dimension * arg_block_size;
+		mip.row_count = (height + arg_block_dimension - 1) / arg_block_dimension;
+		mip.size = uint64_t(mip.row_pitch) * mip.row_count;
+		offset += mip.size;
+
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+	texture.data.resize(static_cast<size_t>(offset));
+
+	return texture;
+}
+
+void TextureCooker::GenerateMips(Image& arg_image, CookedTexture& arg_texture) const
+{
+	// Each mip is filtered from the previous one.
+	for (uint32_t mip = 1; mip < arg_texture.mips.size(); ++mip)
+	{
+		arg_image = Downsample(arg_image);
+		assert(arg_image.width == arg_texture.mips[mip].width && arg_image.height == arg_texture.mips[mip].height && "Unexpected mip size");
+		Encode(arg_image, arg_texture, mip);
+	}
+}
+
+CookedTexture TextureCooker::Compress(const CookedTexture& arg_texture) const
+{
+	assert(arg_texture.format == DXGI_FORMAT_R8G8B8A8_UNORM && "Only RGBA8 textures can be compressed");
+
+	BlockCompressor compressor(settings_.block_format, settings_.compression_quality, settings_.thread_count);
+	CookedTexture texture = CreateLayout(compressor.GetFormat(), compressor.GetBlockSize(), 4, arg_texture.width, arg_texture.height);
+	texture.srgb = arg_texture.srgb;
+
+	for (uint32_t mip = 0; mip < texture.mips.size(); ++mip)
+	{
+		const CookedMip& source_mip = arg_texture.mips[mip];
+		compressor.Compress(arg_texture.data.data() + source_mip.offset, source_mip.width, source_mip.height, source_mip.row_pitch,
+							texture.data.data() + texture.mips[mip].offset, texture.mips[mip].row_pitch);
+	}
+
+	return texture;
+}
+
+TextureCooker::Image TextureCooker::Downsample(const Image& arg_source) const
+{
+	Image destination(arg_source.width > 1 ? arg_source.width / 2 : 1, arg_source.height > 1 ? arg_source.height / 2 : 1);
+
+	if (settings_.filter == MipFilter::Box)
+	{
+		ParallelFor(destination.height, ROWS_PER_CHUNK, [&](uint32_t arg_begin, uint32_t arg_end)
+		{
+			const __m128 quarter = _mm_set1_ps(0.25f);
+			for (uint32_t y = arg_begin; y < arg_end; ++y)
+			{
+				const float* row0 = arg_source.GetRow(Clamp(int64_t(y) * 2, arg_source.height));
+				const float* row1 = arg_source.GetRow(Clamp(int64_t(y) * 2 + 1, arg_source.height));
+				float* destination_row = destination.GetRow(y);
+				for (uint32_t x = 0; x < destination.width; ++x)
+				{
+					size_t x0 = size_t(Clamp(int64_t(x) * 2, arg_source.width)) * 4;
+					size_t x1 = size_t(Clamp(int64_t(x) * 2 + 1, arg_source.width)) * 4;
+					__m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(row0 + x0), _mm_loadu_ps(row0 + x1)),
+											_mm_add_ps(_mm_loadu_ps(row1 + x0), _mm_loadu_ps(row1 + x1)));
+					_mm_storeu_ps(destination_row + size_t(x) * 4, _mm_mul_ps(sum, quarter));
+				}
+			}
+		}, settings_.thread_count);
+
+		return destination;
+	}
+
+	// The Kaiser filter is separable: filter the rows into an image of the destination width, then the columns.
+	const KaiserWeights& kaiser = GetKaiserWeights();
+	Image horizontal(destination.width, arg_source.height);
+
+	ParallelFor(horizontal.height, ROWS_PER_CHUNK, [&](uint32_t arg_begin, uint32_t arg_end)
+	{
+		for (uint32_t y = arg_begin; y < arg_end; ++y)
+		{
+			const float* source_row = arg_source.GetRow(y);
+			float* destination_row = horizontal.GetRow(y);
+			for (uint32_t x = 0; x < horizontal.width; ++x)
+			{
+				__m128 sum = _mm_setzero_ps();
+				for (uint32_t tap = 0; tap < KAISER_TAP_COUNT; ++tap)
+				{
+					size_t source_x = size_t(Clamp(int64_t(x) * 2 - 2 + tap, arg_source.width)) * 4;
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(source_row + source_x), kaiser.weights[tap]));
+				}
+				_mm_storeu_ps(destination_row + size_t(x) * 4, sum);
+			}
+		}
+	}, settings_.thread_count);
+
+	ParallelFor(destination.height, ROWS_PER_CHUNK, [&](uint32_t arg_begin, uint32_t arg_end)
+	{
+		const float* source_rows[KAISER_TAP_COUNT];
+		for (uint32_t y = arg_begin; y < arg_end; ++y)
+		{
+			for (uint32_t tap = 0; tap < KAISER_TAP_COUNT; ++tap)
+			{
+				source_rows[tap] = horizontal.GetRow(Clamp(int64_t(y) * 2 - 2 + tap, horizontal.height));
+			}
+
+			float* destination_row = destination.GetRow(y);
+			for (size_t i = 0; i < size_t(destination.width) * 4; i += 4)
+			{
+				__m128 sum = _mm_setzero_ps();
+				for (uint32_t tap = 0; tap < KAISER_TAP_COUNT; ++tap)
+				{
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(source_rows[tap] + i), kaiser.weights[tap]));
+				}
+				_mm_storeu_ps(destination_row + i, sum);
+			}
+		}
+	}, settings_.thread_count);
+
+	return destination;
+}
+
+void TextureCooker::Encode(const Image& arg_image, CookedTexture& arg_texture, uint32_t arg_mip) const
+{
+	const CookedMip& mip = arg_texture.mips[arg_mip];
+	uint8_t* mip_data = arg_texture.data.data() + mip.offset;
+
+	if (arg_texture.format == DXGI_FORMAT_R32G32B32A32_FLOAT)
+	{
+		memcpy(mip_data, arg_image.pixels.data(), static_cast<size_t>(mip.size));
+		return;
+	}
+
+	assert(arg_texture.format == DXGI_FORMAT_R8G8B8A8_UNORM && "Unexpected cooked format");
+
+	ParallelFor(mip.height, ROWS_PER_CHUNK, [&](uint32_t arg_begin, uint32_t arg_end)
+	{
+		const uint8_t* encode_table = GetSrgbTables().encode;
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 unorm_scale = _mm_set1_ps(255.0f);
+		const __m128 srgb_scale = _mm_set1_ps(float(SRGB_ENCODE_TABLE_SIZE - 1));
+
+		for (uint32_t y = arg_begin; y < arg_end; ++y)
+		{
+			const float* source = arg_image.GetRow(y);
+			uint8_t* destination = mip_data + size_t(y) * mip.row_pitch;
+			for (uint32_t x = 0; x < mip.width; ++x, source += 4, destination += 4)
+			{
+				// Sharpening filters overshoot, so clamp before quantizing.
+				__m128 value = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(source), zero), one);
+
+				__m128i quantized = _mm_cvtps_epi32(_mm_mul_ps(value, unorm_scale));
+				__m128i packed = _mm_packus_epi16(_mm_packs_epi32(quantized, quantized), quantized);
+				int32_t pixel = _mm_cvtsi128_si32(packed);
+				memcpy(destination, &pixel, sizeof(pixel));
+
+				if (arg_texture.srgb)
+				{
+					alignas(16) int32_t indices[4];
+					_mm_store_si128(reinterpret_cast<__m128i*>(indices), _mm_cvtps_epi32(_mm_mul_ps(value, srgb_scale)));
+					destination[0] = encode_table[indices[0]];
+					destination[1] = encode_table[indices[1]];
+					destination[2] = encode_table[indices[2]];
+				}
+			}
+		}
+	}, settings_.thread_count);
+}
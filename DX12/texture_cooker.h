@@ -0,0 +1,98 @@
+/**
+* The texture cooker turns decoded images into textures with a full mip chain. Mips are
+* filtered in float with SSE2 kernels, each level split by rows over several threads,
+* and stored in a cooked texture: one block of data with the offset of every mip. RGBA8
+* mips can be block compressed on the way out.
+*/
+#pragma once
+
+#include <block_compressor.h>
+
+#include <d3d12.h>
+
+#include <cstdint>
+#include <vector>
+
+enum class MipFilter
+{
+	Box,	// 2x2 average. Fast, but blurs and aliases more.
+	Kaiser	// Kaiser-windowed sinc. Keeps the mips sharp.
+};
+
+struct TextureCookSettings
+{
+	MipFilter filter = MipFilter::Kaiser;
+	// The RGBA8 color channels are sRGB encoded. They are decoded before filtering and encoded again after.
+	bool srgb = false;
+	// The number of mips to generate, or 0 for the full chain.
+	uint32_t mip_count = 0;
+	// The number of threads, or 0 for the number of hardware threads.
+	uint32_t thread_count = 0;
+
+	// Compress RGBA8 textures into a BC format. Their width and height must be multiples of 4.
+	bool compress = false;
+	BlockFormat block_format = BlockFormat::BC7;
+	CompressionQuality compression_quality = CompressionQuality::Normal;
+};
+
+// A mip of a cooked texture. The offset is from the start of the texture data. Rows are rows of blocks in BC formats.
+struct CookedMip
+{
+	uint64_t offset;
+	uint64_t size;
+	uint32_t width;
+	uint32_t height;
+	uint32_t row_pitch;
+	uint32_t row_count;
+};
+
+struct CookedTexture
+{
+	DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+	// Whether the color channels are sRGB encoded. The format is not an _SRGB format, so views choose how to read it.
+	bool srgb = false;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	std::vector<CookedMip> mips;
+	std::vector<uint8_t> data;
+
+	D3D12_RESOURCE_DESC GetResourceDesc() const;
+	D3D12_SUBRESOURCE_DATA GetSubresourceData(uint32_t arg_mip) const;
+};
+
+class TextureCooker
+{
+public:
+	TextureCooker(const TextureCookSettings& arg_settings = TextureCookSettings());
+
+	/**
+	* Cook 8-bit RGBA pixels into a DXGI_FORMAT_R8G8B8A8_UNORM texture, or the BC format of the settings.
+	* The first mip is the image itself.
+	*/
+	CookedTexture CookRGBA8(const uint8_t* arg_pixels, uint32_t arg_width, uint32_t arg_height, uint32_t arg_row_pitch) const;
+
+	// Cook linear float RGBA pixels into a DXGI_FORMAT_R32G32B32A32_FLOAT texture. The row pitch is in bytes.
+	CookedTexture CookFloat(const float* arg_pixels, uint32_t arg_width, uint32_t arg_height, uint32_t arg_row_pitch) const;
+
+	// The number of mips down to 1x1.
+	static uint32_t GetFullMipCount(uint32_t arg_width, uint32_t arg_height);
+
+	const TextureCookSettings& GetSettings() const;
+
+private:
+	struct Image;
+
+	/**
+	* @param arg_block_size The size of a pixel, or of a block in BC formats.
+	* @param arg_block_dimension The width and height of a block, 1 for uncompressed formats.
+	*/
+	CookedTexture CreateLayout(DXGI_FORMAT arg_format, uint32_t arg_block_size, uint32_t arg_block_dimension,
+							   uint32_t arg_width, uint32_t arg_height) const;
+	void GenerateMips(Image& arg_image, CookedTexture& arg_texture) const;
+	CookedTexture Compress(const CookedTexture& arg_texture) const;
+
+	Image Downsample(const Image& arg_source) const;
+	void Encode(const Image& arg_image, CookedTexture& arg_texture, uint32_t arg_mip) const;
+
+	TextureCookSettings settings_;
+};
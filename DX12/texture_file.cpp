@@ -0,0 +1,213 @@
+#include <texture_file.h>
+#include <texture_cooker.h>
+#include <helpers.h>
+
+#include <cassert>
+#include <fstream>
+#include <vector>
+
+TextureFile::TextureFile(const std::wstring& arg_path)
+	: file_(arg_path)
+	, header_(nullptr)
+	, subresources_(nullptr)
+{
+	const uint8_t* data = file_.GetData();
+	uint64_t size = file_.GetSize();
+	if (size < sizeof(FileHeader))
+	{
+		ThrowIfFailed(E_FAIL);
+	}
+
+	// Check the subresource table once, so the accessors can trust it.
+	header_ = reinterpret_cast<const FileHeader*>(data);
+	subresources_ = reinterpret_cast<const Subresource*>(data + sizeof(FileHeader));
+
+	if (!IsValidHeader(*header_, size))
+	{
+		ThrowIfFailed(E_FAIL);
+	}
+	for (uint32_t i = 0; i < GetSubresourceCount(); ++i)
+	{
+		if (!IsValidSubresource(subresources_[i], size))
+		{
+			ThrowIfFailed(E_FAIL);
+		}
+	}
+}
+
+TextureFile::~TextureFile()
+{ }
+
+bool TextureFile::Write(const std::wstring& arg_path, const CookedTexture* arg_slices, uint32_t arg_slice_count)
+{
+	assert(arg_slice_count > 0 && "A texture needs at least one slice");
+
+	const CookedTexture& first_slice = arg_slices[0];
+	for (uint32_t slice = 1; slice < arg_slice_count; ++slice)
+	{
+		assert(arg_slices[slice].format == first_slice.format && arg_slices[slice].width == first_slice.width &&
+			   arg_slices[slice].height == first_slice.height && arg_slices[slice].mips.size() == first_slice.mips.size() &&
+			   "The slices of a texture must have the same layout");
+	}
+
+	FileHeader header = { };
+	header.magic = file_magic_;
+	header.format_version = format_version_;
+	header.format = first_slice.format;
+	header.flags = first_slice.srgb ? srgb_flag_ : 0;
+	header.width = first_slice.width;
+	header.height = first_slice.height;
+	header.array_size = arg_slice_count;
+	header.mip_count = static_cast<uint32_t>(first_slice.mips.size());
+
+	// Lay out the subresources after the table, each on its own page, with the rows at the upload pitch.
+	std::vector<Subresource> subresources(size_t(arg_slice_count) * header.mip_count);
+	uint64_t offset = sizeof(FileHeader) + sizeof(Subresource) * subresources.size();
+	for (uint32_t slice = 0; slice < arg_slice_count; ++slice)
+	{
+		for (uint32_t mip = 0; mip < header.mip_count; ++mip)
+		{
+			const CookedMip& cooked_mip = arg_slices[slice].mips[mip];
+			Subresource& subresource = subresources[size_t(slice) * header.mip_count + mip];
+
+			offset = (offset + data_alignment_ - 1) & ~(data_alignment_ - 1);
+			subresource.offset = offset;
+			subresource.row_size = cooked_mip.row_pitch;
+			subresource.row_pitch = (cooked_mip.row_pitch + D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1) & ~(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1);
+			subresource.row_count = cooked_mip.row_count;
+			subresource.size = uint64_t(subresource.row_pitch) * subresource.row_count;
+			subresource.reserved = 0;
+			offset += subresource.size;
+		}
+	}
+
+	// Write next to the file and replace it once complete, so a failed write does not leave a truncated file behind.
+	const std::wstring temp_path = arg_path + L".tmp";
+	std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		return false;
+	}
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(subresources.data()), sizeof(Subresource) * subresources.size());
+
+	static const char padding[data_alignment_] = { };
+	for (uint32_t slice = 0; slice < arg_slice_count; ++slice)
+	{
+		for (uint32_t mip = 0; mip < header.mip_count; ++mip)
+		{
+			const CookedMip& cooked_mip = arg_slices[slice].mips[mip];
+			const Subresource& subresource = subresources[size_t(slice) * header.mip_count + mip];
+
+			uint64_t position = static_cast<uint64_t>(file.tellp());
+			file.write(padding, static_cast<std::streamsize>(subresource.offset - position));
+
+			const uint8_t* row = arg_slices[slice].data.data() + cooked_mip.offset;
+			for (uint32_t y = 0; y < subresource.row_count; ++y, row += cooked_mip.row_pitch)
+			{
+				file.write(reinterpret_cast<const char*>(row), subresource.row_size);
+				file.write(padding, subresource.row_pitch - subresource.row_size);
+			}
+		}
+	}
+
+	file.close();
+	if (file.fail() || !MoveFileExW(temp_path.c_str(), arg_path.c_str(), MOVEFILE_REPLACE_EXISTING))
+	{
+		DeleteFileW(temp_path.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+bool TextureFile::IsOutOfDate(const std::wstring& arg_path, const std::wstring& arg_source_path)
+{
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesExW(arg_path.c_str(), GetFileExInfoStandard, &attributes))
+	{
+		return true;
+	}
+
+	// A file of another format version, or one that is damaged, is cooked again rather than failing to load.
+	std::ifstream file(arg_path, std::ios::binary);
+	const uint64_t size = (uint64_t(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+	FileHeader header;
+	if (size < sizeof(header) || !file.read(reinterpret_cast<char*>(&header), sizeof(header)) || !IsValidHeader(header, size))
+	{
+		return true;
+	}
+
+	std::vector<Subresource> subresources(size_t(header.array_size) * header.mip_count);
+	if (!file.read(reinterpret_cast<char*>(subresources.data()), sizeof(Subresource) * subresources.size()))
+	{
+		return true;
+	}
+	for (const Subresource& subresource : subresources)
+	{
+		if (!IsValidSubresource(subresource, size))
+		{
+			return true;
+		}
+	}
+
+	// Without the source, the cooked file is all there is.
+	WIN32_FILE_ATTRIBUTE_DATA source_attributes;
+	if (!GetFileAttributesExW(arg_source_path.c_str(), GetFileExInfoStandard, &source_attributes))
+	{
+		return false;
+	}
+
+	return CompareFileTime(&source_attributes.ftLastWriteTime, &attributes.ftLastWriteTime) > 0;
+}
+
+bool TextureFile::IsValidHeader(const FileHeader& arg_header, uint64_t arg_file_size)
+{
+	return arg_header.magic == file_magic_ && arg_header.format_version == format_version_ &&
+		arg_header.array_size != 0 && arg_header.mip_count != 0 && arg_header.array_size <= 0xFFFF && arg_header.mip_count <= 0xFFFF &&
+		(arg_file_size - sizeof(FileHeader)) / sizeof(Subresource) >= uint64_t(arg_header.array_size) * arg_header.mip_count;
+}
+
+bool TextureFile::IsValidSubresource(const Subresource& arg_subresource, uint64_t arg_file_size)
+{
+	return arg_subresource.offset <= arg_file_size && arg_subresource.size <= arg_file_size - arg_subresource.offset &&
+		arg_subresource.row_size <= arg_subresource.row_pitch && uint64_t(arg_subresource.row_pitch) * arg_subresource.row_count <= arg_subresource.size;
+}
+
+D3D12_RESOURCE_DESC TextureFile::GetResourceDesc() const
+{
+	D3D12_RESOURCE_DESC desc = { };
+	desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	desc.Width = header_->width;
+	desc.Height = header_->height;
+	desc.DepthOrArraySize = static_cast<UINT16>(header_->array_size);
+	desc.MipLevels = static_cast<UINT16>(header_->mip_count);
+	desc.Format = static_cast<DXGI_FORMAT>(header_->format);
+	desc.SampleDesc.Count = 1;
+	desc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+	desc.Flags = D3D12_RESOURCE_FLAG_NONE;
+	return desc;
+}
+
+bool TextureFile::IsSrgb() const
+{
+	return (header_->flags & srgb_flag_) != 0;
+}
+
+uint32_t TextureFile::GetSubresourceCount() const
+{
+	return header_->array_size * header_->mip_count;
+}
+
+D3D12_SUBRESOURCE_DATA TextureFile::GetSubresourceData(uint32_t arg_subresource) const
+{
+	assert(arg_subresource < GetSubresourceCount() && "Subresource out of range");
+
+	const Subresource& subresource = subresources_[arg_subresource];
+	D3D12_SUBRESOURCE_DATA subresource_data;
+	subresource_data.pData = file_.GetData() + subresource.offset;
+	subresource_data.RowPitch = subresource.row_pitch;
+	subresource_data.SlicePitch = static_cast<LONG_PTR>(subresource.size);
+	return subresource_data;
+}
@@ -0,0 +1,84 @@
+/**
+* The texture file stores cooked textures ready for upload. A header with the format and
+* size is followed by the offset of every subresource. Each subresource starts on its own
+* page, and its rows are padded to the pitch GetCopyableFootprints uses, so the file is
+* mapped and uploaded with one copy per subresource, without decoding.
+*/
+#pragma once
+
+#include <mapped_file.h>
+
+#include <d3d12.h>
+
+#include <cstdint>
+#include <string>
+
+struct CookedTexture;
+
+class TextureFile
+{
+public:
+	static const uint32_t format_version_ = 1;
+	// Subresources start on a page, so they can be read or mapped independently.
+	static const uint64_t data_alignment_ = 4096;
+
+	// Map a texture file. Throws if it can not be opened or is not a valid texture file.
+	TextureFile(const std::wstring& arg_path);
+	virtual ~TextureFile();
+
+	/**
+	* Write the slices of a texture array. All slices must have the same format, size and mips.
+	* An existing file is only replaced once the new one is complete.
+	* @returns False if the file could not be written.
+	*/
+	static bool Write(const std::wstring& arg_path, const CookedTexture* arg_slices, uint32_t arg_slice_count);
+
+	// Whether the cooked file is missing, not a valid texture file of this format version, or older than the source it is cooked from.
+	static bool IsOutOfDate(const std::wstring& arg_path, const std::wstring& arg_source_path);
+
+	D3D12_RESOURCE_DESC GetResourceDesc() const;
+
+	// Whether the color channels are sRGB encoded.
+	bool IsSrgb() const;
+
+	// Subresources are ordered like D3D12 subresources: the mips of the first slice, then of the next.
+	uint32_t GetSubresourceCount() const;
+
+	// The data of a subresource. It points into the mapping and is valid as long as the file is.
+	D3D12_SUBRESOURCE_DATA GetSubresourceData(uint32_t arg_subresource) const;
+
+private:
+	struct FileHeader
+	{
+		uint32_t magic;
+		uint32_t format_version;
+		uint32_t format;
+		uint32_t flags;
+		uint32_t width;
+		uint32_t height;
+		uint32_t array_size;
+		uint32_t mip_count;
+	};
+
+	// Offsets are from the start of the file. Rows are rows of blocks in BC formats.
+	struct Subresource
+	{
+		uint64_t offset;
+		uint64_t size;
+		uint32_t row_pitch;
+		uint32_t row_count;
+		uint32_t row_size;
+		uint32_t reserved;
+	};
+
+	static const uint32_t file_magic_ = 0x43584554; // "TEXC"
+	static const uint32_t srgb_flag_ = 0x1;
+
+	// Whether a header and the subresource table it is followed by fit in a file of the given size.
+	static bool IsValidHeader(const FileHeader& arg_header, uint64_t arg_file_size);
+	static bool IsValidSubresource(const Subresource& arg_subresource, uint64_t arg_file_size);
+
+	MappedFile file_;
+	const FileHeader* header_;
+	const Subresource* subresources_;
+};
@@ -0,0 +1,340 @@
+#include <tlsf_allocator.h>
+
+#include <algorithm>
+#include <cassert>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Index of the most significant set bit. The value must not be 0.
+static uint32_t FindLastSet(uint64_t arg_value)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanReverse64(&index, arg_value);
+	return index;
+#else
+	return 63 - __builtin_clzll(arg_value);
+#endif
+}
+
+// Index of the least significant set bit. The value must not be 0.
+static uint32_t FindFirstSet(uint64_t arg_value)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward64(&index, arg_value);
+	return index;
+#else
+	return __builtin_ctzll(arg_value);
+#endif
+}
+
+static uint64_t AlignUp(uint64_t arg_value, uint64_t arg_alignment)
+{
+	return (arg_value + arg_alignment - 1) & ~(arg_alignment - 1);
+}
+
+TlsfAllocator::TlsfAllocator(uint64_t arg_size, uint64_t arg_min_alignment)
+	: size_(arg_size & ~(arg_min_alignment - 1))
+	, min_alignment_(arg_min_alignment)
+	, free_size_(0)
+	, fl_bitmap_(0)
+	, sl_bitmap_()
+{
+	assert(arg_min_alignment > 0 && (arg_min_alignment & (arg_min_alignment - 1)) == 0 && "Alignment must be a power of two.");
+
+	for (uint32_t fl = 0; fl < fl_count_; ++fl)
+	{
+		for (uint32_t sl = 0; sl < sl_count_; ++sl)
+		{
+			free_lists_[fl][sl] = null_block_;
+		}
+	}
+
+	if (size_ > 0)
+	{
+		InsertFreeBlock(CreateBlock(0, size_));
+	}
+}
+
+uint64_t TlsfAllocator::Allocate(uint64_t arg_size, uint64_t arg_alignment)
+{
+	assert(arg_alignment > 0 && (arg_alignment & (arg_alignment - 1)) == 0 && "Alignment must be a power of two.");
+
+	uint64_t size = AlignUp(std::max<uint64_t>(arg_size, 1), min_alignment_);
+	uint64_t alignment = std::max(arg_alignment, min_alignment_);
+
+	// Every block offset is a multiple of the minimum alignment, so a block that is
+	// larger by (alignment - min_alignment) always fits the aligned range.
+	uint64_t search_size = size + (alignment - min_alignment_);
+	if (search_size > free_size_)
+	{
+		return invalid_offset_;
+	}
+
+	// Round the size up to the next list so that every block in the found list fits.
+	uint64_t units = search_size / min_alignment_;
+	if (units >= sl_count_)
+	{
+		units += (1ull << (FindLastSet(units) - sl_bits_)) - 1;
+	}
+
+	uint32_t fl, sl;
+	Mapping(units, fl, sl);
+	if (!FindSuitableList(fl, sl))
+	{
+		return invalid_offset_;
+	}
+
+	uint32_t block = free_lists_[fl][sl];
+	RemoveFreeBlock(block);
+
+	// Return leading padding to the free lists.
+	uint64_t aligned_offset = AlignUp(blocks_[block].offset, alignment);
+	if (aligned_offset != blocks_[block].offset)
+	{
+		uint64_t padding = aligned_offset - blocks_[block].offset;
+		SplitBlock(block, padding);
+
+		uint32_t padding_block = block;
+		block = blocks_[padding_block].next_physical;
+		RemoveFreeBlock(block);
+		InsertFreeBlock(padding_block);
+	}
+
+	if (blocks_[block].size > size)
+	{
+		SplitBlock(block, size);
+	}
+
+	blocks_[block].free = false;
+	allocations_[blocks_[block].offset] = block;
+
+	return blocks_[block].offset;
+}
+
+void TlsfAllocator::Free(uint64_t arg_offset)
+{
+	auto iter = allocations_.find(arg_offset);
+	assert(iter != allocations_.end() && "Offset was not allocated by this allocator.");
+	if (iter == allocations_.end())
+	{
+		return;
+	}
+
+	uint32_t block = iter->second;
+	allocations_.erase(iter);
+
+	blocks_[block].free = true;
+
+	uint32_t prev = blocks_[block].prev_physical;
+	if (prev != null_block_ && blocks_[prev].free)
+	{
+		RemoveFreeBlock(prev);
+		block = MergeWithPrevious(block);
+	}
+
+	uint32_t next = blocks_[block].next_physical;
+	if (next != null_block_ && blocks_[next].free)
+	{
+		RemoveFreeBlock(next);
+		block = MergeWithPrevious(next);
+	}
+
+	InsertFreeBlock(block);
+}
+
+uint64_t TlsfAllocator::GetSize() const
+{
+	return size_;
+}
+
+uint64_t TlsfAllocator::GetFreeSize() const
+{
+	return free_size_;
+}
+
+uint64_t TlsfAllocator::GetLargestFreeBlock() const
+{
+	if (fl_bitmap_ == 0)
+	{
+		return 0;
+	}
+
+	// The largest block is in the highest non-empty list.
+	uint32_t fl = FindLastSet(fl_bitmap_);
+	uint32_t sl = FindLastSet(sl_bitmap_[fl]);
+
+	uint64_t largest = 0;
+	for (uint32_t block = free_lists_[fl][sl]; block != null_block_; block = blocks_[block].next_free)
+	{
+		largest = std::max(largest, blocks_[block].size);
+	}
+
+	return largest;
+}
+
+size_t TlsfAllocator::GetAllocationCount() const
+{
+	return allocations_.size();
+}
+
+double TlsfAllocator::GetFragmentation() const
+{
+	if (free_size_ == 0)
+	{
+		return 0.0;
+	}
+
+	return 1.0 - static_cast<double>(GetLargestFreeBlock()) / static_cast<double>(free_size_);
+}
+
+void TlsfAllocator::Mapping(uint64_t arg_units, uint32_t& arg_fl, uint32_t& arg_sl)
+{
+	if (arg_units < sl_count_)
+	{
+		arg_fl = 0;
+		arg_sl = static_cast<uint32_t>(arg_units);
+	}
+	else
+	{
+		uint32_t last_set = FindLastSet(arg_units);
+		arg_sl = static_cast<uint32_t>(arg_units >> (last_set - sl_bits_)) ^ sl_count_;
+		arg_fl = last_set - sl_bits_ + 1;
+	}
+}
+
+bool TlsfAllocator::FindSuitableList(uint32_t& arg_fl, uint32_t& arg_sl) const
+{
+	uint32_t sl_map = sl_bitmap_[arg_fl] & (~0u << arg_sl);
+	if (sl_map == 0)
+	{
+		uint64_t fl_map = arg_fl + 1 < fl_count_ ? fl_bitmap_ & (~0ull << (arg_fl + 1)) : 0;
+		if (fl_map == 0)
+		{
+			return false;
+		}
+
+		arg_fl = FindFirstSet(fl_map);
+		sl_map = sl_bitmap_[arg_fl];
+	}
+
+	arg_sl = FindFirstSet(sl_map);
+	return true;
+}
+
+void TlsfAllocator::InsertFreeBlock(uint32_t arg_block)
+{
+	Block& block = blocks_[arg_block];
+
+	uint32_t fl, sl;
+	Mapping(block.size / min_alignment_, fl, sl);
+
+	block.free = true;
+	block.prev_free = null_block_;
+	block.next_free = free_lists_[fl][sl];
+	if (block.next_free != null_block_)
+	{
+		blocks_[block.next_free].prev_free = arg_block;
+	}
+	free_lists_[fl][sl] = arg_block;
+
+	fl_bitmap_ |= 1ull << fl;
+	sl_bitmap_[fl] |= 1u << sl;
+	free_size_ += block.size;
+}
+
+void TlsfAllocator::RemoveFreeBlock(uint32_t arg_block)
+{
+	Block& block = blocks_[arg_block];
+
+	uint32_t fl, sl;
+	Mapping(block.size / min_alignment_, fl, sl);
+
+	if (block.prev_free != null_block_)
+	{
+		blocks_[block.prev_free].next_free = block.next_free;
+	}
+	else
+	{
+		free_lists_[fl][sl] = block.next_free;
+	}
+	if (block.next_free != null_block_)
+	{
+		blocks_[block.next_free].prev_free = block.prev_free;
+	}
+
+	if (free_lists_[fl][sl] == null_block_)
+	{
+		sl_bitmap_[fl] &= ~(1u << sl);
+		if (sl_bitmap_[fl] == 0)
+		{
+			fl_bitmap_ &= ~(1ull << fl);
+		}
+	}
+
+	block.prev_free = null_block_;
+	block.next_free = null_block_;
+	free_size_ -= block.size;
+}
+
+void TlsfAllocator::SplitBlock(uint32_t arg_block, uint64_t arg_size)
+{
+	uint32_t remainder = CreateBlock(blocks_[arg_block].offset + arg_size, blocks_[arg_block].size - arg_size);
+
+	// CreateBlock can reallocate the block array, so only take references afterwards.
+	Block& block = blocks_[arg_block];
+	block.size = arg_size;
+
+	blocks_[remainder].prev_physical = arg_block;
+	blocks_[remainder].next_physical = block.next_physical;
+	if (block.next_physical != null_block_)
+	{
+		blocks_[block.next_physical].prev_physical = remainder;
+	}
+	block.next_physical = remainder;
+
+	InsertFreeBlock(remainder);
+}
+
+uint32_t TlsfAllocator::MergeWithPrevious(uint32_t arg_block)
+{
+	uint32_t prev = blocks_[arg_block].prev_physical;
+
+	blocks_[prev].size += blocks_[arg_block].size;
+	blocks_[prev].next_physical = blocks_[arg_block].next_physical;
+	if (blocks_[arg_block].next_physical != null_block_)
+	{
+		blocks_[blocks_[arg_block].next_physical].prev_physical = prev;
+	}
+
+	DestroyBlock(arg_block);
+
+	return prev;
+}
+
+uint32_t TlsfAllocator::CreateBlock(uint64_t arg_offset, uint64_t arg_size)
+{
+	uint32_t index;
+	if (!unused_blocks_.empty())
+	{
+		index = unused_blocks_.back();
+		unused_blocks_.pop_back();
+	}
+	else
+	{
+		index = static_cast<uint32_t>(blocks_.size());
+		blocks_.emplace_back();
+	}
+
+	blocks_[index] = Block{arg_offset, arg_size, null_block_, null_block_, null_block_, null_block_, false};
+
+	return index;
+}
+
+void TlsfAllocator::DestroyBlock(uint32_t arg_block)
+{
+	unused_blocks_.push_back(arg_block);
+}
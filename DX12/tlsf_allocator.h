@@ -0,0 +1,89 @@
+/**
+* Two-level segregated fit (TLSF) allocator that manages offsets in a linear range,
+* e.g. a D3D12 heap. Allocation and free run in constant time and adjacent free blocks
+* are coalesced immediately. The allocator does not touch any memory itself, so it can
+* be used and tested without a device.
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class TlsfAllocator
+{
+public:
+	// Returned by Allocate when no block is large enough.
+	static const uint64_t invalid_offset_ = ~0ull;
+
+	/**
+	* @param arg_size The size of the managed range.
+	* @param arg_min_alignment Granularity of all offsets and sizes. Must be a power of two.
+	*/
+	TlsfAllocator(uint64_t arg_size, uint64_t arg_min_alignment);
+
+	/**
+	* Allocate a range. The size is rounded up to the minimum alignment.
+	* @param arg_alignment Must be a power of two.
+	* @returns The offset of the range or invalid_offset_.
+	*/
+	uint64_t Allocate(uint64_t arg_size, uint64_t arg_alignment);
+
+	// Free a range returned by Allocate.
+	void Free(uint64_t arg_offset);
+
+	uint64_t GetSize() const;
+	uint64_t GetFreeSize() const;
+	uint64_t GetLargestFreeBlock() const;
+	size_t GetAllocationCount() const;
+
+	// 0 when all free memory is one block, approaching 1 when free memory is scattered over many small blocks.
+	double GetFragmentation() const;
+
+private:
+	static const uint32_t sl_bits_ = 4;
+	static const uint32_t sl_count_ = 1 << sl_bits_;
+	static const uint32_t fl_count_ = 64;
+	static const uint32_t null_block_ = ~0u;
+
+	struct Block
+	{
+		uint64_t offset;
+		uint64_t size;
+		uint32_t prev_physical;
+		uint32_t next_physical;
+		uint32_t prev_free;
+		uint32_t next_free;
+		bool free;
+	};
+
+	// Map a size in units of the minimum alignment to its free list.
+	static void Mapping(uint64_t arg_units, uint32_t& arg_fl, uint32_t& arg_sl);
+	// Find a non-empty free list whose blocks are all at least as large as the list (arg_fl, arg_sl).
+	bool FindSuitableList(uint32_t& arg_fl, uint32_t& arg_sl) const;
+
+	void InsertFreeBlock(uint32_t arg_block);
+	void RemoveFreeBlock(uint32_t arg_block);
+	// Split the end of a block off into a new free block.
+	void SplitBlock(uint32_t arg_block, uint64_t arg_size);
+	// Merge a block into its previous physical neighbour and return the neighbour.
+	uint32_t MergeWithPrevious(uint32_t arg_block);
+
+	uint32_t CreateBlock(uint64_t arg_offset, uint64_t arg_size);
+	void DestroyBlock(uint32_t arg_block);
+
+	uint64_t size_;
+	uint64_t min_alignment_;
+	uint64_t free_size_;
+
+	std::vector<Block> blocks_;
+	std::vector<uint32_t> unused_blocks_;
+
+	uint64_t fl_bitmap_;
+	uint32_t sl_bitmap_[fl_count_];
+	uint32_t free_lists_[fl_count_][sl_count_];
+
+	// Allocated blocks by offset.
+	std::unordered_map<uint64_t, uint32_t> allocations_;
+};
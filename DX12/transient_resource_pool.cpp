@@ -0,0 +1,243 @@
+#include <transient_resource_pool.h>
+#include <command_list.h>
+#include <gpu_memory_tracker.h>
+#include <helpers.h>
+
+#include <algorithm>
+#include <cassert>
+
+static UINT64 AlignUp(UINT64 arg_value, UINT64 arg_alignment)
+{
+	return (arg_value + arg_alignment - 1) & ~(arg_alignment - 1);
+}
+
+TransientResourcePool::TransientResourcePool(std::shared_ptr<HeapAllocatorDevice> arg_device, ResidencyManager* arg_residency_manager,
+											 GpuMemoryTracker* arg_gpu_memory_tracker)
+	: device_(arg_device)
+	, residency_manager_(arg_residency_manager)
+	, gpu_memory_tracker_(arg_gpu_memory_tracker)
+	, heap_size_(0)
+	, residency_handle_(ResidencyManager::invalid_handle_)
+{ }
+
+TransientResourcePool::~TransientResourcePool()
+{
+	Clear();
+	ReleaseHeap(nullptr);
+}
+
+TransientResourcePool::Handle TransientResourcePool::Declare(const D3D12_RESOURCE_DESC& arg_desc, D3D12_RESOURCE_STATES arg_initial_state,
+															 const D3D12_CLEAR_VALUE* arg_clear_value, uint32_t arg_first_pass, uint32_t arg_last_pass)
+{
+	assert(arg_desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER &&
+		   (arg_desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) &&
+		   "The transient resource pool only places render target and depth-stencil textures.");
+	assert(arg_first_pass <= arg_last_pass && "Invalid pass range.");
+
+	Declaration declaration = { };
+	declaration.desc = arg_desc;
+	declaration.initial_state = arg_initial_state;
+	declaration.has_clear_value = arg_clear_value != nullptr;
+	if (arg_clear_value)
+	{
+		declaration.clear_value = *arg_clear_value;
+	}
+	declaration.first_pass = arg_first_pass;
+	declaration.last_pass = arg_last_pass;
+
+	declarations_.push_back(declaration);
+	return static_cast<Handle>(declarations_.size() - 1);
+}
+
+void TransientResourcePool::Clear()
+{
+	// The resources are handed out as retired objects by the next Compile.
+	for (Declaration& declaration : declarations_)
+	{
+		if (declaration.resource)
+		{
+			retired_resources_.push_back(std::move(declaration.resource));
+		}
+	}
+	declarations_.clear();
+}
+
+void TransientResourcePool::Compile(std::vector<Microsoft::WRL::ComPtr<ID3D12Object>>& arg_retired_objects)
+{
+	for (Microsoft::WRL::ComPtr<ID3D12Resource>& resource : retired_resources_)
+	{
+		arg_retired_objects.push_back(std::move(resource));
+	}
+	retired_resources_.clear();
+
+	struct Range
+	{
+		UINT64 begin;
+		UINT64 end;
+	};
+
+	// Place the largest resources first, each at the lowest offset that does not overlap the
+	// memory of an already placed resource whose passes overlap its own.
+	std::vector<uint32_t> order(declarations_.size());
+	UINT64 required_size = 0;
+	for (uint32_t i = 0; i < declarations_.size(); ++i)
+	{
+		Declaration& declaration = declarations_[i];
+		if (declaration.resource)
+		{
+			arg_retired_objects.push_back(std::move(declaration.resource));
+		}
+
+		D3D12_RESOURCE_ALLOCATION_INFO info = device_->GetResourceAllocationInfo(declaration.desc);
+		if (info.SizeInBytes == UINT64_MAX)
+		{
+			// The resource description is invalid.
+			ThrowIfFailed(E_INVALIDARG);
+		}
+		declaration.alignment = std::max<UINT64>(info.Alignment, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+		declaration.size = AlignUp(info.SizeInBytes, declaration.alignment);
+		declaration.aliased = false;
+		order[i] = i;
+	}
+
+	std::stable_sort(order.begin(), order.end(), [this](uint32_t arg_a, uint32_t arg_b)
+	{
+		return declarations_[arg_a].size > declarations_[arg_b].size;
+	});
+
+	std::vector<Range> occupied;
+	for (size_t i = 0; i < order.size(); ++i)
+	{
+		Declaration& declaration = declarations_[order[i]];
+
+		occupied.clear();
+		for (size_t j = 0; j < i; ++j)
+		{
+			const Declaration& placed = declarations_[order[j]];
+			if (placed.first_pass <= declaration.last_pass && declaration.first_pass <= placed.last_pass)
+			{
+				occupied.push_back({ placed.offset, placed.offset + placed.size });
+			}
+		}
+		std::sort(occupied.begin(), occupied.end(), [](const Range& arg_a, const Range& arg_b)
+		{
+			return arg_a.begin < arg_b.begin;
+		});
+
+		UINT64 offset = 0;
+		for (const Range& range : occupied)
+		{
+			if (AlignUp(offset, declaration.alignment) + declaration.size <= range.begin)
+			{
+				break;
+			}
+			offset = std::max(offset, range.end);
+		}
+
+		declaration.offset = AlignUp(offset, declaration.alignment);
+		required_size = std::max(required_size, declaration.offset + declaration.size);
+	}
+
+	for (size_t i = 0; i < declarations_.size(); ++i)
+	{
+		for (size_t j = i + 1; j < declarations_.size(); ++j)
+		{
+			Declaration& a = declarations_[i];
+			Declaration& b = declarations_[j];
+			if (a.offset < b.offset + b.size && b.offset < a.offset + a.size)
+			{
+				a.aliased = true;
+				b.aliased = true;
+			}
+		}
+	}
+
+	if (required_size > heap_size_)
+	{
+		ReleaseHeap(&arg_retired_objects);
+
+		D3D12_HEAP_DESC heap_desc = { };
+		heap_desc.SizeInBytes = AlignUp(required_size, D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT);
+		heap_desc.Properties.Type = D3D12_HEAP_TYPE_DEFAULT;
+		heap_desc.Alignment = D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT;
+		heap_desc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+
+		heap_ = device_->CreateHeap(heap_desc);
+		heap_size_ = heap_desc.SizeInBytes;
+		if (residency_manager_)
+		{
+			residency_handle_ = residency_manager_->Track(heap_.Get(), heap_size_);
+		}
+		if (gpu_memory_tracker_)
+		{
+			TRACK_GPU_MEMORY(*gpu_memory_tracker_, heap_.Get(), "TransientHeap", heap_size_);
+		}
+	}
+
+	for (Declaration& declaration : declarations_)
+	{
+		declaration.resource = device_->CreatePlacedResource(heap_.Get(), declaration.offset, declaration.desc, declaration.initial_state,
+															 declaration.has_clear_value ? &declaration.clear_value : nullptr);
+	}
+}
+
+ID3D12Resource* TransientResourcePool::GetResource(Handle arg_handle) const
+{
+	assert(arg_handle < declarations_.size() && "Invalid transient resource handle.");
+
+	return declarations_[arg_handle].resource.Get();
+}
+
+UINT64 TransientResourcePool::GetHeapOffset(Handle arg_handle) const
+{
+	assert(arg_handle < declarations_.size() && "Invalid transient resource handle.");
+
+	return declarations_[arg_handle].offset;
+}
+
+void TransientResourcePool::BeginUse(CommandList& arg_command_list, Handle arg_handle) const
+{
+	assert(arg_handle < declarations_.size() && declarations_[arg_handle].resource && "Invalid transient resource handle.");
+
+	if (declarations_[arg_handle].aliased)
+	{
+		arg_command_list.AliasingBarrier(nullptr, declarations_[arg_handle].resource.Get());
+	}
+}
+
+ResidencyManager::Handle TransientResourcePool::GetResidencyHandle() const
+{
+	return residency_handle_;
+}
+
+TransientResourcePool::Stats TransientResourcePool::GetStats() const
+{
+	Stats stats = { };
+	stats.resource_count = declarations_.size();
+	stats.heap_size = heap_size_;
+	for (const Declaration& declaration : declarations_)
+	{
+		stats.unaliased_size += declaration.size;
+	}
+
+	return stats;
+}
+
+void TransientResourcePool::ReleaseHeap(std::vector<Microsoft::WRL::ComPtr<ID3D12Object>>* arg_retired_objects)
+{
+	if (heap_ && residency_manager_)
+	{
+		residency_manager_->Untrack(residency_handle_);
+	}
+	if (heap_ && gpu_memory_tracker_)
+	{
+		gpu_memory_tracker_->Unregister(heap_.Get());
+	}
+	if (heap_ && arg_retired_objects)
+	{
+		arg_retired_objects->push_back(heap_);
+	}
+	residency_handle_ = ResidencyManager::invalid_handle_;
+	heap_.Reset();
+	heap_size_ = 0;
+}
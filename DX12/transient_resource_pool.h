@@ -0,0 +1,107 @@
+/**
+* The transient resource pool places screen-sized render targets and depth buffers in one
+* heap. Every resource is declared with the range of passes of the frame that use it; resources
+* whose pass ranges do not overlap share the same heap memory.
+*
+* A resource that shares memory has undefined contents at its first use in a frame. BeginUse
+* records the aliasing barrier, and the first pass must fully overwrite the resource with a
+* clear, a discard or a full copy.
+*/
+#pragma once
+
+#include <heap_allocator.h>
+#include <residency_manager.h>
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class CommandList;
+class GpuMemoryTracker;
+
+class TransientResourcePool
+{
+public:
+	using Handle = uint32_t;
+
+	struct Stats
+	{
+		size_t resource_count;
+		UINT64 heap_size;
+		UINT64 unaliased_size; // Memory the resources would need without aliasing.
+	};
+
+	/**
+	* @param arg_residency_manager If set, the heap is tracked by it. Must outlive the pool.
+	* @param arg_gpu_memory_tracker If set, the heap is registered with it. Must outlive the pool.
+	*/
+	TransientResourcePool(std::shared_ptr<HeapAllocatorDevice> arg_device, ResidencyManager* arg_residency_manager = nullptr,
+						  GpuMemoryTracker* arg_gpu_memory_tracker = nullptr);
+	virtual ~TransientResourcePool();
+
+	/**
+	* Declare a render target or depth-stencil texture that is used by the passes
+	* arg_first_pass to arg_last_pass. Takes effect at the next Compile.
+	*/
+	Handle Declare(const D3D12_RESOURCE_DESC& arg_desc, D3D12_RESOURCE_STATES arg_initial_state,
+				   const D3D12_CLEAR_VALUE* arg_clear_value, uint32_t arg_first_pass, uint32_t arg_last_pass);
+
+	// Remove all declarations, e.g. before declaring the resources again for a new size.
+	// Their resources stay alive until the next Compile retires them.
+	void Clear();
+
+	/**
+	* Place the declared resources in the heap and create them. The heap only grows, so declaring
+	* smaller resources again does not create a new heap.
+	* @param arg_retired_objects Receives the resources (and a replaced heap) of the previous
+	* Compile. The GPU may still use them, so the caller releases them once it has finished.
+	* New resources only alias old ones in later submissions on the same queue.
+	*/
+	void Compile(std::vector<Microsoft::WRL::ComPtr<ID3D12Object>>& arg_retired_objects);
+
+	ID3D12Resource* GetResource(Handle arg_handle) const;
+	// The offset of the resource in the heap, as placed by the last Compile.
+	UINT64 GetHeapOffset(Handle arg_handle) const;
+
+	// Queue the aliasing barrier needed before the first use of the resource in a frame.
+	void BeginUse(CommandList& arg_command_list, Handle arg_handle) const;
+
+	// The residency handle of the heap, for ResidencyManager::MakeResident.
+	ResidencyManager::Handle GetResidencyHandle() const;
+
+	Stats GetStats() const;
+
+private:
+	struct Declaration
+	{
+		D3D12_RESOURCE_DESC desc;
+		D3D12_RESOURCE_STATES initial_state;
+		bool has_clear_value;
+		D3D12_CLEAR_VALUE clear_value;
+		uint32_t first_pass;
+		uint32_t last_pass;
+
+		UINT64 size;
+		UINT64 alignment;
+		UINT64 offset;
+		bool aliased; // Shares memory with another resource.
+		Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+	};
+
+	void ReleaseHeap(std::vector<Microsoft::WRL::ComPtr<ID3D12Object>>* arg_retired_objects);
+
+	std::shared_ptr<HeapAllocatorDevice> device_;
+	ResidencyManager* residency_manager_;
+	GpuMemoryTracker* gpu_memory_tracker_;
+
+	Microsoft::WRL::ComPtr<ID3D12Heap> heap_;
+	UINT64 heap_size_;
+	ResidencyManager::Handle residency_handle_;
+
+	std::vector<Declaration> declarations_;
+	// Resources of cleared declarations that the next Compile retires.
+	std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> retired_resources_;
+};
@@ -0,0 +1,161 @@
+#include <upload_manager.h>
+#include <command_list.h>
+#include <command_queue.h>
+#include <helpers.h>
+
+#include <d3dx12.h>
+
+#include <vector>
+
+UploadManager::UploadManager(Microsoft::WRL::ComPtr<ID3D12Device2> arg_device, std::shared_ptr<CommandQueue> arg_copy_queue, UINT64 arg_ring_size,
+							 GpuMemoryTracker* arg_gpu_memory_tracker)
+	: d3d12_device_(arg_device)
+	, copy_queue_(arg_copy_queue)
+	, upload_ring_(arg_device, arg_ring_size, arg_gpu_memory_tracker)
+{ }
+
+UploadManager::~UploadManager()
+{
+	// The upload ring must outlive the copies that read from it.
+	Submit();
+	WaitOnCpu(last_ticket_);
+}
+
+void UploadManager::UploadBuffer(ID3D12Resource* arg_destination, UINT64 arg_destination_offset, const void* arg_data, UINT64 arg_size)
+{
+	UploadRing::Allocation upload = AllocateUpload(arg_size, 4);
+	memcpy(upload.cpu_address, arg_data, arg_size);
+
+	GetCommandList().GetGraphicsCommandList()->CopyBufferRegion(arg_destination, arg_destination_offset,
+																upload.resource, upload.offset, arg_size);
+}
+
+void UploadManager::UploadTexture(ID3D12Resource* arg_destination, UINT arg_first_subresource, UINT arg_num_subresources,
+								  const D3D12_SUBRESOURCE_DATA* arg_data)
+{
+	D3D12_RESOURCE_DESC desc = arg_destination->GetDesc();
+
+	std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(arg_num_subresources);
+	std::vector<UINT> num_rows(arg_num_subresources);
+	std::vector<UINT64> row_sizes(arg_num_subresources);
+	UINT64 total_size = 0;
+	d3d12_device_->GetCopyableFootprints(&desc, arg_first_subresource, arg_num_subresources, 0,
+										 layouts.data(), num_rows.data(), row_sizes.data(), &total_size);
+
+	UploadRing::Allocation upload = AllocateUpload(total_size, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+	auto& command_list = GetCommandList().GetGraphicsCommandList();
+
+	for (UINT i = 0; i < arg_num_subresources; ++i)
+	{
+		// Copy the rows at the pitch the copy engine expects. Data that is already at that pitch, like
+		// cooked texture files, is copied in one go.
+		D3D12_MEMCPY_DEST destination_data = {
+			static_cast<BYTE*>(upload.cpu_address) + layouts[i].Offset,
+			layouts[i].Footprint.RowPitch,
+			SIZE_T(layouts[i].Footprint.RowPitch) * num_rows[i]
+		};
+		if (arg_data[i].RowPitch == LONG_PTR(destination_data.RowPitch) &&
+			(layouts[i].Footprint.Depth == 1 || arg_data[i].SlicePitch == LONG_PTR(destination_data.SlicePitch)))
+		{
+			SIZE_T size = destination_data.SlicePitch * (layouts[i].Footprint.Depth - 1) +
+						  destination_data.RowPitch * (num_rows[i] - 1) + static_cast<SIZE_T>(row_sizes[i]);
+			memcpy(destination_data.pData, arg_data[i].pData, size);
+		}
+		else
+		{
+			MemcpySubresource(&destination_data, &arg_data[i], static_cast<SIZE_T>(row_sizes[i]), num_rows[i], layouts[i].Footprint.Depth);
+		}
+
+		// The footprints are relative to the start of the allocation.
+		layouts[i].Offset += upload.offset;
+
+		CD3DX12_TEXTURE_COPY_LOCATION destination(arg_destination, arg_first_subresource + i);
+		CD3DX12_TEXTURE_COPY_LOCATION source(upload.resource, layouts[i]);
+		command_list->CopyTextureRegion(&destination, 0, 0, 0, &source, nullptr);
+	}
+}
+
+void UploadManager::UploadTexture(ID3D12Resource* arg_destination, UINT arg_subresource, const WriteSubresourceFunction& arg_write)
+{
+	D3D12_RESOURCE_DESC desc = arg_destination->GetDesc();
+
+	D3D12_PLACED_SUBRESOURCE_FOOTPRINT layout;
+	UINT num_rows;
+	UINT64 row_size;
+	UINT64 total_size;
+	d3d12_device_->GetCopyableFootprints(&desc, arg_subresource, 1, 0, &layout, &num_rows, &row_size, &total_size);
+
+	UploadRing::Allocation upload = AllocateUpload(total_size, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+	MappedSubresource mapped = {
+		static_cast<BYTE*>(upload.cpu_address) + layout.Offset,
+		layout.Footprint.RowPitch,
+		num_rows,
+		row_size
+	};
+	arg_write(mapped);
+
+	layout.Offset += upload.offset;
+
+	CD3DX12_TEXTURE_COPY_LOCATION destination(arg_destination, arg_subresource);
+	CD3DX12_TEXTURE_COPY_LOCATION source(upload.resource, layout);
+	GetCommandList().GetGraphicsCommandList()->CopyTextureRegion(&destination, 0, 0, 0, &source, nullptr);
+}
+
+UploadTicket UploadManager::Submit()
+{
+	if (command_list_)
+	{
+		last_ticket_.fence_value = copy_queue_->ExecuteCommandList(std::move(command_list_));
+		upload_ring_.FinishSubmission(last_ticket_.fence_value);
+	}
+
+	return last_ticket_;
+}
+
+bool UploadManager::IsComplete(const UploadTicket& arg_ticket) const
+{
+	return copy_queue_->IsFenceComplete(arg_ticket.fence_value);
+}
+
+void UploadManager::WaitOnQueue(const UploadTicket& arg_ticket, CommandQueue& arg_consumer)
+{
+	arg_consumer.Wait(*copy_queue_, arg_ticket.fence_value);
+}
+
+void UploadManager::WaitOnCpu(const UploadTicket& arg_ticket)
+{
+	copy_queue_->WaitForFenceValue(arg_ticket.fence_value);
+	ReleaseCompleted();
+}
+
+void UploadManager::ReleaseCompleted()
+{
+	upload_ring_.ReleaseCompleted(copy_queue_->GetCompletedFenceValue());
+}
+
+UploadRing::Allocation UploadManager::AllocateUpload(UINT64 arg_size, UINT64 arg_alignment)
+{
+	ReleaseCompleted();
+
+	UploadRing::Allocation upload;
+	if (!upload_ring_.TryAllocate(arg_size, arg_alignment, upload))
+	{
+		// Only submitted batches can be waited for, so submit the current one before
+		// waiting for ring space.
+		Submit();
+		upload = upload_ring_.Allocate(arg_size, arg_alignment, *copy_queue_);
+	}
+
+	return upload;
+}
+
+CommandList& UploadManager::GetCommandList()
+{
+	if (!command_list_)
+	{
+		command_list_ = copy_queue_->GetCommandList();
+	}
+
+	return *command_list_;
+}
@@ -0,0 +1,102 @@
+/**
+* The upload manager batches buffer and texture uploads onto the dedicated copy queue.
+* Upload data is staged in a persistently mapped upload ring. Submitting a batch returns
+* a ticket; consumers on other queues only wait for the copies on the GPU when they
+* actually need the uploaded resources, so loading overlaps rendering.
+*
+* Destination resources should be created in D3D12_RESOURCE_STATE_COMMON. They are
+* promoted to the copy destination state on the copy queue and decay back to COMMON
+* once the copies have finished, from where they can be promoted to read states on
+* the consuming queue.
+*/
+#pragma once
+
+#include <upload_ring.h>
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+class CommandList;
+class CommandQueue;
+class GpuMemoryTracker;
+
+// Identifies a submitted batch of uploads.
+struct UploadTicket
+{
+	uint64_t fence_value = 0;
+};
+
+// CPU view of a subresource footprint in the upload ring.
+struct MappedSubresource
+{
+	BYTE* data;
+	UINT row_pitch;
+	UINT num_rows;
+	UINT64 row_size;
+};
+
+class UploadManager
+{
+public:
+	using WriteSubresourceFunction = std::function<void(const MappedSubresource&)>;
+
+	/**
+	* @param arg_copy_queue The queue the uploads are executed on.
+	* @param arg_ring_size The size of the upload ring. A single upload can not be larger than this.
+	* @param arg_gpu_memory_tracker If set, the upload ring is registered with it. Must outlive the upload manager.
+	*/
+	UploadManager(Microsoft::WRL::ComPtr<ID3D12Device2> arg_device, std::shared_ptr<CommandQueue> arg_copy_queue,
+				  UINT64 arg_ring_size = 64 * 1024 * 1024, GpuMemoryTracker* arg_gpu_memory_tracker = nullptr);
+	virtual ~UploadManager();
+
+	// Record a copy of the data into a buffer. The data is copied into the upload ring immediately.
+	void UploadBuffer(ID3D12Resource* arg_destination, UINT64 arg_destination_offset, const void* arg_data, UINT64 arg_size);
+
+	// Record a copy of the data into texture subresources. The data is copied into the upload ring immediately.
+	void UploadTexture(ID3D12Resource* arg_destination, UINT arg_first_subresource, UINT arg_num_subresources,
+					   const D3D12_SUBRESOURCE_DATA* arg_data);
+
+	/**
+	* Record a copy into a texture subresource whose data is written by the caller straight
+	* into the upload ring, so it can be produced (decoded, converted) at the final pitch
+	* without an intermediate image.
+	* @param arg_write Writes num_rows rows of row_size bytes, row_pitch bytes apart.
+	*/
+	void UploadTexture(ID3D12Resource* arg_destination, UINT arg_subresource, const WriteSubresourceFunction& arg_write);
+
+	/**
+	* Execute all recorded uploads on the copy queue.
+	* @returns The ticket of the batch. If nothing was recorded the ticket of the previous batch is returned.
+	*/
+	UploadTicket Submit();
+
+	// Returns true if the uploads of the ticket have finished on the GPU.
+	bool IsComplete(const UploadTicket& arg_ticket) const;
+
+	// Make another queue wait on the GPU for the uploads of the ticket. Does nothing if they already finished.
+	void WaitOnQueue(const UploadTicket& arg_ticket, CommandQueue& arg_consumer);
+
+	// Block the CPU until the uploads of the ticket have finished.
+	void WaitOnCpu(const UploadTicket& arg_ticket);
+
+	// Return the upload memory of finished batches to the ring.
+	void ReleaseCompleted();
+
+private:
+	// The command list the current batch is recorded into.
+	CommandList& GetCommandList();
+
+	// Allocate upload memory, submitting the current batch if the ring is full.
+	UploadRing::Allocation AllocateUpload(UINT64 arg_size, UINT64 arg_alignment);
+
+	Microsoft::WRL::ComPtr<ID3D12Device2> d3d12_device_;
+	std::shared_ptr<CommandQueue> copy_queue_;
+	UploadRing upload_ring_;
+
+	std::shared_ptr<CommandList> command_list_;
+	UploadTicket last_ticket_;
+};
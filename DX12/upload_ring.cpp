@@ -0,0 +1,163 @@
+#include <upload_ring.h>
+#include <command_queue.h>
+#include <gpu_memory_tracker.h>
+#include <helpers.h>
+
+#include <d3dx12.h>
+
+#include <cassert>
+
+static UINT64 AlignUp(UINT64 arg_value, UINT64 arg_alignment)
+{
+	return (arg_value + arg_alignment - 1) & ~(arg_alignment - 1);
+}
+
+UploadRing::UploadRing(Microsoft::WRL::ComPtr<ID3D12Device2> arg_device, UINT64 arg_capacity, GpuMemoryTracker* arg_gpu_memory_tracker)
+	: cpu_base_(nullptr)
+	, gpu_memory_tracker_(arg_gpu_memory_tracker)
+	, capacity_(arg_capacity)
+	, head_(0)
+	, tail_(0)
+	, used_size_(0)
+	, pending_size_(0)
+{
+	ThrowIfFailed(arg_device->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(capacity_),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&upload_buffer_)));
+	if (gpu_memory_tracker_)
+	{
+		TRACK_GPU_MEMORY(*gpu_memory_tracker_, upload_buffer_.Get(), "UploadRing",
+						 GpuMemoryTracker::GetAllocationSize(arg_device.Get(), upload_buffer_.Get()));
+	}
+
+	// The buffer stays mapped for its whole lifetime. The CPU never reads from it.
+	CD3DX12_RANGE read_range(0, 0);
+	ThrowIfFailed(upload_buffer_->Map(0, &read_range, reinterpret_cast<void**>(&cpu_base_)));
+	gpu_base_ = upload_buffer_->GetGPUVirtualAddress();
+}
+
+UploadRing::~UploadRing()
+{
+	upload_buffer_->Unmap(0, nullptr);
+	if (gpu_memory_tracker_)
+	{
+		gpu_memory_tracker_->Unregister(upload_buffer_.Get());
+	}
+}
+
+bool UploadRing::TryAllocate(UINT64 arg_size, UINT64 arg_alignment, Allocation& arg_allocation)
+{
+	assert(arg_alignment > 0 && (arg_alignment & (arg_alignment - 1)) == 0 && "Alignment must be a power of two.");
+
+	if (used_size_ == 0)
+	{
+		// Start from the beginning of the buffer whenever the ring is empty.
+		head_ = 0;
+		tail_ = 0;
+	}
+	else if (used_size_ == capacity_)
+	{
+		return false;
+	}
+
+	UINT64 offset = AlignUp(head_, arg_alignment);
+	UINT64 new_head = 0;
+	UINT64 allocated_size = 0;
+
+	if (tail_ <= head_)
+	{
+		if (offset + arg_size <= capacity_)
+		{
+			new_head = offset + arg_size;
+			allocated_size = new_head - head_;
+		}
+		else if (arg_size <= tail_)
+		{
+			// Wrap around and waste the end of the buffer. The start of the buffer is always aligned.
+			offset = 0;
+			new_head = arg_size;
+			allocated_size = (capacity_ - head_) + arg_size;
+		}
+		else
+		{
+			return false;
+		}
+	}
+	else if (offset + arg_size <= tail_)
+	{
+		new_head = offset + arg_size;
+		allocated_size = new_head - head_;
+	}
+	else
+	{
+		return false;
+	}
+
+	head_ = new_head;
+	used_size_ += allocated_size;
+	pending_size_ += allocated_size;
+
+	arg_allocation.cpu_address = cpu_base_ + offset;
+	arg_allocation.gpu_address = gpu_base_ + offset;
+	arg_allocation.resource = upload_buffer_.Get();
+	arg_allocation.offset = offset;
+
+	return true;
+}
+
+UploadRing::Allocation UploadRing::Allocate(UINT64 arg_size, UINT64 arg_alignment, CommandQueue& arg_queue)
+{
+	if (arg_size > capacity_)
+	{
+		ThrowIfFailed(E_OUTOFMEMORY);
+	}
+
+	Allocation allocation;
+	while (!TryAllocate(arg_size, arg_alignment, allocation))
+	{
+		// Only memory of finished submissions can be reclaimed.
+		if (submissions_.empty())
+		{
+			ThrowIfFailed(E_OUTOFMEMORY);
+		}
+
+		uint64_t fence_value = submissions_.front().fence_value;
+		arg_queue.WaitForFenceValue(fence_value);
+		ReleaseCompleted(fence_value);
+	}
+
+	return allocation;
+}
+
+void UploadRing::FinishSubmission(uint64_t arg_fence_value)
+{
+	if (pending_size_ > 0)
+	{
+		submissions_.push_back(Submission{arg_fence_value, head_, pending_size_});
+		pending_size_ = 0;
+	}
+}
+
+void UploadRing::ReleaseCompleted(uint64_t arg_completed_fence_value)
+{
+	while (!submissions_.empty() && submissions_.front().fence_value <= arg_completed_fence_value)
+	{
+		tail_ = submissions_.front().end_offset;
+		used_size_ -= submissions_.front().size;
+		submissions_.pop_front();
+	}
+}
+
+UINT64 UploadRing::GetCapacity() const
+{
+	return capacity_;
+}
+
+UINT64 UploadRing::GetUsedSize() const
+{
+	return used_size_;
+}
@@ -0,0 +1,79 @@
+/**
+* The upload ring is a single persistently mapped upload buffer that is sub-allocated
+* linearly. Allocations are grouped per submission and retired by fence value, so
+* uploading data costs a pointer bump instead of creating an upload heap per call.
+*/
+#pragma once
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <deque>
+
+class CommandQueue;
+class GpuMemoryTracker;
+
+class UploadRing
+{
+public:
+	// A sub-allocation of the upload buffer.
+	struct Allocation
+	{
+		void* cpu_address;
+		D3D12_GPU_VIRTUAL_ADDRESS gpu_address;
+		ID3D12Resource* resource;
+		UINT64 offset; // Offset of the allocation in the resource.
+	};
+
+	/**
+	* @param arg_capacity The size of the upload buffer in bytes.
+	* @param arg_gpu_memory_tracker If set, the upload buffer is registered with it. Must outlive the ring.
+	*/
+	UploadRing(Microsoft::WRL::ComPtr<ID3D12Device2> arg_device, UINT64 arg_capacity, GpuMemoryTracker* arg_gpu_memory_tracker = nullptr);
+	virtual ~UploadRing();
+
+	/**
+	* Allocate memory from the ring. Returns false if there is not enough free space
+	* until earlier submissions have been retired.
+	* @param arg_alignment Must be a power of two, e.g. 256 for constant buffers or
+	* D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT for texture uploads.
+	*/
+	bool TryAllocate(UINT64 arg_size, UINT64 arg_alignment, Allocation& arg_allocation);
+
+	/**
+	* Allocate memory from the ring. If the ring is full, waits on the queue for the oldest
+	* submissions to retire. Throws if the request can never fit.
+	*/
+	Allocation Allocate(UINT64 arg_size, UINT64 arg_alignment, CommandQueue& arg_queue);
+
+	// Tag all allocations made since the last call with the fence value of the submission that uses them.
+	void FinishSubmission(uint64_t arg_fence_value);
+
+	// Make the memory of all submissions up to and including the completed fence value available again.
+	void ReleaseCompleted(uint64_t arg_completed_fence_value);
+
+	UINT64 GetCapacity() const;
+	UINT64 GetUsedSize() const;
+
+private:
+	struct Submission
+	{
+		uint64_t fence_value;
+		UINT64 end_offset; // The head of the ring when the submission was finished.
+		UINT64 size;       // Bytes allocated (including padding) for the submission.
+	};
+
+	Microsoft::WRL::ComPtr<ID3D12Resource> upload_buffer_;
+	uint8_t* cpu_base_;
+	D3D12_GPU_VIRTUAL_ADDRESS gpu_base_;
+	GpuMemoryTracker* gpu_memory_tracker_;
+
+	UINT64 capacity_;
+	UINT64 head_;
+	UINT64 tail_;
+	UINT64 used_size_;
+	UINT64 pending_size_; // Bytes allocated since the last FinishSubmission.
+
+	std::deque<Submission> submissions_;
+};
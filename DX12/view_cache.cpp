@@ -0,0 +1,136 @@
+#include <view_cache.h>
+#include <hash.h>
+
+#include <cassert>
+#include <cstring>
+
+ViewCache::ViewCache(Microsoft::WRL::ComPtr<ID3D12Device2> arg_device, DescriptorAllocator& arg_descriptor_allocator, BindlessTable& arg_bindless_table)
+	: d3d12_device_(arg_device)
+	, descriptor_allocator_(arg_descriptor_allocator)
+	, bindless_table_(arg_bindless_table)
+	, hit_count_(0)
+	, miss_count_(0)
+{ }
+
+ViewCache::~ViewCache()
+{
+	assert(views_.empty() && "Views were not released.");
+}
+
+BindlessHandle ViewCache::AcquireShaderResourceView(ID3D12Resource* arg_resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* arg_desc)
+{
+	Key key = MakeKey(arg_resource, arg_desc);
+
+	auto it = views_.find(key);
+	if (it != views_.end())
+	{
+		++hit_count_;
+		++it->second.reference_count;
+		return it->second.handle;
+	}
+
+	++miss_count_;
+
+	Entry entry;
+	entry.descriptor = descriptor_allocator_.Allocate();
+	d3d12_device_->CreateShaderResourceView(arg_resource, arg_desc, entry.descriptor.GetDescriptorHandle());
+	entry.handle = bindless_table_.Allocate(entry.descriptor.GetDescriptorHandle());
+	entry.reference_count = 1;
+
+	keys_[entry.handle.index] = key;
+	views_[key] = entry;
+
+	return entry.handle;
+}
+
+void ViewCache::Release(const BindlessHandle& arg_handle, uint64_t arg_fence_value)
+{
+	if (arg_handle.IsNull())
+	{
+		return;
+	}
+
+	assert(bindless_table_.IsValid(arg_handle) && "Stale bindless handle.");
+
+	auto key_it = keys_.find(arg_handle.index);
+	assert(key_it != keys_.end() && "The view was not created by the cache.");
+
+	auto it = views_.find(key_it->second);
+	if (--it->second.reference_count > 0)
+	{
+		return;
+	}
+
+	bindless_table_.Free(it->second.handle, arg_fence_value);
+	descriptor_allocator_.Free(it->second.descriptor, arg_fence_value);
+	views_.erase(it);
+	keys_.erase(key_it);
+}
+
+ViewCache::Stats ViewCache::GetStats() const
+{
+	Stats stats = { };
+	stats.view_count = views_.size();
+	stats.hit_count = hit_count_;
+	stats.miss_count = miss_count_;
+
+	return stats;
+}
+
+ViewCache::Key ViewCache::MakeKey(ID3D12Resource* arg_resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* arg_desc)
+{
+	static_assert(sizeof(Key) == 48, "The key must not contain padding.");
+	static_assert(sizeof(Key::view) >= sizeof(D3D12_BUFFER_SRV) && sizeof(Key::view) >= sizeof(D3D12_TEX2D_ARRAY_SRV), "The view does not fit the key.");
+	// The texture views only have 4 byte fields, so they have no padding and are copied whole.
+	static_assert(sizeof(D3D12_TEX1D_SRV) == 3 * 4 && sizeof(D3D12_TEX1D_ARRAY_SRV) == 5 * 4 &&
+				  sizeof(D3D12_TEX2D_SRV) == 4 * 4 && sizeof(D3D12_TEX2D_ARRAY_SRV) == 6 * 4 &&
+				  sizeof(D3D12_TEX2DMS_SRV) == 1 * 4 && sizeof(D3D12_TEX2DMS_ARRAY_SRV) == 2 * 4 &&
+				  sizeof(D3D12_TEX3D_SRV) == 3 * 4 && sizeof(D3D12_TEXCUBE_SRV) == 3 * 4 &&
+				  sizeof(D3D12_TEXCUBE_ARRAY_SRV) == 5 * 4, "A texture view contains padding.");
+
+	Key key;
+	memset(&key, 0, sizeof(key));
+	key.resource = reinterpret_cast<uintptr_t>(arg_resource);
+
+	if (!arg_desc)
+	{
+		return key;
+	}
+
+	key.has_desc = 1;
+	key.format = arg_desc->Format;
+	key.view_dimension = arg_desc->ViewDimension;
+	key.component_mapping = arg_desc->Shader4ComponentMapping;
+
+	switch (arg_desc->ViewDimension)
+	{
+	case D3D12_SRV_DIMENSION_BUFFER:
+		// D3D12_BUFFER_SRV ends in 4 bytes of padding, so its fields are copied one by one.
+		key.view[0] = arg_desc->Buffer.FirstElement;
+		key.view[1] = arg_desc->Buffer.NumElements | (uint64_t(arg_desc->Buffer.StructureByteStride) << 32);
+		key.view[2] = arg_desc->Buffer.Flags;
+		break;
+	case D3D12_SRV_DIMENSION_TEXTURE1D: memcpy(key.view, &arg_desc->Texture1D, sizeof(arg_desc->Texture1D)); break;
+	case D3D12_SRV_DIMENSION_TEXTURE1DARRAY: memcpy(key.view, &arg_desc->Texture1DArray, sizeof(arg_desc->Texture1DArray)); break;
+	case D3D12_SRV_DIMENSION_TEXTURE2D: memcpy(key.view, &arg_desc->Texture2D, sizeof(arg_desc->Texture2D)); break;
+	case D3D12_SRV_DIMENSION_TEXTURE2DARRAY: memcpy(key.view, &arg_desc->Texture2DArray, sizeof(arg_desc->Texture2DArray)); break;
+	case D3D12_SRV_DIMENSION_TEXTURE2DMS: memcpy(key.view, &arg_desc->Texture2DMS, sizeof(arg_desc->Texture2DMS)); break;
+	case D3D12_SRV_DIMENSION_TEXTURE2DMSARRAY: memcpy(key.view, &arg_desc->Texture2DMSArray, sizeof(arg_desc->Texture2DMSArray)); break;
+	case D3D12_SRV_DIMENSION_TEXTURE3D: memcpy(key.view, &arg_desc->Texture3D, sizeof(arg_desc->Texture3D)); break;
+	case D3D12_SRV_DIMENSION_TEXTURECUBE: memcpy(key.view, &arg_desc->TextureCube, sizeof(arg_desc->TextureCube)); break;
+	case D3D12_SRV_DIMENSION_TEXTURECUBEARRAY: memcpy(key.view, &arg_desc->TextureCubeArray, sizeof(arg_desc->TextureCubeArray)); break;
+	default: assert(false && "Unsupported view dimension."); break;
+	}
+
+	return key;
+}
+
+size_t ViewCache::KeyHash::operator()(const Key& arg_key) const
+{
+	return static_cast<size_t>(HashValue(arg_key));
+}
+
+bool ViewCache::KeyEqual::operator()(const Key& arg_a, const Key& arg_b) const
+{
+	return memcmp(&arg_a, &arg_b, sizeof(Key)) == 0;
+}
@@ -0,0 +1,93 @@
+/**
+* The view cache deduplicates shader resource views. Views are keyed by their resource and view
+* description; requesting a view that already exists returns the same slot of the bindless table
+* and adds a reference instead of creating another descriptor. A view is freed when its last
+* reference is released. Views must be released before their resource is destroyed.
+*/
+#pragma once
+
+#include <bindless_table.h>
+#include <descriptor_allocator.h>
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <unordered_map>
+
+class ViewCache
+{
+public:
+	struct Stats
+	{
+		size_t view_count;
+		uint64_t hit_count;
+		uint64_t miss_count;
+	};
+
+	/**
+	* @param arg_descriptor_allocator The CBV/SRV/UAV allocator the views are created in before they
+	* are copied to the table. Must outlive the cache.
+	* @param arg_bindless_table Must outlive the cache.
+	*/
+	ViewCache(Microsoft::WRL::ComPtr<ID3D12Device2> arg_device, DescriptorAllocator& arg_descriptor_allocator, BindlessTable& arg_bindless_table);
+	virtual ~ViewCache();
+
+	/**
+	* Get the shader resource view of a resource, creating it if it does not exist yet.
+	* Every call adds a reference that must be released with Release.
+	* @param arg_desc The view description, or null for the default view of the resource.
+	*/
+	BindlessHandle AcquireShaderResourceView(ID3D12Resource* arg_resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* arg_desc);
+
+	/**
+	* Release a reference. The view is freed once the submission with the fence value has finished.
+	* @param arg_fence_value Fence value of the direct queue.
+	*/
+	void Release(const BindlessHandle& arg_handle, uint64_t arg_fence_value);
+
+	Stats GetStats() const;
+
+private:
+	// The key has no padding, so it can be hashed and compared bytewise.
+	struct Key
+	{
+		uint64_t resource;
+		uint32_t has_desc;
+		uint32_t format;
+		uint32_t view_dimension;
+		uint32_t component_mapping;
+		// The union member of the view dimension, zero padded.
+		uint64_t view[3];
+	};
+
+	struct KeyHash
+	{
+		size_t operator()(const Key& arg_key) const;
+	};
+
+	struct KeyEqual
+	{
+		bool operator()(const Key& arg_a, const Key& arg_b) const;
+	};
+
+	struct Entry
+	{
+		DescriptorAllocation descriptor;
+		BindlessHandle handle;
+		uint32_t reference_count;
+	};
+
+	static Key MakeKey(ID3D12Resource* arg_resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* arg_desc);
+
+	Microsoft::WRL::ComPtr<ID3D12Device2> d3d12_device_;
+	DescriptorAllocator& descriptor_allocator_;
+	BindlessTable& bindless_table_;
+
+	std::unordered_map<Key, Entry, KeyHash, KeyEqual> views_;
+	// The key of every view by its index in the bindless table.
+	std::unordered_map<uint32_t, Key> keys_;
+
+	uint64_t hit_count_;
+	uint64_t miss_count_;
+};
@@ -2,6 +2,7 @@
 #include <application.h>
 #include <game.h>
 #include <command_queue.h>
+#include <gpu_memory_tracker.h>
 #include <helpers.h>
 
 #define WIN32_LEAN_AND_MEAN
@@ -43,6 +44,9 @@ Window::Window(HWND arg_h_wnd, const std::wstring& arg_window_name, int arg_clie
 	, window_name_(arg_window_name)
 	, client_width_(arg_client_width)
 	, client_height_(arg_client_height)
+	, resize_pending_(false)
+	, pending_width_(arg_client_width)
+	, pending_height_(arg_client_height)
 	, v_sync_(arg_v_sync)
 	, fullscreen_(false)
 	, frame_counter_(0)
@@ -53,8 +57,7 @@ Window::Window(HWND arg_h_wnd, const std::wstring& arg_window_name, int arg_clie
 	tearing_supported_ = app_->IsTearingSupported();
 
 	dxgi_swap_chain_ = CreateSwapChain();
-	d3d12_rtv_descriptor_heap_ = app_->CreateDescriptorHeap(buffer_count_, D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-	rtv_descriptor_size_ = app_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+	rtv_descriptors_ = app_->AllocateDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_RTV, buffer_count_);
 
 	UpdateRenderTargetViews();
 }
@@ -96,6 +99,17 @@ void Window::Destroy()
 		// Notify the registered game that the window is being destroyed.
 		game->OnWindowDestroy();
 	}
+	GpuMemoryTracker& gpu_memory_tracker = app_->GetGpuMemoryTracker();
+	for (int i = 0; i < buffer_count_; ++i)
+	{
+		if (d3d12_back_buffers_[i])
+		{
+			gpu_memory_tracker.Unregister(d3d12_back_buffers_[i].Get());
+		}
+	}
+	app_->GetDescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE_RTV).Free(rtv_descriptors_,
+		app_->GetCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT)->GetLastSignaledFenceValue());
+
 	if (h_wnd_)
 	{
 		DestroyWindow(h_wnd_);
@@ -214,6 +228,8 @@ void Window::OnUpdate(UpdateEventArgs&)
 
 void Window::OnRender(RenderEventArgs&)
 {
+	ApplyPendingResize();
+
 	render_clock_.Tick();
 
 	if (auto game = game_.lock())
@@ -221,6 +237,8 @@ void Window::OnRender(RenderEventArgs&)
 		RenderEventArgs render_event_args(render_clock_.GetDeltaSeconds(), render_clock_.GetTotalSeconds());
 		game->OnRender(render_event_args);
 	}
+
+	app_->ReleaseStaleDescriptors(app_->GetCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT)->GetCompletedFenceValue());
 }
 
 void Window::OnKeyPressed(KeyEventArgs& arg_e)
@@ -277,16 +295,35 @@ void Window::OnMouseWheel(MouseWheelEventArgs& arg_e)
 
 void Window::OnResize(ResizeEventArgs& arg_e)
 {
+	// Dragging the window border sends many WM_SIZE messages per frame; only the last one matters.
+	pending_width_ = arg_e.Width;
+	pending_height_ = arg_e.Height;
+	resize_pending_ = true;
+}
+
+void Window::ApplyPendingResize()
+{
+	if (!resize_pending_)
+	{
+		return;
+	}
+	resize_pending_ = false;
+
+	ResizeEventArgs resize_event_args(pending_width_, pending_height_);
+
 	// Update the client size.
-	if (client_width_ != arg_e.Width || client_height_ != arg_e.Height)
+	if (client_width_ != std::max(1, pending_width_) || client_height_ != std::max(1, pending_height_))
 	{
-		client_width_ = std::max(1, arg_e.Width);
-		client_height_ = std::max(1, arg_e.Height);
+		client_width_ = std::max(1, pending_width_);
+		client_height_ = std::max(1, pending_height_);
 
-		app_->Flush();
+		// The swapchain can only be resized once the GPU has finished with its back buffers.
+		// They are only used by the direct queue, so the other queues keep running.
+		app_->GetCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT)->Flush();
 
 		for (int i = 0; i < buffer_count_; ++i)
 		{
+			app_->GetGpuMemoryTracker().Unregister(d3d12_back_buffers_[i].Get());
 			d3d12_back_buffers_[i].Reset();
 		}
 
@@ -302,7 +339,7 @@ void Window::OnResize(ResizeEventArgs& arg_e)
 
 	if (auto game = game_.lock())
 	{
-		game->OnResize(arg_e);
+		game->OnResize(resize_event_args);
 	}
 }
 
@@ -357,25 +394,22 @@ void Window::UpdateRenderTargetViews()
 {
 	auto device = app_->GetDevice();
 
-	CD3DX12_CPU_DESCRIPTOR_HANDLE rtv_handle(d3d12_rtv_descriptor_heap_->GetCPUDescriptorHandleForHeapStart());
-
 	for (int i = 0; i < buffer_count_; ++i)
 	{
 		ComPtr<ID3D12Resource> back_buffer;
 		ThrowIfFailed(dxgi_swap_chain_->GetBuffer(i, IID_PPV_ARGS(&back_buffer)));
 
-		device->CreateRenderTargetView(back_buffer.Get(), nullptr, rtv_handle);
+		device->CreateRenderTargetView(back_buffer.Get(), nullptr, rtv_descriptors_.GetDescriptorHandle(i));
 
+		TRACK_GPU_MEMORY(app_->GetGpuMemoryTracker(), back_buffer.Get(), "SwapChain",
+						 GpuMemoryTracker::GetAllocationSize(device.Get(), back_buffer.Get()));
 		d3d12_back_buffers_[i] = back_buffer;
-
-		rtv_handle.Offset(rtv_descriptor_size_);
 	}
 }
 
 D3D12_CPU_DESCRIPTOR_HANDLE Window::GetCurrentRenderTargetView() const
 {
-	return CD3DX12_CPU_DESCRIPTOR_HANDLE(d3d12_rtv_descriptor_heap_->GetCPUDescriptorHandleForHeapStart(),
-										 current_back_buffer_index_, rtv_descriptor_size_);
+	return rtv_descriptors_.GetDescriptorHandle(current_back_buffer_index_);
 }
 
 Microsoft::WRL::ComPtr<ID3D12Resource> Window::GetCurrentBackBuffer() const
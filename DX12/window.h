@@ -1,4 +1,5 @@
 #pragma once
+#include <descriptor_allocator.h>
 #include <events.h>
 #include <high_resolution_clock.h>
 
@@ -120,9 +121,12 @@ protected:
 	// The mouse wheel was moved.
 	virtual void OnMouseWheel(MouseWheelEventArgs& arg_e);
 
-	// The window was resized.
+	// The window was resized. The swapchain is resized at the start of the next frame.
 	virtual void OnResize(ResizeEventArgs& arg_e);
 
+	// Resize the swapchain to the last requested size and notify the game.
+	void ApplyPendingResize();
+
 	// Create the swapchian.
 	Microsoft::WRL::ComPtr<IDXGISwapChain4> CreateSwapChain();
 
@@ -140,6 +144,11 @@ private:
 
 	int client_width_;
 	int client_height_;
+
+	// Resize requests are coalesced and applied at most once per frame.
+	bool resize_pending_;
+	int pending_width_;
+	int pending_height_;
 	bool v_sync_;
 	bool fullscreen_;
 
@@ -150,10 +159,9 @@ private:
 	std::weak_ptr<Game> game_;
 
 	Microsoft::WRL::ComPtr<IDXGISwapChain4> dxgi_swap_chain_;
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> d3d12_rtv_descriptor_heap_;
+	DescriptorAllocation rtv_descriptors_;
 	Microsoft::WRL::ComPtr<ID3D12Resource> d3d12_back_buffers_[buffer_count_];
 
-	UINT rtv_descriptor_size_;
 	UINT current_back_buffer_index_;
 
 	RECT window_rect_;
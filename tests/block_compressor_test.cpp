@@ -0,0 +1,554 @@
+#include <block_compressor.h>
+
+#include "test.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// The pixels of a 4x4 block, row by row.
+struct Block
+{
+	uint8_t pixels[16][4];
+};
+
+// The pixels of the second subset of the BC7 two-subset partitions, bit i for pixel i.
+static const uint16_t bc7_partitions_2[64] = {
+	0xcccc, 0x8888, 0xeeee, 0xecc8, 0xc880, 0xfeec, 0xfec8, 0xec80,
+	0xc800, 0xffec, 0xfe80, 0xe800, 0xffe8, 0xff00, 0xfff0, 0xf000,
+	0xf710, 0x008e, 0x7100, 0x08ce, 0x008c, 0x7310, 0x3100, 0x8cce,
+	0x088c, 0x3110, 0x6666, 0x366c, 0x17e8, 0x0ff0, 0x718e, 0x399c,
+	0xaaaa, 0xf0f0, 0x5a5a, 0x33cc, 0x3c3c, 0x55aa, 0x9696, 0xa55a,
+	0x73ce, 0x13c8, 0x324c, 0x3bdc, 0x6996, 0xc33c, 0x9966, 0x0660,
+	0x0272, 0x04e4, 0x4e40, 0x2720, 0xc936, 0x936c, 0x39c6, 0x639c,
+	0x9336, 0x9cc6, 0x817e, 0xe718, 0xccf0, 0x0fcc, 0x7744, 0xee22
+};
+
+// The anchor pixel of the second subset of each partition.
+static const uint8_t bc7_anchors_2[64] = {
+	15, 15, 15, 15, 15, 15, 15, 15,
+	15, 15, 15, 15, 15, 15, 15, 15,
+	15, 2, 8, 2, 2, 8, 8, 15,
+	2, 8, 2, 2, 8, 8, 2, 2,
+	15, 15, 6, 8, 2, 8, 15, 15,
+	2, 8, 2, 2, 2, 15, 15, 6,
+	6, 2, 6, 8, 15, 15, 2, 2,
+	15, 15, 15, 15, 15, 2, 2, 15
+};
+
+static const uint32_t bc7_weights_3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+static const uint32_t bc7_weights_4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// Read the bits of a 128-bit BC7 block, from the lowest bit up.
+class BitReader
+{
+public:
+	BitReader(const uint8_t* arg_data)
+		: data_(arg_data)
+		, position_(0)
+	{ }
+
+	uint32_t Read(uint32_t arg_bit_count)
+	{
+		uint32_t value = 0;
+		for (uint32_t bit = 0; bit < arg_bit_count; ++bit, ++position_)
+		{
+			value |= uint32_t((data_[position_ / 8] >> (position_ % 8)) & 1) << bit;
+		}
+		return value;
+	}
+
+private:
+	const uint8_t* data_;
+	uint32_t position_;
+};
+
+static uint8_t Interpolate(uint32_t arg_value0, uint32_t arg_value1, uint32_t arg_weight)
+{
+	return static_cast<uint8_t>(((64 - arg_weight) * arg_value0 + arg_weight * arg_value1 + 32) >> 6);
+}
+
+static void UnpackRGB565(uint16_t arg_packed, uint32_t arg_color[3])
+{
+	uint32_t red = arg_packed >> 11;
+	uint32_t green = (arg_packed >> 5) & 0x3f;
+	uint32_t blue = arg_packed & 0x1f;
+	arg_color[0] = (red << 3) | (red >> 2);
+	arg_color[1] = (green << 2) | (green >> 4);
+	arg_color[2] = (blue << 3) | (blue >> 2);
+}
+
+// Decode a BC1 color block. BC3 color blocks always have four colors, whatever the endpoint order.
+static void DecodeColorBlock(const uint8_t* arg_data, bool arg_bc1, Block& arg_block)
+{
+	uint16_t packed0 = static_cast<uint16_t>(arg_data[0] | (arg_data[1] << 8));
+	uint16_t packed1 = static_cast<uint16_t>(arg_data[2] | (arg_data[3] << 8));
+
+	uint32_t palette[4][4];
+	UnpackRGB565(packed0, palette[0]);
+	UnpackRGB565(packed1, palette[1]);
+	palette[0][3] = 255;
+	palette[1][3] = 255;
+	for (uint32_t channel = 0; channel < 3; ++channel)
+	{
+		if (packed0 > packed1 || !arg_bc1)
+		{
+			palette[2][channel] = (2 * palette[0][channel] + palette[1][channel] + 1) / 3;
+			palette[3][channel] = (palette[0][channel] + 2 * palette[1][channel] + 1) / 3;
+		}
+		else
+		{
+			palette[2][channel] = (palette[0][channel] + palette[1][channel] + 1) / 2;
+			palette[3][channel] = 0;
+		}
+	}
+	palette[2][3] = 255;
+	palette[3][3] = packed0 > packed1 || !arg_bc1 ? 255 : 0;
+
+	for (uint32_t pixel = 0; pixel < 16; ++pixel)
+	{
+		uint32_t index = (arg_data[4 + pixel / 4] >> ((pixel % 4) * 2)) & 3;
+		for (uint32_t channel = 0; channel < 4; ++channel)
+		{
+			arg_block.pixels[pixel][channel] = static_cast<uint8_t>(palette[index][channel]);
+		}
+	}
+}
+
+// Decode a BC4 block into one channel of the pixels.
+static void DecodeBC4(const uint8_t* arg_data, uint32_t arg_channel, Block& arg_block)
+{
+	uint32_t endpoint0 = arg_data[0];
+	uint32_t endpoint1 = arg_data[1];
+
+	uint32_t palette[8] = { endpoint0, endpoint1 };
+	if (endpoint0 > endpoint1)
+	{
+		for (uint32_t i = 2; i < 8; ++i)
+		{
+			palette[i] = ((8 - i) * endpoint0 + (i - 1) * endpoint1 + 3) / 7;
+		}
+	}
+	else
+	{
+		for (uint32_t i = 2; i < 6; ++i)
+		{
+			palette[i] = ((6 - i) * endpoint0 + (i - 1) * endpoint1 + 2) / 5;
+		}
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+
+	uint64_t index_bits = 0;
+	for (uint32_t byte = 0; byte < 6; ++byte)
+	{
+		index_bits |= uint64_t(arg_data[2 + byte]) << (byte * 8);
+	}
+	for (uint32_t pixel = 0; pixel < 16; ++pixel)
+	{
+		arg_block.pixels[pixel][arg_channel] = static_cast<uint8_t>(palette[(index_bits >> (pixel * 3)) & 7]);
+	}
+}
+
+// Decode a BC7 block of one of the modes the compressor writes. Returns the mode, or -1 for other modes.
+static int DecodeBC7(const uint8_t* arg_data, Block& arg_block)
+{
+	BitReader reader(arg_data);
+	int mode = 0;
+	while (mode < 8 && reader.Read(1) == 0)
+	{
+		++mode;
+	}
+
+	if (mode == 6)
+	{
+		uint32_t endpoints[2][4];
+		for (uint32_t channel = 0; channel < 4; ++channel)
+		{
+			endpoints[0][channel] = reader.Read(7);
+			endpoints[1][channel] = reader.Read(7);
+		}
+		uint32_t p_bits[2] = { reader.Read(1), reader.Read(1) };
+		for (uint32_t endpoint = 0; endpoint < 2; ++endpoint)
+		{
+			for (uint32_t channel = 0; channel < 4; ++channel)
+			{
+				endpoints[endpoint][channel] = (endpoints[endpoint][channel] << 1) | p_bits[endpoint];
+			}
+		}
+
+		for (uint32_t pixel = 0; pixel < 16; ++pixel)
+		{
+			uint32_t index = reader.Read(pixel == 0 ? 3 : 4);
+			for (uint32_t channel = 0; channel < 4; ++channel)
+			{
+				arg_block.pixels[pixel][channel] = Interpolate(endpoints[0][channel], endpoints[1][channel], bc7_weights_4[index]);
+			}
+		}
+		return mode;
+	}
+
+	if (mode == 1)
+	{
+		uint32_t partition = reader.Read(6);
+		uint32_t endpoints[2][2][3];
+		for (uint32_t channel = 0; channel < 3; ++channel)
+		{
+			for (uint32_t subset = 0; subset < 2; ++subset)
+			{
+				endpoints[subset][0][channel] = reader.Read(6);
+				endpoints[subset][1][channel] = reader.Read(6);
+			}
+		}
+		uint32_t p_bits[2] = { reader.Read(1), reader.Read(1) };
+		for (uint32_t subset = 0; subset < 2; ++subset)
+		{
+			for (uint32_t endpoint = 0; endpoint < 2; ++endpoint)
+			{
+				for (uint32_t channel = 0; channel < 3; ++channel)
+				{
+					uint32_t value = (endpoints[subset][endpoint][channel] << 1) | p_bits[subset];
+					endpoints[subset][endpoint][channel] = (value << 1) | (value >> 6);
+				}
+			}
+		}
+
+		for (uint32_t pixel = 0; pixel < 16; ++pixel)
+		{
+			uint32_t subset = (bc7_partitions_2[partition] >> pixel) & 1;
+			uint32_t index = reader.Read(pixel == 0 || pixel == bc7_anchors_2[partition] ? 2 : 3);
+			for (uint32_t channel = 0; channel < 3; ++channel)
+			{
+				arg_block.pixels[pixel][channel] = Interpolate(endpoints[subset][0][channel], endpoints[subset][1][channel], bc7_weights_3[index]);
+			}
+			arg_block.pixels[pixel][3] = 255;
+		}
+		return mode;
+	}
+
+	return -1;
+}
+
+static std::vector<uint8_t> Compress(BlockFormat arg_format, CompressionQuality arg_quality, const Block& arg_block)
+{
+	BlockCompressor compressor(arg_format, arg_quality, 1);
+	std::vector<uint8_t> data(compressor.GetBlockSize());
+	compressor.Compress(&arg_block.pixels[0][0], 4, 4, 16, data.data(), compressor.GetBlockSize());
+
+	return data;
+}
+
+// The largest difference of any pixel in the first arg_channel_count channels.
+static int GetMaxError(const Block& arg_a, const Block& arg_b, uint32_t arg_channel_count)
+{
+	int max_error = 0;
+	for (uint32_t pixel = 0; pixel < 16; ++pixel)
+	{
+		for (uint32_t channel = 0; channel < arg_channel_count; ++channel)
+		{
+			int error = std::abs(int(arg_a.pixels[pixel][channel]) - int(arg_b.pixels[pixel][channel]));
+			max_error = error > max_error ? error : max_error;
+		}
+	}
+	return max_error;
+}
+
+/**
+* Colors along a line through RGB, pixel 0 at the start. Blue falls as red and green rise.
+* @param arg_slope The change of red per pixel is three times the slope.
+*/
+static Block MakeGradient(bool arg_reversed, uint32_t arg_slope)
+{
+	Block block;
+	for (uint32_t pixel = 0; pixel < 16; ++pixel)
+	{
+		uint32_t i = arg_reversed ? 15 - pixel : pixel;
+		block.pixels[pixel][0] = static_cast<uint8_t>(16 + 3 * arg_slope * i);
+		block.pixels[pixel][1] = static_cast<uint8_t>(40 + 2 * arg_slope * i);
+		block.pixels[pixel][2] = static_cast<uint8_t>(200 - 2 * arg_slope * i);
+		block.pixels[pixel][3] = 255;
+	}
+	return block;
+}
+
+static uint16_t GetEndpoint(const std::vector<uint8_t>& arg_data, uint32_t arg_endpoint)
+{
+	return static_cast<uint16_t>(arg_data[arg_endpoint * 2] | (arg_data[arg_endpoint * 2 + 1] << 8));
+}
+
+/**
+* Opaque BC1 blocks put the larger endpoint first to select four colors. Four colors are about an
+* eighth of the range of a gradient away from its furthest pixel, plus the RGB565 rounding.
+*/
+static void TestBC1FourColors()
+{
+	const uint32_t slopes[] = { 1, 4 };
+	const int max_errors[] = { 8, 30 };
+	for (uint32_t i = 0; i < 2; ++i)
+	{
+		for (bool reversed : { false, true })
+		{
+			for (CompressionQuality quality : { CompressionQuality::Fast, CompressionQuality::Normal, CompressionQuality::High })
+			{
+				Block block = MakeGradient(reversed, slopes[i]);
+				std::vector<uint8_t> data = Compress(BlockFormat::BC1, quality, block);
+				CHECK(GetEndpoint(data, 0) > GetEndpoint(data, 1));
+
+				Block decoded;
+				DecodeColorBlock(data.data(), true, decoded);
+				CHECK(GetMaxError(block, decoded, 4) <= max_errors[i]);
+			}
+		}
+	}
+}
+
+// BC1 blocks with transparent pixels put the smaller endpoint first to select three colors and transparent black.
+static void TestBC1ThreeColorsWithTransparency()
+{
+	Block block = MakeGradient(false, 1);
+	const uint32_t transparent_pixels[] = { 0, 5, 10, 15 };
+	for (uint32_t pixel : transparent_pixels)
+	{
+		block.pixels[pixel][3] = 0;
+	}
+
+	std::vector<uint8_t> data = Compress(BlockFormat::BC1, CompressionQuality::Normal, block);
+	CHECK(GetEndpoint(data, 0) <= GetEndpoint(data, 1));
+
+	Block decoded;
+	DecodeColorBlock(data.data(), true, decoded);
+	for (uint32_t pixel = 0; pixel < 16; ++pixel)
+	{
+		bool transparent = block.pixels[pixel][3] == 0;
+		CHECK(decoded.pixels[pixel][3] == (transparent ? 0 : 255));
+		if (transparent)
+		{
+			// Copy the pixel over, its color is black in the block.
+			memcpy(block.pixels[pixel], decoded.pixels[pixel], 4);
+		}
+	}
+	CHECK(GetMaxError(block, decoded, 3) <= 12);
+}
+
+// A block without opaque pixels decodes fully transparent.
+static void TestBC1FullyTransparent()
+{
+	Block block = MakeGradient(false, 4);
+	for (uint32_t pixel = 0; pixel < 16; ++pixel)
+	{
+		block.pixels[pixel][3] = 127;
+	}
+
+	std::vector<uint8_t> data = Compress(BlockFormat::BC1, CompressionQuality::Normal, block);
+	Block decoded;
+	DecodeColorBlock(data.data(), true, decoded);
+	for (uint32_t pixel = 0; pixel < 16; ++pixel)
+	{
+		CHECK(decoded.pixels[pixel][3] == 0);
+	}
+}
+
+// A solid color has equal endpoints, which select three colors, but no pixel may use the transparent index.
+static void TestBC1SolidColor()
+{
+	Block block;
+	for (uint32_t pixel = 0; pixel < 16; ++pixel)
+	{
+		const uint8_t color[4] = { 200, 100, 50, 255 };
+		memcpy(block.pixels[pixel], color, 4);
+	}
+
+	std::vector<uint8_t> data = Compress(BlockFormat::BC1, CompressionQuality::Normal, block);
+	Block decoded;
+	DecodeColorBlock(data.data(), true, decoded);
+	CHECK(GetMaxError(block, decoded, 4) <= 4);
+}
+
+// Blocks that hold exact 0 and 255 use the palette of four interpolated values, the others the one of six.
+static void TestBC4Palettes()
+{
+	Block block = { };
+	for (uint32_t pixel = 0; pixel < 16; ++pixel)
+	{
+		block.pixels[pixel][0] = static_cast<uint8_t>(100 + 2 * pixel);
+	}
+	block.pixels[3][0] = 0;
+	block.pixels[12][0] = 255;
+
+	std::vector<uint8_t> data = Compress(BlockFormat::BC4, CompressionQuality::Normal, block);
+	CHECK(data[0] <= data[1]);
+
+	Block decoded = { };
+	DecodeBC4(data.data(), 0, decoded);
+	CHECK(decoded.pixels[3][0] == 0);
+	CHECK(decoded.pixels[12][0] == 255);
+	CHECK(GetMaxError(block, decoded, 1) <= 4);
+
+	for (uint32_t pixel = 0; pixel < 16; ++pixel)
+	{
+		block.pixels[pixel][0] = static_cast<uint8_t>(70 + pixel * 70 / 15);
+	}
+	for (CompressionQuality quality : { CompressionQuality::Fast, CompressionQuality::Normal, CompressionQuality::High })
+	{
+		data = Compress(BlockFormat::BC4, quality, block);
+		CHECK(data[0] > data[1]);
+
+		DecodeBC4(data.data(), 0, decoded);
+		CHECK(GetMaxError(block, decoded, 1) <= 6);
+	}
+}
+
+// BC3 stores alpha like BC4, and BC5 two channels like it. Both are decoded a channel at a time.
+static void TestBC3AndBC5()
+{
+	Block block = MakeGradient(true, 1);
+	for (uint32_t pixel = 0; pixel < 16; ++pixel)
+	{
+		block.pixels[pixel][3] = static_cast<uint8_t>(255 - 4 * pixel);
+	}
+
+	std::vector<uint8_t> data = Compress(BlockFormat::BC3, CompressionQuality::Normal, block);
+	Block decoded;
+	DecodeColorBlock(data.data() + 8, false, decoded);
+	DecodeBC4(data.data(), 3, decoded);
+	CHECK(GetMaxError(block, decoded, 4) <= 8);
+
+	data = Compress(BlockFormat::BC5, CompressionQuality::Normal, block);
+	decoded = Block();
+	DecodeBC4(data.data(), 0, decoded);
+	DecodeBC4(data.data() + 8, 1, decoded);
+	CHECK(GetMaxError(block, decoded, 2) <= 4);
+}
+
+// The first pixel of mode 6 has an implicit 0 high index bit, so the endpoints are swapped when it is near the second one.
+static void TestBC7Mode6()
+{
+	for (bool reversed : { false, true })
+	{
+		Block block = MakeGradient(reversed, 4);
+		for (uint32_t pixel = 0; pixel < 16; ++pixel)
+		{
+			block.pixels[pixel][3] = static_cast<uint8_t>(reversed ? 120 + 8 * pixel : 240 - 8 * pixel);
+		}
+
+		std::vector<uint8_t> data = Compress(BlockFormat::BC7, CompressionQuality::Normal, block);
+		Block decoded;
+		CHECK(DecodeBC7(data.data(), decoded) == 6);
+		CHECK(GetMaxError(block, decoded, 4) <= 4);
+	}
+}
+
+// Opaque blocks with two lines of colors use mode 1 at high quality. The anchor of each subset has
+// an implicit 0 high index bit, so the endpoints of the subset are swapped when it is near the second one.
+static void TestBC7Mode1()
+{
+	// Partition 13 splits the block into its top and bottom halves. The anchor of the bottom half is pixel 15.
+	for (bool reversed : { false, true })
+	{
+		Block block;
+		for (uint32_t pixel = 0; pixel < 16; ++pixel)
+		{
+			// The position on the line of the half, from its anchor.
+			uint32_t i = pixel < 8 ? pixel : 15 - pixel;
+			i = reversed ? 7 - i : i;
+			if (pixel < 8)
+			{
+				const uint8_t color[4] = { static_cast<uint8_t>(200 - 20 * i), static_cast<uint8_t>(20 + 10 * i), 30, 255 };
+				memcpy(block.pixels[pixel], color, 4);
+			}
+			else
+			{
+				const uint8_t color[4] = { 40, static_cast<uint8_t>(230 - 12 * i), static_cast<uint8_t>(30 + 12 * i), 255 };
+				memcpy(block.pixels[pixel], color, 4);
+			}
+		}
+
+		std::vector<uint8_t> data = Compress(BlockFormat::BC7, CompressionQuality::High, block);
+		Block decoded;
+		CHECK(DecodeBC7(data.data(), decoded) == 1);
+		CHECK((data[0] >> 2) == 13);
+		CHECK(GetMaxError(block, decoded, 4) <= 6);
+
+		// Mode 6 fits both halves on one line, which is worse.
+		std::vector<uint8_t> mode6_data = Compress(BlockFormat::BC7, CompressionQuality::Normal, block);
+		Block mode6_decoded;
+		CHECK(DecodeBC7(mode6_data.data(), mode6_decoded) == 6);
+		CHECK(GetMaxError(block, decoded, 4) < GetMaxError(block, mode6_decoded, 4));
+	}
+}
+
+// The anchor of the second subset of every partition is in that subset.
+static void TestBC7AnchorsAreInSecondSubset()
+{
+	for (uint32_t partition = 0; partition < 64; ++partition)
+	{
+		CHECK((bc7_partitions_2[partition] >> bc7_anchors_2[partition]) & 1);
+		CHECK((bc7_partitions_2[partition] & 1) == 0);
+	}
+}
+
+// Blocks on the edge of an image that is not a multiple of 4 repeat the last column and row.
+static void TestPartialBlocks()
+{
+	const uint32_t width = 5;
+	const uint32_t height = 3;
+	uint8_t pixels[height][width][4] = { };
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			pixels[y][x][0] = static_cast<uint8_t>(x * 50 + y * 10);
+		}
+	}
+
+	BlockCompressor compressor(BlockFormat::BC4, CompressionQuality::Normal, 1);
+	CHECK(BlockCompressor::GetBlockCount(width) == 2);
+	CHECK(BlockCompressor::GetBlockCount(height) == 1);
+
+	uint8_t data[16];
+	compressor.Compress(&pixels[0][0][0], width, height, width * 4, data, sizeof(data));
+
+	Block decoded[2] = { };
+	DecodeBC4(data, 0, decoded[0]);
+	DecodeBC4(data + 8, 0, decoded[1]);
+
+	// The second block holds column 4 only, so all its pixels of a row match.
+	for (uint32_t y = 0; y < 4; ++y)
+	{
+		uint32_t source_y = y < height ? y : height - 1;
+		for (uint32_t x = 0; x < 4; ++x)
+		{
+			CHECK(std::abs(int(decoded[1].pixels[y * 4 + x][0]) - int(pixels[source_y][4][0])) <= 2);
+			CHECK(std::abs(int(decoded[0].pixels[y * 4 + x][0]) - int(pixels[source_y][x][0])) <= 12);
+		}
+	}
+}
+
+static void TestFormats()
+{
+	CHECK(BlockCompressor(BlockFormat::BC1).GetFormat() == DXGI_FORMAT_BC1_UNORM);
+	CHECK(BlockCompressor(BlockFormat::BC3).GetFormat() == DXGI_FORMAT_BC3_UNORM);
+	CHECK(BlockCompressor(BlockFormat::BC4).GetFormat() == DXGI_FORMAT_BC4_UNORM);
+	CHECK(BlockCompressor(BlockFormat::BC5).GetFormat() == DXGI_FORMAT_BC5_UNORM);
+	CHECK(BlockCompressor(BlockFormat::BC7).GetFormat() == DXGI_FORMAT_BC7_UNORM);
+	CHECK(BlockCompressor(BlockFormat::BC1).GetBlockSize() == 8);
+	CHECK(BlockCompressor(BlockFormat::BC4).GetBlockSize() == 8);
+	CHECK(BlockCompressor(BlockFormat::BC7).GetBlockSize() == 16);
+}
+
+int main()
+{
+	TestBC1FourColors();
+	TestBC1ThreeColorsWithTransparency();
+	TestBC1FullyTransparent();
+	TestBC1SolidColor();
+	TestBC4Palettes();
+	TestBC3AndBC5();
+	TestBC7Mode6();
+	TestBC7Mode1();
+	TestBC7AnchorsAreInSecondSubset();
+	TestPartialBlocks();
+	TestFormats();
+
+	return test_failure_count;
+}
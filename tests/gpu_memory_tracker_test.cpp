@@ -0,0 +1,91 @@
+#include <gpu_memory_tracker.h>
+
+#include "test.h"
+
+#include <thread>
+#include <vector>
+
+// A stand-in for the objects registered with the tracker, which only uses their addresses.
+class TestObject : public ID3D12Object
+{
+public:
+	virtual HRESULT QueryInterface(REFIID, void**) override { return E_FAIL; }
+	virtual ULONG AddRef() override { return 1; }
+	virtual ULONG Release() override { return 1; }
+};
+
+// Placed resources count towards their tag, but not towards the totals that contain their heap.
+static void TestPlacedResources()
+{
+	GpuMemoryTracker tracker;
+	TestObject heap, texture, buffer;
+
+	TRACK_GPU_MEMORY(tracker, &heap, "Heap", 1024);
+	TRACK_PLACED_GPU_MEMORY(tracker, &texture, "Texture", 512);
+	TRACK_PLACED_GPU_MEMORY(tracker, &buffer, "Buffer", 256);
+	CHECK(tracker.GetLiveBytes() == 1024);
+	CHECK(tracker.GetPeakBytes() == 1024);
+
+	std::vector<GpuMemoryTracker::TagStats> tag_stats = tracker.GetTagStats();
+	CHECK(tag_stats.size() == 3);
+	CHECK(tag_stats[0].tag == "Buffer" && tag_stats[0].live_bytes == 256);
+	CHECK(tag_stats[1].tag == "Heap" && tag_stats[1].live_bytes == 1024);
+	CHECK(tag_stats[2].tag == "Texture" && tag_stats[2].live_bytes == 512);
+
+	CHECK(tracker.Unregister(&texture));
+	CHECK(tracker.GetLiveBytes() == 1024);
+	CHECK(tracker.Unregister(&heap));
+	CHECK(tracker.GetLiveBytes() == 0);
+	CHECK(!tracker.Unregister(&heap));
+
+	// The buffer is still registered.
+	std::string leak_report = tracker.GetLeakReport();
+	CHECK(leak_report.find("Buffer, 256 bytes") != std::string::npos);
+	CHECK(leak_report.find("Texture") == std::string::npos);
+}
+
+// Objects are registered from several threads at once.
+static void TestThreads()
+{
+	const int thread_count = 4;
+	const int object_count = 1000;
+
+	GpuMemoryTracker tracker;
+	std::vector<TestObject> objects(thread_count * object_count);
+
+	std::vector<std::thread> threads;
+	for (int i = 0; i < thread_count; ++i)
+	{
+		threads.emplace_back([&tracker, &objects, i, object_count]()
+		{
+			for (int j = 0; j < object_count; ++j)
+			{
+				TRACK_GPU_MEMORY(tracker, &objects[i * object_count + j], i % 2 ? "Odd" : "Even", 16);
+			}
+			for (int j = 0; j < object_count; j += 2)
+			{
+				tracker.Unregister(&objects[i * object_count + j]);
+			}
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	CHECK(tracker.GetLiveBytes() == UINT64(thread_count * object_count / 2) * 16);
+	CHECK(tracker.GetPeakBytes() >= tracker.GetLiveBytes());
+
+	std::vector<GpuMemoryTracker::TagStats> tag_stats = tracker.GetTagStats();
+	CHECK(tag_stats.size() == 2);
+	CHECK(tag_stats[0].live_count == size_t(thread_count * object_count / 4));
+	CHECK(tag_stats[1].live_count == size_t(thread_count * object_count / 4));
+}
+
+int main()
+{
+	TestPlacedResources();
+	TestThreads();
+
+	return test_failure_count;
+}
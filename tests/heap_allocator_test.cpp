@@ -0,0 +1,101 @@
+#include <heap_allocator.h>
+
+#include "test.h"
+
+#include <memory>
+
+static D3D12_RESOURCE_DESC BufferDesc(UINT64 arg_size)
+{
+	D3D12_RESOURCE_DESC desc = { };
+	desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+	desc.Width = arg_size;
+	desc.Height = 1;
+	desc.DepthOrArraySize = 1;
+	desc.MipLevels = 1;
+	desc.SampleDesc.Count = 1;
+	desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+	return desc;
+}
+
+// A failed placement must return its range to the block.
+static void TestFailedPlacementInBlock()
+{
+	auto device = std::make_shared<SimulatedHeapAllocatorDevice>();
+	HeapAllocator allocator(device, D3D12_HEAP_TYPE_DEFAULT, 1024 * 1024);
+
+	HeapAllocation first = allocator.CreateResource(BufferDesc(65536), D3D12_RESOURCE_STATE_COMMON);
+	CHECK(first.IsValid());
+
+	device->SetPlacementFails(true);
+	CHECK_THROWS(allocator.CreateResource(BufferDesc(65536), D3D12_RESOURCE_STATE_COMMON));
+	device->SetPlacementFails(false);
+
+	HeapAllocator::Stats stats = allocator.GetStats();
+	CHECK(stats.heap_count == 1);
+	CHECK(stats.allocation_count == 1);
+	CHECK(stats.allocated_bytes == 65536);
+
+	// The whole remainder of the block is still free.
+	HeapAllocation rest = allocator.CreateResource(BufferDesc(1024 * 1024 - 65536), D3D12_RESOURCE_STATE_COMMON);
+	CHECK(rest.IsValid());
+	CHECK(allocator.GetStats().heap_count == 1);
+
+	allocator.Free(rest);
+	allocator.Free(first);
+	CHECK(allocator.GetStats().allocated_bytes == 0);
+}
+
+// A failed placement in a dedicated heap must release the heap and its residency entry.
+static void TestFailedPlacementInDedicatedHeap()
+{
+	auto device = std::make_shared<SimulatedHeapAllocatorDevice>();
+	ResidencyManager residency_manager(std::make_shared<SimulatedResidencyDevice>(UINT64_MAX));
+	HeapAllocator allocator(device, D3D12_HEAP_TYPE_DEFAULT, 1024 * 1024, &residency_manager);
+
+	device->SetPlacementFails(true);
+	CHECK_THROWS(allocator.CreateResource(BufferDesc(4 * 1024 * 1024), D3D12_RESOURCE_STATE_COMMON));
+	device->SetPlacementFails(false);
+
+	CHECK(device->GetHeapCount() == 1);
+	CHECK(allocator.GetStats().heap_count == 0);
+	CHECK(residency_manager.GetStats().tracked_count == 0);
+
+	HeapAllocation allocation = allocator.CreateResource(BufferDesc(4 * 1024 * 1024), D3D12_RESOURCE_STATE_COMMON);
+	CHECK(allocation.IsValid());
+	CHECK(allocator.GetStats().heap_count == 1);
+	CHECK(residency_manager.GetStats().tracked_count == 1);
+
+	allocator.Free(allocation);
+	CHECK(allocator.GetStats().heap_count == 0);
+	CHECK(residency_manager.GetStats().tracked_count == 0);
+}
+
+// A copy of a freed allocation must not refer to the dedicated heap that reuses its block slot.
+static void TestStaleAllocationAfterSlotReuse()
+{
+	auto device = std::make_shared<SimulatedHeapAllocatorDevice>();
+	HeapAllocator allocator(device, D3D12_HEAP_TYPE_DEFAULT, 1024 * 1024);
+
+	HeapAllocation first = allocator.CreateResource(BufferDesc(4 * 1024 * 1024), D3D12_RESOURCE_STATE_COMMON);
+	HeapAllocation stale = first;
+	allocator.Free(first);
+	CHECK(!allocator.IsValid(stale));
+
+	HeapAllocation second = allocator.CreateResource(BufferDesc(4 * 1024 * 1024), D3D12_RESOURCE_STATE_COMMON);
+	CHECK(second.block == stale.block);
+	CHECK(allocator.IsValid(second));
+	CHECK(!allocator.IsValid(stale));
+
+	allocator.Free(second);
+	CHECK(allocator.GetStats().heap_count == 0);
+}
+
+int main()
+{
+	TestFailedPlacementInBlock();
+	TestFailedPlacementInDedicatedHeap();
+	TestStaleAllocationAfterSlotReuse();
+
+	return test_failure_count;
+}
@@ -0,0 +1,201 @@
+#include <pipeline_cache.h>
+
+#include "test.h"
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+static const char* const cache_path = "pipeline_cache_test.bin";
+
+// A subobject as laid out by the D3DX12 stream helpers.
+template<typename T>
+struct alignas(void*) Subobject
+{
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE type;
+	T desc;
+};
+
+struct Stream
+{
+	Subobject<ID3D12RootSignature*> root_signature;
+	Subobject<D3D12_SHADER_BYTECODE> vertex_shader;
+};
+
+static const uint8_t shader[] = { 1, 2, 3, 4 };
+
+// Create the root signature and a stream that uses it. The simulated device creates null root signatures.
+static Stream MakeStream(PipelineCache& arg_cache)
+{
+	D3D12_VERSIONED_ROOT_SIGNATURE_DESC desc = { };
+	desc.Version = D3D_ROOT_SIGNATURE_VERSION_1_1;
+	desc.Desc_1_1.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+
+	Stream stream = { };
+	stream.root_signature.type = D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_ROOT_SIGNATURE;
+	stream.root_signature.desc = arg_cache.GetRootSignature(desc, D3D_ROOT_SIGNATURE_VERSION_1_1).Get();
+	stream.vertex_shader.type = D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VS;
+	stream.vertex_shader.desc = { shader, sizeof(shader) };
+
+	return stream;
+}
+
+static D3D12_PIPELINE_STATE_STREAM_DESC MakeDesc(Stream& arg_stream)
+{
+	return { sizeof(arg_stream), &arg_stream };
+}
+
+static bool FileExists(const char* arg_path)
+{
+	return static_cast<bool>(std::ifstream(arg_path));
+}
+
+// A pipeline state is compiled once. The simulated device creates null pipeline states, so later
+// requests are counted as memory hits without being returned early.
+static void TestMissCompilesOnce()
+{
+	auto device = std::make_shared<SimulatedPipelineCacheDevice>(1);
+	PipelineCache cache(device, "");
+
+	Stream stream = MakeStream(cache);
+	cache.GetPipelineState(MakeDesc(stream));
+	cache.GetPipelineState(MakeDesc(stream));
+
+	PipelineCache::Stats stats = cache.GetStats();
+	CHECK(stats.pipeline_state_count == 1);
+	CHECK(stats.compile_count == 1);
+	CHECK(stats.memory_hit_count > 0);
+	CHECK(stats.disk_hit_count == 0);
+	CHECK(device->GetCompiledCount() == 1);
+}
+
+// Root signatures with the same serialized description are created once.
+static void TestRootSignaturesAreShared()
+{
+	auto device = std::make_shared<SimulatedPipelineCacheDevice>(1);
+	PipelineCache cache(device, "");
+
+	D3D12_VERSIONED_ROOT_SIGNATURE_DESC desc = { };
+	desc.Version = D3D_ROOT_SIGNATURE_VERSION_1_1;
+	cache.GetRootSignature(desc, D3D_ROOT_SIGNATURE_VERSION_1_1);
+	cache.GetRootSignature(desc, D3D_ROOT_SIGNATURE_VERSION_1_1);
+	CHECK(cache.GetStats().root_signature_count == 1);
+	CHECK(cache.GetStats().memory_hit_count == 1);
+
+	desc.Desc_1_1.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+	cache.GetRootSignature(desc, D3D_ROOT_SIGNATURE_VERSION_1_1);
+	CHECK(cache.GetStats().root_signature_count == 2);
+}
+
+// Blobs saved by one launch are used by the next instead of compiling.
+static void TestStoredBlobIsHit()
+{
+	std::remove(cache_path);
+
+	auto device = std::make_shared<SimulatedPipelineCacheDevice>(1);
+	{
+		PipelineCache cache(device, cache_path);
+		Stream stream = MakeStream(cache);
+		cache.GetPipelineState(MakeDesc(stream));
+	}
+	CHECK(FileExists(cache_path));
+
+	PipelineCache cache(device, cache_path);
+	Stream stream = MakeStream(cache);
+	cache.GetPipelineState(MakeDesc(stream));
+
+	PipelineCache::Stats stats = cache.GetStats();
+	CHECK(stats.disk_hit_count == 1);
+	CHECK(stats.compile_count == 0);
+	CHECK(device->GetCompiledCount() == 1);
+	CHECK(device->GetCachedCount() == 1);
+
+	std::remove(cache_path);
+}
+
+// A blob the driver rejects is compiled again, and the new blob replaces it.
+static void TestDriverVersionMismatchInvalidatesBlob()
+{
+	std::remove(cache_path);
+
+	{
+		auto device = std::make_shared<SimulatedPipelineCacheDevice>(1);
+		PipelineCache cache(device, cache_path);
+		Stream stream = MakeStream(cache);
+		cache.GetPipelineState(MakeDesc(stream));
+	}
+
+	// The file was written for driver 1, but the driver changes before the pipeline state is created.
+	{
+		auto device = std::make_shared<SimulatedPipelineCacheDevice>(1);
+		PipelineCache cache(device, cache_path);
+		device->SetDriverVersion(2);
+
+		Stream stream = MakeStream(cache);
+		cache.GetPipelineState(MakeDesc(stream));
+
+		PipelineCache::Stats stats = cache.GetStats();
+		CHECK(stats.disk_hit_count == 0);
+		CHECK(stats.compile_count == 1);
+		CHECK(device->GetCachedCount() == 0);
+		CHECK(device->GetCompiledCount() == 1);
+	}
+
+	// The replaced blob is accepted by driver 2.
+	{
+		auto device = std::make_shared<SimulatedPipelineCacheDevice>(1);
+		PipelineCache cache(device, cache_path);
+		device->SetDriverVersion(2);
+
+		Stream stream = MakeStream(cache);
+		cache.GetPipelineState(MakeDesc(stream));
+
+		CHECK(cache.GetStats().disk_hit_count == 1);
+		CHECK(device->GetCachedCount() == 1);
+	}
+
+	// A file written for another driver is not loaded at all.
+	{
+		auto device = std::make_shared<SimulatedPipelineCacheDevice>(3);
+		PipelineCache cache(device, cache_path);
+
+		Stream stream = MakeStream(cache);
+		cache.GetPipelineState(MakeDesc(stream));
+
+		CHECK(cache.GetStats().disk_hit_count == 0);
+		CHECK(cache.GetStats().compile_count == 1);
+	}
+
+	std::remove(cache_path);
+}
+
+// Without a driver to match them to, blobs are kept in memory and never written.
+static void TestUnknownDriverKeepsBlobsInMemory()
+{
+	std::remove(cache_path);
+
+	auto device = std::make_shared<SimulatedPipelineCacheDevice>(0);
+	{
+		PipelineCache cache(device, cache_path);
+		Stream stream = MakeStream(cache);
+		cache.GetPipelineState(MakeDesc(stream));
+		cache.GetPipelineState(MakeDesc(stream));
+
+		CHECK(cache.GetStats().compile_count == 1);
+		CHECK(device->GetCompiledCount() == 1);
+		CHECK(!cache.Save());
+	}
+	CHECK(!FileExists(cache_path));
+}
+
+int main()
+{
+	TestMissCompilesOnce();
+	TestRootSignaturesAreShared();
+	TestStoredBlobIsHit();
+	TestDriverVersionMismatchInvalidatesBlob();
+	TestUnknownDriverKeepsBlobsInMemory();
+
+	return test_failure_count;
+}
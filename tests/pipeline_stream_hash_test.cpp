@@ -0,0 +1,177 @@
+#include <pipeline_stream_hash.h>
+
+#include "test.h"
+
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// A subobject as laid out by the D3DX12 stream helpers.
+template<typename T>
+struct alignas(void*) Subobject
+{
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE type;
+	T desc;
+};
+
+struct Stream
+{
+	Subobject<ID3D12RootSignature*> root_signature;
+	Subobject<D3D12_INPUT_LAYOUT_DESC> input_layout;
+	Subobject<D3D12_SHADER_BYTECODE> vertex_shader;
+	Subobject<D3D12_DEPTH_STENCIL_DESC1> depth_stencil;
+};
+
+// Root signatures are only used as keys, they are never called.
+static ID3D12RootSignature* const root_signature_a = reinterpret_cast<ID3D12RootSignature*>(0x100);
+static ID3D12RootSignature* const root_signature_b = reinterpret_cast<ID3D12RootSignature*>(0x200);
+
+static Stream MakeStream(ID3D12RootSignature* arg_root_signature, const D3D12_INPUT_ELEMENT_DESC* arg_element, const std::vector<uint8_t>& arg_shader)
+{
+	Stream stream;
+	memset(&stream, 0xcd, sizeof(stream));
+
+	stream.root_signature.type = D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_ROOT_SIGNATURE;
+	stream.root_signature.desc = arg_root_signature;
+	stream.input_layout.type = D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_INPUT_LAYOUT;
+	stream.input_layout.desc = { arg_element, 1 };
+	stream.vertex_shader.type = D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VS;
+	stream.vertex_shader.desc = { arg_shader.data(), arg_shader.size() };
+
+	// Written field by field, so the padding keeps the pattern above.
+	stream.depth_stencil.type = D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL1;
+	stream.depth_stencil.desc.DepthEnable = TRUE;
+	stream.depth_stencil.desc.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
+	stream.depth_stencil.desc.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
+	stream.depth_stencil.desc.StencilEnable = FALSE;
+	stream.depth_stencil.desc.StencilReadMask = 0xff;
+	stream.depth_stencil.desc.StencilWriteMask = 0xff;
+	stream.depth_stencil.desc.FrontFace = { D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_COMPARISON_FUNC_ALWAYS };
+	stream.depth_stencil.desc.BackFace = stream.depth_stencil.desc.FrontFace;
+	stream.depth_stencil.desc.DepthBoundsTestEnable = FALSE;
+
+	return stream;
+}
+
+static D3D12_INPUT_ELEMENT_DESC MakeElement(const char* arg_semantic_name)
+{
+	return { arg_semantic_name, 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 };
+}
+
+template<typename T>
+static HRESULT Hash(T& arg_stream, const std::unordered_map<ID3D12RootSignature*, uint64_t>& arg_root_signature_hashes, uint64_t& arg_hash)
+{
+	D3D12_PIPELINE_STATE_STREAM_DESC desc = { sizeof(arg_stream), &arg_stream };
+	return HashPipelineStream(desc, arg_root_signature_hashes, arg_hash);
+}
+
+// Streams are hashed by their contents, not by the addresses they point to or their padding.
+static void TestHashesContents()
+{
+	std::unordered_map<ID3D12RootSignature*, uint64_t> root_signature_hashes = { { root_signature_a, 1 }, { root_signature_b, 1 } };
+
+	std::string name_a = "POSITION";
+	std::string name_b = "POSITION";
+	D3D12_INPUT_ELEMENT_DESC element_a = MakeElement(name_a.c_str());
+	D3D12_INPUT_ELEMENT_DESC element_b = MakeElement(name_b.c_str());
+	std::vector<uint8_t> shader_a = { 1, 2, 3, 4 };
+	std::vector<uint8_t> shader_b = shader_a;
+
+	Stream stream_a = MakeStream(root_signature_a, &element_a, shader_a);
+	Stream stream_b = MakeStream(root_signature_b, &element_b, shader_b);
+	// Change the padding between the stencil masks and the stencil operations.
+	memset(&stream_b.depth_stencil.desc.StencilWriteMask + 1, 0x00, 2);
+
+	uint64_t hash_a = 0;
+	uint64_t hash_b = 0;
+	CHECK(SUCCEEDED(Hash(stream_a, root_signature_hashes, hash_a)));
+	CHECK(SUCCEEDED(Hash(stream_b, root_signature_hashes, hash_b)));
+	CHECK(hash_a == hash_b);
+
+	shader_b[3] = 5;
+	CHECK(SUCCEEDED(Hash(stream_b, root_signature_hashes, hash_b)));
+	CHECK(hash_a != hash_b);
+
+	shader_b[3] = 4;
+	name_b[0] = 'Q';
+	CHECK(SUCCEEDED(Hash(stream_b, root_signature_hashes, hash_b)));
+	CHECK(hash_a != hash_b);
+
+	name_b[0] = 'P';
+	root_signature_hashes[root_signature_b] = 2;
+	CHECK(SUCCEEDED(Hash(stream_b, root_signature_hashes, hash_b)));
+	CHECK(hash_a != hash_b);
+}
+
+// Both depth stencil versions describe the same pipeline, so they hash the same.
+static void TestDepthStencilVersionsHashTheSame()
+{
+	struct Stream0
+	{
+		Subobject<D3D12_DEPTH_STENCIL_DESC> depth_stencil;
+	};
+
+	struct Stream1
+	{
+		Subobject<D3D12_DEPTH_STENCIL_DESC1> depth_stencil;
+	};
+
+	Stream0 stream0 = { };
+	stream0.depth_stencil.type = D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL;
+	stream0.depth_stencil.desc.DepthEnable = TRUE;
+	stream0.depth_stencil.desc.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
+
+	Stream1 stream1 = { };
+	stream1.depth_stencil.type = D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL1;
+	stream1.depth_stencil.desc.DepthEnable = TRUE;
+	stream1.depth_stencil.desc.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
+
+	std::unordered_map<ID3D12RootSignature*, uint64_t> root_signature_hashes;
+	uint64_t hash0 = 0;
+	uint64_t hash1 = 0;
+	CHECK(SUCCEEDED(Hash(stream0, root_signature_hashes, hash0)));
+	CHECK(SUCCEEDED(Hash(stream1, root_signature_hashes, hash1)));
+	CHECK(hash0 == hash1);
+
+	stream1.depth_stencil.desc.DepthBoundsTestEnable = TRUE;
+	CHECK(SUCCEEDED(Hash(stream1, root_signature_hashes, hash1)));
+	CHECK(hash0 != hash1);
+}
+
+// Streams that can not be hashed are rejected rather than hashed partially.
+static void TestRejectsInvalidStreams()
+{
+	std::unordered_map<ID3D12RootSignature*, uint64_t> root_signature_hashes = { { root_signature_a, 1 } };
+
+	D3D12_INPUT_ELEMENT_DESC element = MakeElement("POSITION");
+	std::vector<uint8_t> shader = { 1, 2, 3, 4 };
+	uint64_t hash = 0;
+
+	// A root signature the cache did not create.
+	Stream stream = MakeStream(root_signature_b, &element, shader);
+	CHECK(Hash(stream, root_signature_hashes, hash) == E_INVALIDARG);
+
+	// A truncated stream.
+	stream = MakeStream(root_signature_a, &element, shader);
+	D3D12_PIPELINE_STATE_STREAM_DESC desc = { sizeof(stream) - 1, &stream };
+	CHECK(HashPipelineStream(desc, root_signature_hashes, hash) == E_INVALIDARG);
+
+	// A cached PSO.
+	struct CachedStream
+	{
+		Subobject<D3D12_CACHED_PIPELINE_STATE> cached_pso;
+	};
+	CachedStream cached_stream = { };
+	cached_stream.cached_pso.type = D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CACHED_PSO;
+	CHECK(Hash(cached_stream, root_signature_hashes, hash) == E_INVALIDARG);
+}
+
+int main()
+{
+	TestHashesContents();
+	TestDepthStencilVersionsHashTheSame();
+	TestRejectsInvalidStreams();
+
+	return test_failure_count;
+}
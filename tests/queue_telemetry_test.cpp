@@ -0,0 +1,180 @@
+#include <queue_telemetry.h>
+
+#include "test.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static const char* const csv_path = "queue_telemetry_test.csv";
+
+// Submit, wait on and complete one fence value. Only the CPU wait is known ahead; the GPU
+// latency is measured with the clock.
+static void AddSample(QueueTelemetry& arg_telemetry, uint64_t arg_fence_value, uint32_t arg_cpu_wait_us)
+{
+	arg_telemetry.OnSubmit(arg_fence_value);
+	arg_telemetry.OnCpuWait(arg_fence_value, std::chrono::microseconds(arg_cpu_wait_us));
+	arg_telemetry.OnCompleted(arg_fence_value);
+}
+
+static uint32_t GetTotal(const QueueTelemetry::Histogram& arg_histogram)
+{
+	uint32_t total = 0;
+	for (uint32_t count : arg_histogram)
+	{
+		total += count;
+	}
+
+	return total;
+}
+
+// Buckets are powers of two in microseconds, the last one is open ended.
+static void TestBuckets()
+{
+	CHECK(QueueTelemetry::GetBucket(0.0) == 0);
+	CHECK(QueueTelemetry::GetBucket(0.5) == 0);
+	CHECK(QueueTelemetry::GetBucket(1.0) == 1);
+	CHECK(QueueTelemetry::GetBucket(3.0) == 2);
+	CHECK(QueueTelemetry::GetBucket(4.0) == 3);
+	CHECK(QueueTelemetry::GetBucket(1e12) == QueueTelemetry::bucket_count_ - 1);
+
+	QueueTelemetry telemetry;
+	AddSample(telemetry, 1, 0);
+	AddSample(telemetry, 2, 1);
+	AddSample(telemetry, 3, 3);
+	AddSample(telemetry, 4, 3);
+	AddSample(telemetry, 5, 1000);
+
+	const QueueTelemetry::Histogram& histogram = telemetry.GetHistogram(QueueTelemetry::CpuWait);
+	CHECK(histogram[0] == 1);
+	CHECK(histogram[1] == 1);
+	CHECK(histogram[2] == 2);
+	CHECK(histogram[10] == 1);
+	CHECK(GetTotal(histogram) == 5);
+	CHECK(GetTotal(telemetry.GetHistogram(QueueTelemetry::GpuLatency)) == 5);
+}
+
+// Percentiles pick the nearest sample, whatever order the samples arrived in.
+static void TestPercentiles()
+{
+	QueueTelemetry telemetry(101);
+	CHECK(telemetry.GetPercentile(QueueTelemetry::CpuWait, 50.0) == 0.0);
+
+	// The waits 0 to 100 microseconds in a shuffled order.
+	for (uint32_t i = 0; i <= 100; ++i)
+	{
+		AddSample(telemetry, i + 1, (i * 37) % 101);
+	}
+
+	CHECK(telemetry.GetPercentile(QueueTelemetry::CpuWait, 0.0) == 0.0);
+	CHECK(telemetry.GetPercentile(QueueTelemetry::CpuWait, 50.0) == 50.0);
+	CHECK(telemetry.GetPercentile(QueueTelemetry::CpuWait, 99.0) == 99.0);
+	CHECK(telemetry.GetPercentile(QueueTelemetry::CpuWait, 100.0) == 100.0);
+	CHECK(telemetry.GetPercentile(QueueTelemetry::CpuWait, 200.0) == 100.0);
+}
+
+// Only the most recent samples are kept, and evicted ones leave the histograms.
+static void TestWindowEviction()
+{
+	QueueTelemetry telemetry(4);
+	AddSample(telemetry, 1, 1000);
+	AddSample(telemetry, 2, 1000);
+	for (uint64_t fence_value = 3; fence_value <= 6; ++fence_value)
+	{
+		AddSample(telemetry, fence_value, 2);
+	}
+
+	const std::deque<QueueTelemetry::Sample>& samples = telemetry.GetSamples();
+	CHECK(samples.size() == 4);
+	CHECK(samples.front().fence_value == 3);
+	CHECK(samples.back().fence_value == 6);
+
+	const QueueTelemetry::Histogram& histogram = telemetry.GetHistogram(QueueTelemetry::CpuWait);
+	CHECK(histogram[2] == 4);
+	CHECK(histogram[10] == 0);
+	CHECK(GetTotal(histogram) == 4);
+	CHECK(telemetry.GetPercentile(QueueTelemetry::CpuWait, 100.0) == 2.0);
+}
+
+// Submissions complete in fence order, and waits are added to the submission they were for.
+static void TestCompletesInFenceOrder()
+{
+	QueueTelemetry telemetry;
+	telemetry.OnSubmit(1);
+	telemetry.OnSubmit(2);
+	telemetry.OnCpuWait(2, std::chrono::microseconds(5));
+	telemetry.OnCpuWait(2, std::chrono::microseconds(3));
+	telemetry.OnCompleted(0);
+	CHECK(telemetry.GetSamples().empty());
+
+	telemetry.OnCompleted(2);
+	const std::deque<QueueTelemetry::Sample>& samples = telemetry.GetSamples();
+	CHECK(samples.size() == 2);
+	CHECK(samples[0].fence_value == 1);
+	CHECK(samples[0].cpu_wait_us == 0.0);
+	CHECK(samples[1].fence_value == 2);
+	CHECK(samples[1].cpu_wait_us == 8.0);
+	CHECK(samples[0].submit_time_us <= samples[1].submit_time_us);
+}
+
+// The CSV has a header and a row per sample in the window.
+static void TestDumpCsv()
+{
+	std::remove(csv_path);
+
+	QueueTelemetry telemetry(2);
+	AddSample(telemetry, 1, 7);
+	AddSample(telemetry, 2, 8);
+	AddSample(telemetry, 3, 9);
+	CHECK(telemetry.DumpCsv(csv_path));
+
+	std::ifstream file(csv_path);
+	std::vector<std::string> lines;
+	std::string line;
+	while (std::getline(file, line))
+	{
+		lines.push_back(line);
+	}
+
+	CHECK(lines.size() == 3);
+	if (lines.size() == 3)
+	{
+		CHECK(lines[0] == "fence_value,submit_time_us,gpu_latency_us,cpu_wait_us");
+
+		for (size_t i = 1; i < lines.size(); ++i)
+		{
+			std::vector<std::string> fields;
+			std::stringstream row(lines[i]);
+			std::string field;
+			while (std::getline(row, field, ','))
+			{
+				fields.push_back(field);
+			}
+
+			CHECK(fields.size() == 4);
+			if (fields.size() == 4)
+			{
+				CHECK(fields[0] == std::to_string(i + 1));
+				CHECK(fields[3] == std::to_string(i + 7));
+			}
+		}
+	}
+
+	CHECK(!telemetry.DumpCsv("missing_directory/queue_telemetry_test.csv"));
+
+	file.close();
+	std::remove(csv_path);
+}
+
+int main()
+{
+	TestBuckets();
+	TestPercentiles();
+	TestWindowEviction();
+	TestCompletesInFenceOrder();
+	TestDumpCsv();
+
+	return test_failure_count;
+}
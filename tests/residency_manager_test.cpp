@@ -0,0 +1,161 @@
+#include <residency_manager.h>
+
+#include "test.h"
+
+#include <memory>
+
+static ResidencyManager::FenceValues Completed(uint64_t arg_direct, uint64_t arg_copy)
+{
+	ResidencyManager::FenceValues fence_values = { };
+	fence_values[ResidencyManager::DIRECT_QUEUE] = arg_direct;
+	fence_values[ResidencyManager::COPY_QUEUE] = arg_copy;
+
+	return fence_values;
+}
+
+// Objects the GPU has finished with are evicted least recently used first.
+static void TestEvictsLeastRecentlyUsed()
+{
+	auto device = std::make_shared<SimulatedResidencyDevice>(300);
+	ResidencyManager manager(device);
+
+	ResidencyManager::Handle a = manager.Track(nullptr, 100);
+	ResidencyManager::Handle b = manager.Track(nullptr, 100);
+	ResidencyManager::Handle c = manager.Track(nullptr, 100);
+
+	manager.MarkUsed(&b, 1, ResidencyManager::DIRECT_QUEUE, 1);
+	manager.MarkUsed(&a, 1, ResidencyManager::DIRECT_QUEUE, 2);
+	manager.MarkUsed(&c, 1, ResidencyManager::DIRECT_QUEUE, 3);
+
+	device->SetBudget(200);
+	CHECK(manager.Trim(Completed(3, 0)));
+	CHECK(!manager.IsResident(b));
+	CHECK(manager.IsResident(a));
+	CHECK(manager.IsResident(c));
+	CHECK(device->GetEvictedCount() == 1);
+
+	// Paging b back in evicts a, the least recently used object that is not requested.
+	CHECK(manager.MakeResident(&b, 1, Completed(3, 0)));
+	CHECK(manager.IsResident(b));
+	CHECK(!manager.IsResident(a));
+	CHECK(manager.IsResident(c));
+	CHECK(device->GetMadeResidentCount() == 1);
+
+	ResidencyManager::Stats stats = manager.GetStats();
+	CHECK(stats.resident_count == 2);
+	CHECK(stats.resident_bytes == 200);
+	CHECK(stats.evicted_count == 2);
+}
+
+// Objects still in use on the direct queue are not evicted.
+static void TestKeepsObjectsInUse()
+{
+	auto device = std::make_shared<SimulatedResidencyDevice>(200);
+	ResidencyManager manager(device);
+
+	ResidencyManager::Handle a = manager.Track(nullptr, 100);
+	ResidencyManager::Handle b = manager.Track(nullptr, 100);
+	manager.MarkUsed(&a, 1, ResidencyManager::DIRECT_QUEUE, 1);
+	manager.MarkUsed(&b, 1, ResidencyManager::DIRECT_QUEUE, 2);
+
+	device->SetBudget(100);
+	CHECK(!manager.Trim(Completed(0, 0)));
+	CHECK(manager.IsResident(a));
+	CHECK(manager.IsResident(b));
+	CHECK(manager.GetStats().over_budget_count == 1);
+
+	CHECK(manager.Trim(Completed(1, 0)));
+	CHECK(!manager.IsResident(a));
+	CHECK(manager.IsResident(b));
+}
+
+// A heap written on the copy queue stays resident until the copy finishes, even when the
+// direct queue has finished with every object.
+static void TestKeepsObjectsInUseOnCopyQueue()
+{
+	auto device = std::make_shared<SimulatedResidencyDevice>(300);
+	ResidencyManager manager(device);
+
+	ResidencyManager::Handle uploaded = manager.Track(nullptr, 100);
+	ResidencyManager::Handle b = manager.Track(nullptr, 100);
+	ResidencyManager::Handle c = manager.Track(nullptr, 100);
+
+	manager.MarkUsed(&uploaded, 1, ResidencyManager::COPY_QUEUE, 5);
+	manager.MarkUsed(&b, 1, ResidencyManager::DIRECT_QUEUE, 1);
+	manager.MarkUsed(&c, 1, ResidencyManager::DIRECT_QUEUE, 2);
+
+	// The uploaded heap is the least recently used, but the copy is still running.
+	device->SetBudget(200);
+	CHECK(manager.Trim(Completed(2, 4)));
+	CHECK(manager.IsResident(uploaded));
+	CHECK(!manager.IsResident(b));
+	CHECK(manager.IsResident(c));
+
+	device->SetBudget(100);
+	CHECK(manager.Trim(Completed(2, 5)));
+	CHECK(!manager.IsResident(uploaded));
+	CHECK(manager.IsResident(c));
+}
+
+// An object used on both queues is only evicted once both have finished with it.
+static void TestWaitsForEveryQueue()
+{
+	auto device = std::make_shared<SimulatedResidencyDevice>(100);
+	ResidencyManager manager(device);
+
+	ResidencyManager::Handle a = manager.Track(nullptr, 100);
+	manager.MarkUsed(&a, 1, ResidencyManager::COPY_QUEUE, 3);
+	manager.MarkUsed(&a, 1, ResidencyManager::DIRECT_QUEUE, 7);
+
+	device->SetBudget(0);
+	CHECK(!manager.Trim(Completed(7, 2)));
+	CHECK(manager.IsResident(a));
+	CHECK(!manager.Trim(Completed(6, 3)));
+	CHECK(manager.IsResident(a));
+	CHECK(manager.Trim(Completed(7, 3)));
+	CHECK(!manager.IsResident(a));
+}
+
+// Memory used by objects that are not tracked, such as committed resources, is left out of the budget.
+static void TestLeavesRoomForUntrackedUsage()
+{
+	auto device = std::make_shared<SimulatedResidencyDevice>(300);
+	ResidencyManager manager(device);
+
+	ResidencyManager::Handle a = manager.Track(nullptr, 100);
+	ResidencyManager::Handle b = manager.Track(nullptr, 100);
+	manager.MarkUsed(&a, 1, ResidencyManager::DIRECT_QUEUE, 1);
+	manager.MarkUsed(&b, 1, ResidencyManager::DIRECT_QUEUE, 2);
+
+	// The usage includes the resident tracked objects.
+	device->SetUsage(350);
+	CHECK(manager.Trim(Completed(2, 0)));
+	CHECK(!manager.IsResident(a));
+	CHECK(manager.IsResident(b));
+
+	ResidencyManager::Stats stats = manager.GetStats();
+	CHECK(stats.untracked_bytes == 150);
+	CHECK(stats.resident_bytes == 100);
+
+	// Paging a back in needs room for it as well as the untracked objects, so b is evicted.
+	device->SetUsage(250);
+	CHECK(manager.MakeResident(&a, 1, Completed(2, 0)));
+	CHECK(manager.IsResident(a));
+	CHECK(!manager.IsResident(b));
+
+	// Usage below the resident tracked objects is not counted as negative.
+	device->SetUsage(0);
+	CHECK(manager.Trim(Completed(2, 0)));
+	CHECK(manager.GetStats().untracked_bytes == 0);
+}
+
+int main()
+{
+	TestEvictsLeastRecentlyUsed();
+	TestKeepsObjectsInUse();
+	TestKeepsObjectsInUseOnCopyQueue();
+	TestWaitsForEveryQueue();
+	TestLeavesRoomForUntrackedUsage();
+
+	return test_failure_count;
+}
@@ -0,0 +1,35 @@
+/**
+* Checks for the tests. A failed check is printed and counted, and main returns the count so
+* ctest reports the test as failed.
+*/
+#pragma once
+
+#include <cstdio>
+
+static int test_failure_count = 0;
+
+#define CHECK(arg_condition) \
+	do \
+	{ \
+		if (!(arg_condition)) \
+		{ \
+			std::printf("%s(%d): check failed: %s\n", __FILE__, __LINE__, #arg_condition); \
+			++test_failure_count; \
+		} \
+	} while (false)
+
+// Check that evaluating an expression throws.
+#define CHECK_THROWS(arg_expression) \
+	do \
+	{ \
+		bool thrown = false; \
+		try \
+		{ \
+			arg_expression; \
+		} \
+		catch (...) \
+		{ \
+			thrown = true; \
+		} \
+		CHECK(thrown && "Expected an exception: " #arg_expression); \
+	} while (false)
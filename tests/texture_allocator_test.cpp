@@ -0,0 +1,87 @@
+#include <texture_allocator.h>
+
+#include "test.h"
+
+#include <memory>
+
+static D3D12_RESOURCE_DESC TextureDesc(UINT64 arg_width, UINT arg_height)
+{
+	D3D12_RESOURCE_DESC desc = { };
+	desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	desc.Width = arg_width;
+	desc.Height = arg_height;
+	desc.DepthOrArraySize = 1;
+	desc.MipLevels = 1;
+	desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	desc.SampleDesc.Count = 1;
+
+	return desc;
+}
+
+// A failed placement must return its buddy block.
+static void TestFailedPlacementInBlock()
+{
+	auto device = std::make_shared<SimulatedHeapAllocatorDevice>();
+	// 1MB blocks.
+	TextureAllocator allocator(device, 4);
+
+	HeapAllocation first = allocator.CreateTexture(TextureDesc(128, 128), D3D12_RESOURCE_STATE_COPY_DEST);
+	CHECK(first.IsValid());
+
+	device->SetPlacementFails(true);
+	CHECK_THROWS(allocator.CreateTexture(TextureDesc(256, 256), D3D12_RESOURCE_STATE_COPY_DEST));
+	device->SetPlacementFails(false);
+
+	TextureAllocator::Stats stats = allocator.GetStats();
+	CHECK(stats.heap_count == 1);
+	CHECK(stats.allocation_count == 1);
+	CHECK(stats.free_bytes == 1024 * 1024 - 65536);
+
+	allocator.Free(first);
+	CHECK(allocator.GetStats().free_bytes == 1024 * 1024);
+}
+
+// A failed placement in a dedicated heap must release the heap and its residency entry.
+static void TestFailedPlacementInDedicatedHeap()
+{
+	auto device = std::make_shared<SimulatedHeapAllocatorDevice>();
+	ResidencyManager residency_manager(std::make_shared<SimulatedResidencyDevice>(UINT64_MAX));
+	TextureAllocator allocator(device, 4, &residency_manager);
+
+	device->SetPlacementFails(true);
+	CHECK_THROWS(allocator.CreateTexture(TextureDesc(1024, 1024), D3D12_RESOURCE_STATE_COPY_DEST));
+	device->SetPlacementFails(false);
+
+	CHECK(device->GetHeapCount() == 1);
+	CHECK(allocator.GetStats().heap_count == 0);
+	CHECK(residency_manager.GetStats().tracked_count == 0);
+}
+
+// A copy of a freed allocation must not refer to the dedicated heap that reuses its block slot.
+static void TestStaleAllocationAfterSlotReuse()
+{
+	auto device = std::make_shared<SimulatedHeapAllocatorDevice>();
+	TextureAllocator allocator(device, 2);
+
+	HeapAllocation first = allocator.CreateTexture(TextureDesc(1024, 1024), D3D12_RESOURCE_STATE_COPY_DEST);
+	HeapAllocation stale = first;
+	allocator.Free(first);
+	CHECK(!allocator.IsValid(stale));
+
+	HeapAllocation second = allocator.CreateTexture(TextureDesc(1024, 1024), D3D12_RESOURCE_STATE_COPY_DEST);
+	CHECK(second.block == stale.block);
+	CHECK(allocator.IsValid(second));
+	CHECK(!allocator.IsValid(stale));
+
+	allocator.Free(second);
+	CHECK(allocator.GetStats().heap_count == 0);
+}
+
+int main()
+{
+	TestFailedPlacementInBlock();
+	TestFailedPlacementInDedicatedHeap();
+	TestStaleAllocationAfterSlotReuse();
+
+	return test_failure_count;
+}
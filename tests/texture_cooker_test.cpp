@@ -0,0 +1,209 @@
+#include <texture_cooker.h>
+
+#include "test.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// An RGBA8 image of a single color.
+static std::vector<uint8_t> MakeFlatImage(uint32_t arg_width, uint32_t arg_height, const uint8_t arg_color[4])
+{
+	std::vector<uint8_t> pixels(size_t(arg_width) * arg_height * 4);
+	for (size_t i = 0; i < pixels.size(); i += 4)
+	{
+		memcpy(&pixels[i], arg_color, 4);
+	}
+	return pixels;
+}
+
+// Whether every pixel of every RGBA8 mip is within arg_tolerance of the color.
+static bool IsFlat(const CookedTexture& arg_texture, const uint8_t arg_color[4], int arg_tolerance)
+{
+	for (const CookedMip& mip : arg_texture.mips)
+	{
+		for (uint32_t y = 0; y < mip.height; ++y)
+		{
+			const uint8_t* row = arg_texture.data.data() + mip.offset + size_t(y) * mip.row_pitch;
+			for (uint32_t i = 0; i < mip.width * 4; ++i)
+			{
+				if (std::abs(int(row[i]) - int(arg_color[i % 4])) > arg_tolerance)
+				{
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+static void TestFullMipCount()
+{
+	CHECK(TextureCooker::GetFullMipCount(1, 1) == 1);
+	CHECK(TextureCooker::GetFullMipCount(256, 256) == 9);
+	CHECK(TextureCooker::GetFullMipCount(256, 64) == 9);
+	CHECK(TextureCooker::GetFullMipCount(64, 256) == 9);
+	CHECK(TextureCooker::GetFullMipCount(5, 3) == 3);
+	CHECK(TextureCooker::GetFullMipCount(7, 1) == 3);
+}
+
+// Odd sizes round down, and the mips are packed one after another.
+static void TestMipLayout()
+{
+	const uint8_t color[4] = { 10, 20, 30, 255 };
+	std::vector<uint8_t> pixels = MakeFlatImage(10, 3, color);
+
+	TextureCooker cooker;
+	CookedTexture texture = cooker.CookRGBA8(pixels.data(), 10, 3, 10 * 4);
+	CHECK(texture.format == DXGI_FORMAT_R8G8B8A8_UNORM);
+	CHECK(texture.mips.size() == 4);
+
+	const uint32_t widths[] = { 10, 5, 2, 1 };
+	const uint32_t heights[] = { 3, 1, 1, 1 };
+	uint64_t offset = 0;
+	for (uint32_t i = 0; i < texture.mips.size() && i < 4; ++i)
+	{
+		const CookedMip& mip = texture.mips[i];
+		CHECK(mip.width == widths[i]);
+		CHECK(mip.height == heights[i]);
+		CHECK(mip.row_pitch == widths[i] * 4);
+		CHECK(mip.row_count == heights[i]);
+		CHECK(mip.offset == offset);
+		CHECK(mip.size == uint64_t(mip.row_pitch) * mip.row_count);
+		offset += mip.size;
+	}
+	CHECK(texture.data.size() == offset);
+
+	D3D12_RESOURCE_DESC desc = texture.GetResourceDesc();
+	CHECK(desc.Width == 10);
+	CHECK(desc.Height == 3);
+	CHECK(desc.MipLevels == 4);
+
+	D3D12_SUBRESOURCE_DATA subresource_data = texture.GetSubresourceData(1);
+	CHECK(subresource_data.pData == texture.data.data() + texture.mips[1].offset);
+	CHECK(subresource_data.RowPitch == 5 * 4);
+	CHECK(subresource_data.SlicePitch == 5 * 4);
+
+	// A limited mip count cuts the chain short.
+	TextureCookSettings settings;
+	settings.mip_count = 2;
+	CHECK(TextureCooker(settings).CookRGBA8(pixels.data(), 10, 3, 10 * 4).mips.size() == 2);
+}
+
+// Both filters keep a flat image flat, including at the edges and on several threads.
+static void TestFiltersKeepFlatImageFlat()
+{
+	const uint8_t color[4] = { 100, 150, 200, 50 };
+	std::vector<uint8_t> pixels = MakeFlatImage(64, 48, color);
+
+	const float float_color[4] = { 0.25f, 0.5f, 0.75f, 1.0f };
+	std::vector<float> float_pixels(size_t(64) * 48 * 4);
+	for (size_t i = 0; i < float_pixels.size(); ++i)
+	{
+		float_pixels[i] = float_color[i % 4];
+	}
+
+	for (MipFilter filter : { MipFilter::Box, MipFilter::Kaiser })
+	{
+		TextureCookSettings settings;
+		settings.filter = filter;
+		settings.thread_count = 4;
+		TextureCooker cooker(settings);
+
+		CookedTexture texture = cooker.CookRGBA8(pixels.data(), 64, 48, 64 * 4);
+		CHECK(texture.mips.size() == 7);
+		CHECK(IsFlat(texture, color, 0));
+
+		CookedTexture float_texture = cooker.CookFloat(float_pixels.data(), 64, 48, 64 * 16);
+		CHECK(float_texture.format == DXGI_FORMAT_R32G32B32A32_FLOAT);
+		bool flat = true;
+		for (const CookedMip& mip : float_texture.mips)
+		{
+			const float* values = reinterpret_cast<const float*>(float_texture.data.data() + mip.offset);
+			for (size_t i = 0; i < size_t(mip.width) * mip.height * 4; ++i)
+			{
+				flat = flat && std::abs(values[i] - float_color[i % 4]) < 1e-5f;
+			}
+		}
+		CHECK(flat);
+	}
+}
+
+// sRGB colors are decoded before filtering and encoded after, so a flat color comes back unchanged.
+static void TestSrgbRoundTrip()
+{
+	const uint8_t colors[][4] = { { 5, 50, 128, 77 }, { 200, 230, 255, 0 } };
+	for (const uint8_t (&color)[4] : colors)
+	{
+		std::vector<uint8_t> pixels = MakeFlatImage(16, 16, color);
+
+		TextureCookSettings settings;
+		settings.srgb = true;
+		CookedTexture texture = TextureCooker(settings).CookRGBA8(pixels.data(), 16, 16, 16 * 4);
+		CHECK(texture.srgb);
+		CHECK(IsFlat(texture, color, 1));
+	}
+}
+
+// Textures are compressed whole, so their size must be a multiple of the block size.
+static void TestCompressRejectsPartialBlocks()
+{
+	const uint8_t color[4] = { 1, 2, 3, 4 };
+	std::vector<uint8_t> pixels = MakeFlatImage(6, 4, color);
+
+	TextureCookSettings settings;
+	settings.compress = true;
+	TextureCooker cooker(settings);
+	CHECK_THROWS(cooker.CookRGBA8(pixels.data(), 6, 4, 6 * 4));
+	CHECK_THROWS(cooker.CookRGBA8(pixels.data(), 4, 6, 4 * 4));
+
+	const float float_pixels[4 * 4 * 4] = { };
+	CHECK_THROWS(cooker.CookFloat(float_pixels, 4, 4, 4 * 16));
+}
+
+// Mips smaller than a block still take a whole block.
+static void TestSmallCompressedMips()
+{
+	const uint8_t color[4] = { 40, 80, 120, 255 };
+	std::vector<uint8_t> pixels = MakeFlatImage(16, 8, color);
+
+	const BlockFormat formats[] = { BlockFormat::BC1, BlockFormat::BC7 };
+	const DXGI_FORMAT dxgi_formats[] = { DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC7_UNORM };
+	const uint32_t block_sizes[] = { 8, 16 };
+	for (uint32_t i = 0; i < 2; ++i)
+	{
+		TextureCookSettings settings;
+		settings.compress = true;
+		settings.block_format = formats[i];
+		CookedTexture texture = TextureCooker(settings).CookRGBA8(pixels.data(), 16, 8, 16 * 4);
+		CHECK(texture.format == dxgi_formats[i]);
+		CHECK(texture.mips.size() == 5);
+
+		const uint32_t widths[] = { 16, 8, 4, 2, 1 };
+		const uint32_t heights[] = { 8, 4, 2, 1, 1 };
+		const uint32_t rows[] = { 2, 1, 1, 1, 1 };
+		uint64_t offset = 0;
+		for (uint32_t mip = 0; mip < texture.mips.size() && mip < 5; ++mip)
+		{
+			CHECK(texture.mips[mip].width == widths[mip]);
+			CHECK(texture.mips[mip].height == heights[mip]);
+			CHECK(texture.mips[mip].row_pitch == (widths[mip] + 3) / 4 * block_sizes[i]);
+			CHECK(texture.mips[mip].row_count == rows[mip]);
+			CHECK(texture.mips[mip].offset == offset);
+			offset += texture.mips[mip].size;
+		}
+		CHECK(texture.data.size() == offset);
+	}
+}
+
+int main()
+{
+	TestFullMipCount();
+	TestMipLayout();
+	TestFiltersKeepFlatImageFlat();
+	TestSrgbRoundTrip();
+	TestCompressRejectsPartialBlocks();
+	TestSmallCompressedMips();
+
+	return test_failure_count;
+}
@@ -0,0 +1,79 @@
+#include <transient_resource_pool.h>
+
+#include "test.h"
+
+#include <memory>
+#include <vector>
+
+// The simulated device sizes a texture at 4 bytes per texel, aligned to 64KB.
+static D3D12_RESOURCE_DESC TextureDesc(UINT64 arg_width, UINT arg_height, D3D12_RESOURCE_FLAGS arg_flags)
+{
+	D3D12_RESOURCE_DESC desc = { };
+	desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	desc.Width = arg_width;
+	desc.Height = arg_height;
+	desc.DepthOrArraySize = 1;
+	desc.MipLevels = 1;
+	desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	desc.SampleDesc.Count = 1;
+	desc.Flags = arg_flags;
+
+	return desc;
+}
+
+// Resources whose passes do not overlap are placed at the same offset, the others apart.
+static void TestNonOverlappingPassesShareMemory()
+{
+	auto device = std::make_shared<SimulatedHeapAllocatorDevice>();
+	TransientResourcePool pool(device);
+
+	D3D12_RESOURCE_DESC target_desc = TextureDesc(256, 256, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
+	D3D12_RESOURCE_DESC depth_desc = TextureDesc(128, 128, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL);
+	TransientResourcePool::Handle first = pool.Declare(target_desc, D3D12_RESOURCE_STATE_RENDER_TARGET, nullptr, 0, 1);
+	TransientResourcePool::Handle second = pool.Declare(target_desc, D3D12_RESOURCE_STATE_RENDER_TARGET, nullptr, 2, 3);
+	TransientResourcePool::Handle depth = pool.Declare(depth_desc, D3D12_RESOURCE_STATE_COMMON, nullptr, 1, 2);
+
+	std::vector<Microsoft::WRL::ComPtr<ID3D12Object>> retired_objects;
+	pool.Compile(retired_objects);
+
+	CHECK(pool.GetHeapOffset(first) == pool.GetHeapOffset(second));
+	CHECK(pool.GetHeapOffset(depth) == 256 * 256 * 4);
+	CHECK(device->GetHeapCount() == 1);
+	CHECK(device->GetPlacedCount() == 3);
+
+	TransientResourcePool::Stats stats = pool.GetStats();
+	CHECK(stats.resource_count == 3);
+	CHECK(stats.unaliased_size == 2 * 256 * 256 * 4 + 128 * 128 * 4);
+}
+
+// Declaring the resources again keeps the heap unless they no longer fit.
+static void TestHeapOnlyGrows()
+{
+	auto device = std::make_shared<SimulatedHeapAllocatorDevice>();
+	TransientResourcePool pool(device);
+
+	std::vector<Microsoft::WRL::ComPtr<ID3D12Object>> retired_objects;
+	pool.Declare(TextureDesc(1024, 1024, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL), D3D12_RESOURCE_STATE_COMMON, nullptr, 0, 0);
+	pool.Compile(retired_objects);
+	UINT64 heap_size = pool.GetStats().heap_size;
+
+	pool.Clear();
+	pool.Declare(TextureDesc(512, 512, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL), D3D12_RESOURCE_STATE_COMMON, nullptr, 0, 0);
+	pool.Compile(retired_objects);
+	CHECK(device->GetHeapCount() == 1);
+	CHECK(pool.GetStats().heap_size == heap_size);
+
+	pool.Clear();
+	pool.Declare(TextureDesc(2048, 2048, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL), D3D12_RESOURCE_STATE_COMMON, nullptr, 0, 0);
+	pool.Compile(retired_objects);
+	CHECK(device->GetHeapCount() == 2);
+	CHECK(pool.GetStats().heap_size >= 2048 * 2048 * 4);
+}
+
+int main()
+{
+	TestNonOverlappingPassesShareMemory();
+	TestHeapOnlyGrows();
+
+	return test_failure_count;
+}
@@ -0,0 +1,59 @@
+/**
+* Declarations of the Windows SDK used by the units under test, so they build on platforms
+* without the SDK. Only types and constants are provided; the COM interfaces are declared
+* but never implemented, because the tests run against the simulated devices.
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+typedef int32_t HRESULT;
+typedef unsigned char BYTE;
+typedef int BOOL;
+typedef unsigned int UINT;
+typedef uint8_t UINT8;
+typedef uint16_t UINT16;
+typedef uint32_t UINT32;
+typedef uint64_t UINT64;
+typedef unsigned long ULONG;
+typedef intptr_t LONG_PTR;
+typedef uintptr_t SIZE_T;
+typedef const char* LPCSTR;
+
+#define FALSE 0
+#define TRUE 1
+
+#define S_OK ((HRESULT)0L)
+#define E_FAIL ((HRESULT)0x80004005L)
+#define E_INVALIDARG ((HRESULT)0x80070057L)
+#define E_OUTOFMEMORY ((HRESULT)0x8007000EL)
+
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+
+struct GUID
+{
+	uint32_t Data1;
+	uint16_t Data2;
+	uint16_t Data3;
+	uint8_t Data4[8];
+};
+typedef GUID IID;
+typedef const IID& REFIID;
+
+#define __uuidof(x) IID{}
+#define IID_PPV_ARGS(pp) __uuidof(**(pp)), reinterpret_cast<void**>(pp)
+
+struct IUnknown
+{
+	virtual HRESULT QueryInterface(REFIID riid, void** ppvObject) = 0;
+	virtual ULONG AddRef() = 0;
+	virtual ULONG Release() = 0;
+};
+
+template<size_t size, typename... Args>
+inline int sprintf_s(char (&buffer)[size], const char* format, Args... args)
+{
+	return snprintf(buffer, size, format, args...);
+}
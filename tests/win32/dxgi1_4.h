@@ -0,0 +1,26 @@
+// The DXGI 1.4 declarations used by the units under test, see Windows.h.
+#pragma once
+
+#include <dxgi.h>
+
+enum DXGI_MEMORY_SEGMENT_GROUP
+{
+	DXGI_MEMORY_SEGMENT_GROUP_LOCAL = 0,
+	DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL = 1
+};
+
+struct DXGI_QUERY_VIDEO_MEMORY_INFO
+{
+	UINT64 Budget;
+	UINT64 CurrentUsage;
+	UINT64 AvailableForReservation;
+	UINT64 CurrentReservation;
+};
+
+struct IDXGIAdapter2 : public IDXGIAdapter1 { };
+
+struct IDXGIAdapter3 : public IDXGIAdapter2
+{
+	virtual HRESULT QueryVideoMemoryInfo(UINT NodeIndex, DXGI_MEMORY_SEGMENT_GROUP MemorySegmentGroup,
+										 DXGI_QUERY_VIDEO_MEMORY_INFO* pVideoMemoryInfo) = 0;
+};
@@ -0,0 +1,72 @@
+// Microsoft::WRL::ComPtr for the units under test, see Windows.h.
+#pragma once
+
+#include <Windows.h>
+
+#include <cstddef>
+
+namespace Microsoft
+{
+namespace WRL
+{
+	template<typename T>
+	class ComPtr
+	{
+	public:
+		ComPtr() : ptr_(nullptr) { }
+		ComPtr(std::nullptr_t) : ptr_(nullptr) { }
+		ComPtr(T* arg_ptr) : ptr_(arg_ptr) { AddRef(); }
+		ComPtr(const ComPtr& arg_other) : ptr_(arg_other.ptr_) { AddRef(); }
+		ComPtr(ComPtr&& arg_other) : ptr_(arg_other.ptr_) { arg_other.ptr_ = nullptr; }
+		// Conversions from pointers to derived interfaces.
+		template<typename U>
+		ComPtr(const ComPtr<U>& arg_other) : ptr_(arg_other.Get()) { AddRef(); }
+		template<typename U>
+		ComPtr(ComPtr<U>&& arg_other) : ptr_(arg_other.Detach()) { }
+		~ComPtr() { Reset(); }
+
+		ComPtr& operator=(ComPtr arg_other)
+		{
+			T* ptr = ptr_;
+			ptr_ = arg_other.ptr_;
+			arg_other.ptr_ = ptr;
+			return *this;
+		}
+
+		T* Get() const { return ptr_; }
+		T* operator->() const { return ptr_; }
+		T& operator*() const { return *ptr_; }
+		explicit operator bool() const { return ptr_ != nullptr; }
+
+		T* const* GetAddressOf() const { return &ptr_; }
+		T** GetAddressOf() { return &ptr_; }
+
+		T* Detach()
+		{
+			T* ptr = ptr_;
+			ptr_ = nullptr;
+			return ptr;
+		}
+
+		void Reset()
+		{
+			if (ptr_)
+			{
+				ptr_->Release();
+				ptr_ = nullptr;
+			}
+		}
+
+	private:
+		void AddRef()
+		{
+			if (ptr_)
+			{
+				ptr_->AddRef();
+			}
+		}
+
+		T* ptr_;
+	};
+}
+}